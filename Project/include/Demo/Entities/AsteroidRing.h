@@ -38,7 +38,7 @@ public:
 	void SetRotationSpeed(float speed) { rotationSpeed = speed; }
 private:
 	void ProvideRenderables(std::vector<Renderable>& outRenderables) override;
-	void UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) override;
+	bool UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) override;
 	void UpdateTransform(const glm::mat4& newTransform) override;
 
 	std::vector<AsteroidInstanceData> asteroidLocals;
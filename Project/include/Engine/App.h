@@ -12,6 +12,7 @@ class Scene;
 
 #define WINDOW_WIDTH 1000
 #define WINDOW_HEIGHT 1000
+#define LOADING_UPLOAD_BUDGET_MS 12.0	// GL uploads per loading screen frame
 
 class App
 {
@@ -23,6 +24,7 @@ public:
 	double DeltaTime() const { return deltaTime; }
 
 	void RunLoop();
+	void RenderLoop();
 	void EventLoop();
 	void Run();
 
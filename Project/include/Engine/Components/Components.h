@@ -11,6 +11,7 @@
 #include "TransformComponent.h"
 #include "CameraComponent.h"
 #include "LightComponent.h"
+#include "PointLightComponent.h"
 #include "RenderableComponent.h"
 #include "RigidBodyComponent.h"
 #include "ColliderComponent.h"
@@ -0,0 +1,11 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// A point light at the entity's world position, binned into the light clusters every frame.
+// Unlike the scene's Light it does not cast shadows
+struct PointLightComponent
+{
+	glm::vec3 color{ 1.0f, 1.0f, 1.0f };
+	float intensity = 1.0f;
+	float radius = 10.0f; // the light fades out to nothing at this distance
+};
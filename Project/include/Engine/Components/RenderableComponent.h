@@ -1,5 +1,6 @@
 #pragma once
 #include "Engine/Renderer/Renderable.h"
+#include "Engine/Renderer/RenderWorld.h"
 #include <functional>
 #include <glm/glm.hpp>
 
@@ -7,11 +8,18 @@ struct RenderableComponent
 {
 	std::vector<Renderable> renderables;
 	std::function<void(std::vector<Renderable>&)> RenderableGenerator;
-	std::function<void(double deltaTime, std::vector<Renderable>&)> RenderableUpdater;
+	// returns true if it changed the renderables, so their proxies get refreshed
+	// runs on a worker thread, so it must only touch its own entity
+	std::function<bool(double deltaTime, std::vector<Renderable>&)> RenderableUpdater;
 	std::function<void(const glm::mat4&)> OnTransformUpdated;
 
 	bool isGenerated = false;
 
+	// proxies of the renderables in the Renderer's RenderWorld, synced by the RenderSystem
+	std::vector<RenderWorld::ProxyHandle> proxies;
+	bool transformDirty = false;	// model matrices or renderable count changed
+	bool propertiesDirty = false;	// anything else changed
+
 	const std::vector<Renderable>& GetRenderables()
 	{
 		if (RenderableGenerator && !isGenerated)
@@ -19,15 +27,16 @@ struct RenderableComponent
 			renderables.clear();
 			RenderableGenerator(renderables);
 			isGenerated = true;
+			propertiesDirty = true;
 		}
 		return renderables;
 	}
 
 	void UpdateRenderables(double deltaTime)
 	{
-		if (RenderableUpdater)
+		if (RenderableUpdater && RenderableUpdater(deltaTime, renderables))
 		{
-			RenderableUpdater(deltaTime, renderables);
+			transformDirty = true;
 		}
 	}
 
@@ -37,11 +46,13 @@ struct RenderableComponent
 		{
 			OnTransformUpdated(newTransform);
 		}
+		transformDirty = true;
 	}
 
 	void UpdateZOrder(uint16_t newZOrder) {
 		for (auto& renderable : renderables) {
 			renderable.zOrder = newZOrder;
 		}
+		propertiesDirty = true;
 	}
 };
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+
+// =========================================================
+// HeadlessRenderStats
+//
+// Records the frames of a synthetic scene through the RenderQueue, BatchBuilder and
+// FrameRecorder into a NullRenderBackend, and prints what they would have drawn.
+// Resources are registered without being uploaded, so it runs without a window or GL context
+// ("--render-stats <scene>"). Every scene is recorded twice, the command streams must match,
+// and once warm the frames must not allocate (see AllocationCounter).
+// =========================================================
+class HeadlessRenderStats
+{
+public:
+	// returns the process exit code, non zero for an unknown scene, streams that differ between runs or warm frames that allocate
+	static int Run(const std::string& sceneName);
+};
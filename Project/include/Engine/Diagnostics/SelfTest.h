@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+// =========================================================
+// SelfTest
+//
+// Checks of the CPU side rendering code against known inputs, run without
+// a window or GL context ("--selftest"). Every SIMD path is checked against the same expectations.
+// =========================================================
+class SelfTest
+{
+public:
+	// runs every check, prints the failed ones, returns the process exit code
+	static int Run();
+private:
+	static void TestOcclusionBuffer();
+	static void TestLightClusters();
+
+	static void Check(bool passed, const std::string& what);
+	static int checks;
+	static int failures;
+};
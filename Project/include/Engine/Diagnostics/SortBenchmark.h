@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+// =========================================================
+// SortBenchmark
+//
+// Times the render queue's RadixSort of (key, index) pairs against std::sort of whole
+// RenderSubmissions on synthetic opaque lists, and checks both orders agree.
+// Runs without a window or GL context ("--bench-sort").
+// =========================================================
+class SortBenchmark
+{
+public:
+	// returns the process exit code, non zero if an order did not match
+	static int Run();
+private:
+	// best of `repeats` runs for each sort, prints one result line
+	static bool RunSize(size_t count, int repeats);
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "Profiler.h"
+
+#include <atomic>
+#include <cstdint>
+
+// set to 0 to keep the standard global operator new, nothing is counted then
+#ifndef ENGINE_COUNT_ALLOCATIONS
+#define ENGINE_COUNT_ALLOCATIONS ENGINE_PROFILING
+#endif
+
+// =========================================================
+// AllocationCounter
+//
+// Counts the heap allocations done through the global operator new by the threads it is current on.
+// An AllocationScope makes a counter current on its thread, and the WorkerPool makes the submitter's
+// counter current on the workers running its chunks, so parallel work is counted with the scope that started it.
+// =========================================================
+class AllocationCounter
+{
+public:
+	static constexpr bool IsEnabled() { return ENGINE_COUNT_ALLOCATIONS != 0; }
+
+	// counter of the calling thread, nullptr outside every scope
+	static AllocationCounter* GetCurrent();
+	static void SetCurrent(AllocationCounter* counter);
+
+	// called by operator new on the thread allocating
+	static void CountCurrent();
+
+	uint64_t Get() const { return count.load(std::memory_order_relaxed); }
+	// returns the count and starts again from 0
+	uint64_t Take() { return count.exchange(0, std::memory_order_relaxed); }
+private:
+	std::atomic<uint64_t> count{ 0 };
+};
+
+// =========================================================
+// AllocationScope
+//
+// Makes a counter current on the calling thread for its lifetime.
+// =========================================================
+class AllocationScope
+{
+public:
+	explicit AllocationScope(AllocationCounter& counter) : previous(AllocationCounter::GetCurrent()) { AllocationCounter::SetCurrent(&counter); }
+	~AllocationScope() { AllocationCounter::SetCurrent(previous); }
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope& operator=(const AllocationScope&) = delete;
+private:
+	AllocationCounter* previous;
+};
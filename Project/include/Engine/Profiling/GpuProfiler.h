@@ -0,0 +1,79 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "Profiler.h"
+
+#define PROFILER_GPU_QUERY_FRAMES 4		// frames a query is given to finish before its result is read
+#define PROFILER_GPU_MAX_SCOPES 32		// GPU scopes per frame, later ones are not timed
+
+// =========================================================
+// GpuProfiler
+//
+// Times GPU work with GL_TIME_ELAPSED queries kept in a ring of PROFILER_GPU_QUERY_FRAMES frames.
+// Results are read back PROFILER_GPU_QUERY_FRAMES - 1 frames later and only if they are available,
+// so the CPU never waits on the GPU; a late result is dropped instead.
+// Elapsed queries cannot nest, a scope opened inside another one is not timed on the GPU.
+// Render thread only, needs the GL context.
+// =========================================================
+class GpuProfiler
+{
+public:
+	GpuProfiler() = default;
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// reports the finished queries of the oldest frame in the ring and starts recording the next one
+	void BeginFrame();
+
+	// returns false if the scope is not timed
+	bool BeginScope(const char* name);
+	void EndScope();
+private:
+	struct TimedScope
+	{
+		const char* name;
+		uint64_t cpuStart;	// places the GPU time next to the CPU scope in the trace
+	};
+	struct FrameQueries
+	{
+		GLuint queries[PROFILER_GPU_MAX_SCOPES] = {};
+		TimedScope scopes[PROFILER_GPU_MAX_SCOPES] = {};
+		uint32_t count = 0;
+	};
+
+	FrameQueries frames[PROFILER_GPU_QUERY_FRAMES];
+	uint32_t frameIndex = 0;
+	bool initialized = false;
+	bool scopeOpen = false;
+
+	void CollectResults(FrameQueries& frameQueries);
+};
+
+// =========================================================
+// GpuProfileScope
+//
+// Times its own lifetime on the GPU, created by PROFILE_GPU_SCOPE.
+// =========================================================
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler& profiler, const char* name) : profiler(profiler), timed(profiler.BeginScope(name)) {}
+	~GpuProfileScope() { if (timed) profiler.EndScope(); }
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+private:
+	GpuProfiler& profiler;
+	bool timed;
+};
+
+#if ENGINE_PROFILING
+// times the enclosing scope on the CPU and the GPU, name must be a string literal
+#define PROFILE_GPU_SCOPE(gpuProfiler, name) \
+	PROFILE_SCOPE(name); \
+	GpuProfileScope PROFILER_CONCAT(gpuProfileScope_, __LINE__)(gpuProfiler, name)
+#else
+#define PROFILE_GPU_SCOPE(gpuProfiler, name)
+#endif
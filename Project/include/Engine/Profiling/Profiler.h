@@ -0,0 +1,147 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// set to 0 to compile every profiling scope out, the macros then expand to nothing
+#ifndef ENGINE_PROFILING
+#define ENGINE_PROFILING 1
+#endif
+
+#define PROFILER_AVERAGE_FRAMES 60			// frames the rolling averages cover
+#define PROFILER_MAX_CAPTURE_EVENTS 1000000	// a capture stops recording past this
+#define PROFILER_TRACE_FILE "profile_trace.json"
+
+// =========================================================
+// ProfileEvent
+//
+// One closed scope, times in nanoseconds since the profiler started.
+// =========================================================
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+	uint32_t thread;
+	bool gpu;
+};
+
+// =========================================================
+// ScopeAverage
+// =========================================================
+struct ScopeAverage
+{
+	const char* name;
+	std::string thread;
+	bool gpu;
+	double averageMs;	// per frame, over the last PROFILER_AVERAGE_FRAMES frames
+	double maxMs;		// slowest frame in the same window
+};
+
+// =========================================================
+// Profiler
+//
+// Collects timed scopes from any thread, see the PROFILE_* macros.
+// Every scope feeds rolling per-frame averages, and while a capture is running
+// it is also kept as an event for the Chrome trace export (chrome://tracing, Perfetto).
+// Scope names must outlive the profiler, use Intern for names built at runtime.
+// =========================================================
+class Profiler
+{
+public:
+	static Profiler& Get();
+
+	// nanoseconds since the profiler was created
+	uint64_t Now() const;
+
+	// names the calling thread in the averages and traces
+	void SetThreadName(const char* name);
+	// stable copy of a name built at runtime
+	const char* Intern(const std::string& name);
+
+	void Record(const char* name, uint64_t start, uint64_t duration, bool gpu = false);
+
+	// closes a frame of the rolling averages
+	void EndFrame();
+	std::vector<ScopeAverage> GetAverages() const;
+	void PrintAverages() const;
+
+	void BeginCapture();
+	// stops the capture and writes it as Chrome trace JSON, returns false if the file could not be written
+	bool EndCapture(const std::string& path = PROFILER_TRACE_FILE);
+	bool IsCapturing() const { return capturing; }
+private:
+	Profiler();
+
+	struct ScopeKey
+	{
+		const char* name;
+		uint32_t thread;
+		bool gpu;
+		bool operator==(const ScopeKey& other) const { return name == other.name && thread == other.thread && gpu == other.gpu; }
+	};
+	struct ScopeKeyHash
+	{
+		size_t operator()(const ScopeKey& key) const { return std::hash<const void*>()(key.name) ^ (size_t(key.thread) << 1) ^ size_t(key.gpu); }
+	};
+	struct ScopeHistory
+	{
+		uint64_t frameTotal = 0;					// time spent in the scope during the open frame
+		uint64_t frames[PROFILER_AVERAGE_FRAMES] = {};
+	};
+
+	uint64_t epoch;
+
+	mutable std::mutex mutex;
+	std::unordered_map<ScopeKey, ScopeHistory, ScopeKeyHash> scopes;
+	uint32_t frameCursor = 0;
+	uint32_t framesRecorded = 0;
+
+	std::vector<std::string> threadNames;	// indexed by thread id
+	std::unordered_set<std::string> internedNames;
+
+	std::atomic<bool> capturing = false;
+	std::vector<ProfileEvent> captured;
+
+	uint32_t GetThreadId();
+	bool WriteChromeTrace(const std::string& path) const;
+};
+
+// =========================================================
+// ProfileScope
+//
+// Times its own lifetime, created by PROFILE_SCOPE.
+// =========================================================
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : name(name), start(Profiler::Get().Now()) {}
+	~ProfileScope() { Profiler& profiler = Profiler::Get(); profiler.Record(name, start, profiler.Now() - start); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#if ENGINE_PROFILING
+// times the enclosing scope, name must be a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope_, __LINE__)(name)
+// same for names built at runtime, the expression is only evaluated when profiling is compiled in
+#define PROFILE_SCOPE_DYNAMIC(nameExpression) ProfileScope PROFILER_CONCAT(profileScope_, __LINE__)(Profiler::Get().Intern(nameExpression))
+#define PROFILE_THREAD(name) Profiler::Get().SetThreadName(name)
+#define PROFILE_END_FRAME() Profiler::Get().EndFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_SCOPE_DYNAMIC(nameExpression)
+#define PROFILE_THREAD(name)
+#define PROFILE_END_FRAME()
+#endif
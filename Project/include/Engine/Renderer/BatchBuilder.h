@@ -1,16 +1,44 @@
 #pragma once
 #include "Renderable.h"
+#include "InstanceAllocator.h"
+#include "RadixSort.h"
 
 #include <vector>
 
+// =========================================================
+// InstanceBlock
+//
+// Instance memory reserved for one sorted list.
+// =========================================================
+struct InstanceBlock
+{
+	uint8_t* data = nullptr;
+	uint32_t baseInstance = 0;
+};
+
+// =========================================================
+// BatchBuilder
+//
+// Turns sorted submission lists into instanced batches.
+// Reserve touches the shared instance memory and frame arena, so it runs on one thread,
+// Build only writes to its own block and list, so lists can be built in parallel.
+// =========================================================
 class BatchBuilder
 {
 public:
-	// trashes sorted vector
-	// this shouldn't matter, as the RenderQueue shouldn't need the old unbatched data
-	static std::vector<RenderSubmission> Build(std::vector<RenderSubmission>& sorted);
+	// reserves room in the instance memory for `instanceCount` instances, and in outBatched for up to `maxBatches` batches
+	static InstanceBlock Reserve(uint32_t instanceCount, size_t maxBatches, IInstanceAllocator& instances, InstanceLayout layout, RenderList& outBatched);
+	// walks the main pass submissions in sorted order, writes their instance data into the block
+	// and appends submissions with equal sort keys as instanced batches to outBatched
+	static void Build(const RenderList& submissions, const SortList& order, const InstanceBlock& block, InstanceLayout layout, RenderList& outBatched);
+	// same for the static or the dynamic shadow casters, writing one instance per shadow map layer they overlap
+	static void BuildShadow(const RenderList& submissions, const SortList& order, bool staticCasters, const InstanceBlock& block, RenderList& outBatched);
 private:
-	static void InitInstanceData(RenderSubmission& cmd);
-	static void AppendInstanceData(RenderSubmission& batch, const Renderable& r);
+	static void WriteInstance(uint8_t* dst, const RenderSubmission& submission, InstanceLayout layout);
+	// main pass matrix of a submission, impostors get their quad frame folded in
+	static glm::mat4 GetInstanceMatrix(const RenderSubmission& submission);
+	// model matrix with the position decode of quantized meshes folded in
+	static glm::mat4 GetInstanceMatrix(const glm::mat4& modelMatrix, MeshManager::Handle mesh);
+	// starts a new batch if the key differs from the last one appended since firstBatch
+	static RenderSubmission& GetBatch(const RenderSubmission& next, size_t firstBatch, RenderList& outBatched);
 };
-
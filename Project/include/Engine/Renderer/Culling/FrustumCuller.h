@@ -0,0 +1,58 @@
+#pragma once
+#include "Frustum.h"
+
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+
+// =========================================================
+// CullingBoundsSoA
+//
+// World space AABBs stored as center/extent in structure-of-arrays form,
+// so the culler can load several objects per register.
+// =========================================================
+struct CullingBoundsSoA
+{
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	size_t Size() const { return centerX.size(); }
+
+	void Resize(size_t size);
+	void Set(size_t index, const BoundingBox& box);
+	// bounds that pass every plane, for objects without a bounding box
+	void SetUnbounded(size_t index);
+	// moves the last entry into index and shrinks by one
+	void SwapRemove(size_t index);
+	void Clear();
+};
+
+// =========================================================
+// FrustumCuller
+//
+// Batch frustum test over CullingBoundsSoA, producing one visibility bit per object.
+// The widest supported instruction set is picked at runtime, the scalar path
+// is used on other CPUs and for the remainder of every batch.
+// =========================================================
+enum class CullingPath : uint8_t
+{
+	Scalar,
+	SSE,	// 4 objects per iteration
+	AVX,	// 8 objects per iteration
+};
+
+// detected once, the widest path the CPU and OS support
+CullingPath GetDefaultCullingPath();
+const char* GetCullingPathName(CullingPath path);
+
+// bit (i & 31) of outVisibility[i >> 5] is set if object i intersects the frustum
+void CullBounds(const Frustum& frustum, const CullingBoundsSoA& bounds, std::pmr::vector<uint32_t>& outVisibility);
+void CullBounds(const Frustum& frustum, const CullingBoundsSoA& bounds, std::pmr::vector<uint32_t>& outVisibility, CullingPath path);
+// Culls objects [begin, end) only, so ranges can be culled on different threads.
+// begin must be a multiple of 32 and the words covering the range must already be zeroed.
+void CullBoundsRange(const Frustum& frustum, const CullingBoundsSoA& bounds, size_t begin, size_t end, uint32_t* outVisibility, CullingPath path = GetDefaultCullingPath());
+
+inline bool IsVisible(const std::pmr::vector<uint32_t>& visibility, size_t index)
+{
+	return (visibility[index >> 5] >> (index & 31)) & 1u;
+}
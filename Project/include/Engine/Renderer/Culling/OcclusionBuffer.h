@@ -0,0 +1,74 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "FrustumCuller.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define OCCLUSION_BUFFER_WIDTH 256
+#define OCCLUSION_BUFFER_HEIGHT 128
+#define OCCLUSION_TILE_SIZE 8 // pixels per side of a hierarchy tile
+
+// forward declarations
+struct Mesh;
+
+// =========================================================
+// OcclusionBuffer
+//
+// Low resolution CPU depth buffer used for software occlusion culling.
+// A few large occluders are rasterized into it every frame, then the AABBs of the
+// other objects are tested against it, first per tile then per pixel.
+// Depth is stored in [0, 1], 1 being the far plane, and each pixel keeps the nearest occluder.
+// The test is conservative: anything it can not prove hidden is reported as visible.
+// =========================================================
+class OcclusionBuffer
+{
+public:
+	// width must be a multiple of 4, both a multiple of OCCLUSION_TILE_SIZE
+	OcclusionBuffer(uint32_t width = OCCLUSION_BUFFER_WIDTH, uint32_t height = OCCLUSION_BUFFER_HEIGHT);
+
+	// clears the buffer to the far plane and sets the camera of the frame
+	void Begin(const glm::mat4& projectionView);
+
+	// rasterizes the triangles of a mesh, using its CPU copy of the vertex positions (attribute 0)
+	void RasterizeMesh(const Mesh& mesh, const glm::mat4& modelMatrix);
+	// rasterizes indexed triangles whose positions are found at positionOffset in every vertex,
+	// float3 or, when quantized, unorm16x3 that modelMatrix decodes
+	void RasterizeTriangles(const uint8_t* vertexData, uint32_t vertexStride, uint32_t positionOffset, uint32_t vertexCount,
+		const uint32_t* indices, size_t indexCount, const glm::mat4& modelMatrix, bool quantized = false);
+
+	// builds the per tile farthest depth, call once all occluders were rasterized
+	void Finish();
+
+	// true if any part of the box may be in front of the occluders, thread safe after Finish
+	bool IsVisible(const BoundingBox& worldBounds) const;
+
+	// false until an occluder wrote at least one pixel this frame, nothing can be hidden before that
+	bool HasOccluders() const { return hasOccluders; }
+
+	// rasterization loop, SSE covers 4 pixels per iteration (AVX falls back to it), Scalar one.
+	// Both fill the same pixels, defaults to GetDefaultCullingPath
+	void SetRasterPath(CullingPath path) { rasterPath = path; }
+	CullingPath GetRasterPath() const { return rasterPath; }
+
+	uint32_t GetWidth() const { return width; }
+	uint32_t GetHeight() const { return height; }
+	float GetDepth(uint32_t x, uint32_t y) const { return depth[y * width + x]; }
+private:
+	uint32_t width, height;
+	uint32_t tilesX, tilesY;
+
+	glm::mat4 projectionView = glm::mat4(1.f);
+	bool hasOccluders = false;
+	CullingPath rasterPath = GetDefaultCullingPath();
+
+	std::vector<float> depth;
+	std::vector<float> tileMaxDepth; // farthest depth of every tile
+
+	// clip space positions of the mesh being rasterized, reused between meshes
+	std::vector<glm::vec4> clipPositions;
+
+	void RasterizeTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+};
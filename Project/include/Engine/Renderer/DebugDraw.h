@@ -0,0 +1,73 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Culling/BoundingBox.h"
+
+#include <vector>
+#include <cstdint>
+
+#define DEBUG_DRAW_SHADER_NAME "debugLine"
+#define DEBUG_DRAW_INITIAL_VERTICES 4096
+#define DEBUG_DRAW_SPHERE_SEGMENTS 24
+
+// forward declarations
+struct GLStateCache;
+
+// =========================================================
+// DebugVertex
+//
+// Line vertex of the debug draw, color packed as RGBA8.
+// =========================================================
+struct DebugVertex
+{
+	glm::vec3 position;
+	uint32_t color;
+};
+
+// =========================================================
+// DebugDraw
+//
+// Immediate mode debug lines. Shapes are appended as line vertices on the game thread,
+// handed over with the frame's RenderSnapshot, then uploaded to one streaming buffer
+// and drawn with a single draw call on the render thread.
+// While disabled every Add call returns right away, so debug views cost nothing when off.
+// =========================================================
+class DebugDraw
+{
+public:
+	DebugDraw();
+	~DebugDraw();
+
+	DebugDraw(const DebugDraw&) = delete;
+	DebugDraw& operator=(const DebugDraw&) = delete;
+
+	void SetEnabled(bool enabled) { this->enabled = enabled; }
+	bool IsEnabled() const { return enabled; }
+
+	void AddLine(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color = glm::vec3(1.f));
+	void AddBox(const BoundingBox& box, const glm::vec3& color = glm::vec3(1.f));
+	// one circle around each axis
+	void AddSphere(const glm::vec3& center, float radius, const glm::vec3& color = glm::vec3(1.f), uint32_t segments = DEBUG_DRAW_SPHERE_SEGMENTS);
+	// edges of the volume clipped by projectionView
+	void AddFrustum(const glm::mat4& projectionView, const glm::vec3& color = glm::vec3(1.f));
+	// line from point along normal, with a small cross marking the point
+	void AddNormal(const glm::vec3& point, const glm::vec3& normal, float length = 1.f, const glm::vec3& color = glm::vec3(1.f));
+
+	size_t GetVertexCount() const { return vertices.size(); }
+
+	// game thread: moves the lines of the frame into out and starts a new frame, reusing out's storage
+	void Publish(std::vector<DebugVertex>& out);
+	// render thread: uploads the lines and draws them with one call
+	void Draw(const std::vector<DebugVertex>& lines, GLStateCache& glState);
+private:
+	bool enabled = false;
+
+	std::vector<DebugVertex> vertices; // lines recorded for the next frame
+
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	size_t capacity = 0; // in vertices
+
+	static uint32_t PackColor(const glm::vec3& color);
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define FRAME_ARENA_DEFAULT_SIZE (1024 * 1024)
+#define FRAME_ARENA_ALIGNMENT 64
+
+// =========================================================
+// FrameArena
+//
+// Linear allocator for data that only lives for one frame (render lists, batches).
+// Allocations are a pointer bump, individual frees are no-ops and everything is dropped at once by Reset.
+// Exposed as a std::pmr::memory_resource so standard pmr containers can live in it.
+// =========================================================
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	FrameArena(size_t initialSize = FRAME_ARENA_DEFAULT_SIZE);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Drops every allocation. Containers using the arena must release their storage before this.
+	// If the frame overflowed into extra blocks, they are merged into one so the next frame fits without allocating.
+	void Reset();
+
+	size_t GetUsedBytes() const { return usedBytes; }
+	size_t GetCapacity() const;
+
+	// blocks the arena took from the heap during the last frame (up to the last Reset).
+	// Only counts the arena itself, RendererStats::heapAllocations counts every allocation of the frame
+	uint32_t GetLastFrameHeapAllocations() const { return lastFrameHeapAllocations; }
+	uint64_t GetTotalHeapAllocations() const { return totalHeapAllocations; }
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+private:
+	struct Block
+	{
+		uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+	std::vector<Block> blocks;
+	size_t offset = 0;		// offset inside the last block
+	size_t usedBytes = 0;
+
+	uint32_t frameHeapAllocations = 0;
+	uint32_t lastFrameHeapAllocations = 0;
+	uint64_t totalHeapAllocations = 0;
+
+	void AllocateBlock(size_t size);
+	void FreeBlocks();
+};
+
+// Releases the storage of an arena backed vector, to be called before FrameArena::Reset.
+// Returns the size it had, handy to reserve the same amount next frame.
+template<typename T>
+size_t ReleaseArenaStorage(std::pmr::vector<T>& list)
+{
+	size_t size = list.size();
+	std::pmr::vector<T>(list.get_allocator()).swap(list);
+	return size;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "RenderQueue.h"
+#include "RenderCommands.h"
+#include "InstanceAllocator.h"
+#include "FrameArena.h"
+#include "WorkerPool.h"
+#include "Culling/Frustum.h"
+
+#include <mutex>
+
+// =================================================
+// RendererStats
+//
+// Counts of the last drawn frame, per LOD level of the meshes drawn.
+// Impostors are counted on their own, not in their mesh's levels.
+// =================================================
+struct RendererStats
+{
+	uint32_t lodDraws[MESH_MAX_LODS] = {};
+	uint32_t lodInstances[MESH_MAX_LODS] = {};
+	uint32_t shadowLodDraws[MESH_MAX_LODS] = {};
+	uint32_t shadowLodInstances[MESH_MAX_LODS] = {};
+	uint32_t impostorDraws = 0;
+	uint32_t impostorInstances = 0;
+	uint32_t shadowLayersDrawn = 0;		// layers of the shadow map redrawn
+	uint32_t shadowLayersCached = 0;	// of those, layers whose static casters had to be redrawn too
+	uint32_t pointLights = 0;
+	uint32_t clusteredLightIndices = 0;	// one per light and cluster it reaches
+	uint32_t heapAllocations = 0;		// made while publishing and rendering the frame, see AllocationCounter
+
+	// prints the counts as a table to stdout
+	void Print() const;
+};
+
+// =================================================
+// FrameRecorder
+//
+// The graphics API independent part of drawing a frame: sorts the RenderQueue,
+// builds the instanced batches and records the passes into a CommandBuffer.
+// Makes no GL calls, so frames can be recorded without a context (see NullRenderBackend).
+// Every list lives in the frame arena, EndFrame releases them and resets it.
+// =================================================
+class FrameRecorder
+{
+public:
+	FrameRecorder(FrameArena& arena, WorkerPool& workers);
+
+	// filled with the submissions of the frame before BuildBatches
+	RenderQueue& GetQueue() { return renderQueue; }
+
+	// Sorts the queue and writes the instances of every pass into `instances`.
+	// Casters are drawn into the shadow map layers set in staticLayers and dynamicLayers, see RenderQueue::CullShadowCasters
+	void BuildBatches(const glm::vec3& viewPos, const Frustum* shadowFrusta, uint32_t shadowLayerCount,
+		uint8_t staticLayers, uint8_t dynamicLayers, IInstanceAllocator& instances);
+
+	// batches of the last BuildBatches, in draw order
+	const RenderList& GetBatches(RenderLayer layer) const;
+	const RenderList& GetShadowBatches(bool staticCasters) const { return staticCasters ? batchedStaticShadow : batchedShadow; }
+
+	// Record a pass of the built batches, the returned buffer is reused by the next one.
+	// The main pass holds the opaque then the transparent batches
+	const CommandBuffer& RecordShadowPass(bool staticCasters, ShaderManager::Handle shader);
+	const CommandBuffer& RecordMainPass();
+	const CommandBuffer& RecordGUIPass();
+
+	// publishes the stats of the frame, then releases the lists and resets the arena, nothing else may keep storage in it
+	void EndFrame();
+
+	// counted while the passes are recorded, until ResetStats. Only for the thread recording
+	RendererStats& GetStats() { return stats; }
+	const RendererStats& GetStats() const { return stats; }
+	void ResetStats() { stats = RendererStats{}; }
+	// copy of the stats as they were at the last EndFrame, safe to call from any thread
+	RendererStats GetLastFrameStats() const;
+private:
+	FrameArena& arena;
+	WorkerPool& workers;
+	RenderQueue renderQueue;
+
+	RenderList batchedOpaque{ &arena };
+	RenderList batchedShadow{ &arena };
+	RenderList batchedStaticShadow{ &arena };
+	RenderList batchedTransparent{ &arena };
+	RenderList batchedGUI{ &arena };
+
+	// draw commands of the pass being recorded
+	CommandBuffer commands;
+	RendererStats stats;
+	RendererStats lastFrameStats;
+	mutable std::mutex lastFrameStatsMutex;
+
+	void RecordList(const RenderList& submissions, RenderLayer layer);
+	void RecordSubmission(const RenderSubmission& submission, uint8_t layerState);
+	void RecordShadowSubmission(const RenderSubmission& submission);
+	void RecordGUISubmission(const RenderSubmission& submission, MeshManager::Handle quad);
+};
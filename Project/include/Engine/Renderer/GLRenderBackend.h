@@ -0,0 +1,28 @@
+#pragma once
+#include "RenderBackend.h"
+
+//forward declarations
+struct GLStateCache;
+class InstanceStreamBuffer;
+
+// =========================================================
+// GLRenderBackend
+//
+// Replays command buffers with OpenGL, resolving the handles through the ResourceManager.
+// Draws are skipped while the bound mesh or material could not be found.
+// =========================================================
+class GLRenderBackend : public IRenderBackend
+{
+public:
+	GLRenderBackend(GLStateCache& glState, InstanceStreamBuffer& instanceStream);
+
+	void Execute(const CommandBuffer& commands) override;
+private:
+	GLStateCache& glState;
+	InstanceStreamBuffer& instanceStream;
+
+	// fixed function state currently set in GL
+	uint8_t renderState = RenderStateFlags::Default;
+
+	void ApplyRenderState(uint8_t state);
+};
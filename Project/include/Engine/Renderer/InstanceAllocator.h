@@ -0,0 +1,62 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// =========================================================
+// InstanceLayout
+//
+// Per-instance vertex layouts that can be streamed.
+// =========================================================
+enum class InstanceLayout : uint8_t
+{
+	Model,	// uint material table index + mat4 model matrix (see ModelInstanceData)
+	GUI,	// vec4 uv offset + mat4 model matrix (see GUIData)
+	Shadow,	// uint shadow map layer + mat4 model matrix (see ShadowInstanceData)
+};
+
+uint32_t GetInstanceStride(InstanceLayout layout);
+
+// =========================================================
+// IInstanceAllocator
+//
+// Per-instance memory of a frame, handed out to the BatchBuilder.
+// Instances are addressed by base instance, counted in strides of their layout.
+// =========================================================
+class IInstanceAllocator
+{
+public:
+	virtual ~IInstanceAllocator() = default;
+
+	// Makes sure at least `bytes` fit into the frame, must be called before its first Allocate
+	virtual void Reserve(size_t bytes) = 0;
+
+	// Returns a write pointer for `count` instances of the given layout, and the base instance to draw them with.
+	// Returns nullptr if the frame is full.
+	virtual void* Allocate(InstanceLayout layout, uint32_t count, uint32_t& outBaseInstance) = 0;
+};
+
+// =========================================================
+// InstanceHeapBuffer
+//
+// Per-instance memory in plain CPU memory, for frames recorded without a GPU.
+// Base instances count from the start of the buffer, like in one InstanceStreamBuffer region.
+// =========================================================
+class InstanceHeapBuffer : public IInstanceAllocator
+{
+public:
+	// drops the instances of the last frame
+	void BeginFrame() { usedBytes = 0; }
+
+	void Reserve(size_t bytes) override;
+	void* Allocate(InstanceLayout layout, uint32_t count, uint32_t& outBaseInstance) override;
+
+	const uint8_t* GetData() const { return reinterpret_cast<const uint8_t*>(storage.data()); }
+	size_t GetUsedBytes() const { return usedBytes; }
+private:
+	// vec4s keep the instance structs 16 byte aligned
+	std::vector<glm::vec4> storage;
+	size_t usedBytes = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+#include "InstanceAllocator.h"
+
+#include <cstdint>
+#include <cstddef>
+
+#define INSTANCE_STREAM_REGION_COUNT 3
+#define INSTANCE_STREAM_DEFAULT_REGION_SIZE (4 * 1024 * 1024)
+
+// =========================================================
+// InstanceStreamBuffer
+//
+// Persistently mapped vertex buffer holding the per-instance data of a frame.
+// It is split in INSTANCE_STREAM_REGION_COUNT regions, one per frame in flight,
+// each guarded by a fence so the CPU never overwrites data the GPU is still reading.
+// Draws address their instances through the base instance, so nothing is reallocated or uploaded at draw time.
+// =========================================================
+class InstanceStreamBuffer : public IInstanceAllocator
+{
+public:
+	InstanceStreamBuffer(size_t regionSize = INSTANCE_STREAM_DEFAULT_REGION_SIZE);
+	~InstanceStreamBuffer();
+
+	InstanceStreamBuffer(const InstanceStreamBuffer&) = delete;
+	InstanceStreamBuffer& operator=(const InstanceStreamBuffer&) = delete;
+
+	// Moves to the next region, waiting for the GPU to release it if needed
+	void BeginFrame();
+	// Fences the current region, call once all draws of the frame were issued
+	void EndFrame();
+
+	// Makes sure one region can hold at least `bytes`, growing the buffer if needed.
+	// Must be called before the first Allocate of the frame, as growing drops the written data.
+	void Reserve(size_t bytes) override;
+
+	// Returns a write pointer for `count` instances of the given layout, and the base instance to draw them with.
+	// Returns nullptr if the current region is full.
+	void* Allocate(InstanceLayout layout, uint32_t count, uint32_t& outBaseInstance) override;
+
+	GLuint GetBuffer() const { return buffer; }
+	// Changes every time the underlying GL buffer is recreated, used by meshes to know when to rebind their attributes
+	uint32_t GetGeneration() const { return generation; }
+private:
+	GLuint buffer = 0;
+	uint8_t* mapped = nullptr;
+
+	size_t regionSize = 0;
+	size_t regionOffset = 0; // write offset inside the current region
+	uint32_t currentRegion = 0;
+
+	GLsync fences[INSTANCE_STREAM_REGION_COUNT] = {};
+
+	uint32_t generation = 0;
+
+	void CreateStorage(size_t size);
+	void DestroyStorage();
+	void WaitForRegion(uint32_t region);
+};
@@ -3,9 +3,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "Engine/Resources/UboDefs.h"
 #include <algorithm>
+#include <cstdint>
 
 namespace LightMath {
-	void GetCascadeSplits(float nearPlane, float farPlane, int cascadeCount, float lambda, fixed_float outSplits[]) {
+	inline void GetCascadeSplits(float nearPlane, float farPlane, int cascadeCount, float lambda, fixed_float outSplits[]) {
 		float ratio = farPlane / nearPlane;
 		for (int i = 0; i < cascadeCount; i++) {
 			float p = (i + 1) / static_cast<float>(cascadeCount);
@@ -15,13 +16,13 @@ namespace LightMath {
 		}
 	}
 
-	glm::vec3 GetLightDirection(LightingUBO lightInfo) {
+	inline glm::vec3 GetLightDirection(LightingUBO lightInfo) {
 		if (lightInfo.lightPos.w) return glm::vec3(0.0f); // point light has no direction
 		return -glm::normalize(glm::vec3(lightInfo.lightPos));
 	}
 
-	// Computes light-space matrices for each cascade
-	void ComputeDirectionalLightCascades(
+	// Computes light-space matrices for each cascade, snapped to the texels of a shadowMapSize wide map
+	inline void ComputeDirectionalLightCascades(
 		const glm::vec3& lightDir,
 		const glm::mat4& cameraView,
 		float fovDegrees,
@@ -30,10 +31,11 @@ namespace LightMath {
 		float farPlane,
 		int cascadeCount,
 		const fixed_float cascadeSplits[],
+		uint32_t shadowMapSize,
 		glm::mat4 outLightMatrices[]
 	)
 	{
-		// Inverse camera view for frustum corner generation
+		// Inverse camera view for the slice centers
 		glm::mat4 invView = glm::inverse(cameraView);
 
 		// Normalize light direction
@@ -70,59 +72,42 @@ namespace LightMath {
 				{ -farWidth,  -farHeight,  -farDist }
 			};
 
-			// --- 2. Transform frustum corners to world space ---
-			glm::vec3 frustumCornersWS[8];
+			// --- 2. Bounding sphere of the slice ---
+			// Measured in view space the sphere only depends on the slice, not on where the camera
+			// is or looks, so the size of the cascade stays the same while the camera moves
+			glm::vec3 centerVS(0.0f);
 			for (int i = 0; i < 8; i++)
-			{
-				glm::vec4 world = invView * glm::vec4(frustumCornersVS[i], 1.0f);
-				frustumCornersWS[i] = glm::vec3(world);
-			}
+				centerVS += frustumCornersVS[i];
+			centerVS /= 8.0f;
 
-			// --- 3. Compute frustum center ---
-			glm::vec3 center(0.0f);
+			float radius = 0.0f;
 			for (int i = 0; i < 8; i++)
-				center += frustumCornersWS[i];
-			center /= 8.0f;
-
-			// --- 4. Build light view matrix ---
-			float lightDistance = 100.0f;
-			glm::vec3 lightPos = center - lightDirection * lightDistance;
+				radius = std::max(radius, glm::length(frustumCornersVS[i] - centerVS));
+			radius = std::ceil(radius * 16.0f) / 16.0f;
 
-			glm::mat4 lightView = glm::lookAt(
-				lightPos,
-				center,
-				glm::vec3(0.0f, 1.0f, 0.0f)
-			);
+			glm::vec3 center = glm::vec3(invView * glm::vec4(centerVS, 1.0f));
 
-			// --- 5. Compute ortho bounds in light space ---
-			glm::vec3 minLS(FLT_MAX);
-			glm::vec3 maxLS(-FLT_MAX);
+			// --- 3. Light view, fixed for a light direction ---
+			glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
 
-			for (int i = 0; i < 8; i++)
-			{
-				glm::vec3 cornerLS = glm::vec3(lightView * glm::vec4(frustumCornersWS[i], 1.0f));
-				minLS = glm::min(minLS, cornerLS);
-				maxLS = glm::max(maxLS, cornerLS);
-			}
+			// --- 4. Snap the origin to whole texels ---
+			// the cascade only moves in texel steps, so its light space repeats between frames
+			// and shadow edges do not shimmer
+			const float texelSize = 2.0f * radius / static_cast<float>(shadowMapSize);
+			glm::vec3 centerLS = glm::vec3(lightView * glm::vec4(center, 1.0f));
+			centerLS.x = std::floor(centerLS.x / texelSize) * texelSize;
+			centerLS.y = std::floor(centerLS.y / texelSize) * texelSize;
+			// depth is snapped coarsely, the range covers the snapping error
+			centerLS.z = std::floor(centerLS.z / radius) * radius;
 
 			const float depthPadding = 1000.0f;
-
-			minLS.z -= depthPadding;
-			maxLS.z += depthPadding;
-
-			// stabilization
-			float shadowMapRes = 2048.0f;
-			glm::vec2 texelSize = (glm::vec2(maxLS) - glm::vec2(minLS)) / shadowMapRes;
-
-			minLS.x = floor(minLS.x / texelSize.x) * texelSize.x;
-			minLS.y = floor(minLS.y / texelSize.y) * texelSize.y;
-			maxLS.x = minLS.x + texelSize.x * shadowMapRes;
-			maxLS.y = minLS.y + texelSize.y * shadowMapRes;
+			const float depthRange = 2.0f * radius + depthPadding;
 
 			glm::mat4 lightProj = glm::ortho(
-				minLS.x, maxLS.x,
-				minLS.y, maxLS.y,
-				-maxLS.z, -minLS.z
+				centerLS.x - radius, centerLS.x + radius,
+				centerLS.y - radius, centerLS.y + radius,
+				-centerLS.z - depthRange, -centerLS.z + depthRange
 			);
 
 			outLightMatrices[cascade] = lightProj * lightView;
@@ -131,7 +116,7 @@ namespace LightMath {
 		}
 	}
 
-	void ComputePointLightMatrices(
+	inline void ComputePointLightMatrices(
 		const glm::vec3& lightPos,
 		float nearPlane,
 		float farPlane,
@@ -148,7 +133,7 @@ namespace LightMath {
 		outMatrices[5] = proj * glm::lookAt(lightPos, lightPos + glm::vec3(0, 0, -1), glm::vec3(0, -1, 0));
 	}
 
-	float ComputePointLightFarPlane(const glm::vec3& attenuation)
+	inline float ComputePointLightFarPlane(const glm::vec3& attenuation)
 	{
 		float c = attenuation.x;
 		float b = attenuation.y;
@@ -0,0 +1,45 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "LightClusters.h"
+
+#include <vector>
+
+// storage buffer bindings, mirrored in defs.glsl
+#define POINT_LIGHT_BINDING 1
+#define LIGHT_GRID_BINDING 2
+#define LIGHT_INDEX_BINDING 3
+
+// =========================================================
+// ClusteredLightBuffers
+//
+// Storage buffers the shaders find the point lights of a fragment in:
+// the lights, the range of every cluster (headed by the depth params of the grid)
+// and the light index list those ranges point into. Render thread only.
+// =========================================================
+class ClusteredLightBuffers
+{
+public:
+	ClusteredLightBuffers() = default;
+	~ClusteredLightBuffers();
+
+	ClusteredLightBuffers(const ClusteredLightBuffers&) = delete;
+	ClusteredLightBuffers& operator=(const ClusteredLightBuffers&) = delete;
+
+	// uploads the binned lights of the frame, skipped while there are none and were none last frame
+	void Upload(const std::vector<PointLightData>& lights, const LightClusters& clusters);
+private:
+	struct Buffer
+	{
+		GLuint id = 0;
+		size_t capacity = 0; // bytes
+	};
+	Buffer lightBuffer, gridBuffer, indexBuffer;
+	bool uploaded = false;
+	bool hadLights = false;
+
+	std::vector<uint8_t> gridStaging;
+
+	// grows the buffer if needed, keeping it bound at `binding`, and writes the data
+	static void Write(Buffer& buffer, GLuint binding, const void* data, size_t bytes);
+};
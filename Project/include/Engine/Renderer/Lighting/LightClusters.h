@@ -0,0 +1,82 @@
+#pragma once
+#include "Engine/Renderer/Culling/FrustumCuller.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+// froxel grid, mirrored in defs.glsl. Tiles split the screen, slices split the depth exponentially
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z)
+
+// =========================================================
+// PointLightData
+//
+// One point light of a frame in world space, matches PointLight in the shaders (std430).
+// The light fades out to nothing at its radius.
+// Packed into vec4s, vec3s are 16 bytes with the aligned glm types
+// =========================================================
+struct PointLightData
+{
+	glm::vec4 positionRadius = glm::vec4(0.f, 0.f, 0.f, 10.f);
+	glm::vec4 colorIntensity = glm::vec4(1.f);
+
+	glm::vec3 GetPosition() const { return glm::vec3(positionRadius); }
+	float GetRadius() const { return positionRadius.w; }
+};
+static_assert(sizeof(PointLightData) == 32, "PointLightData must match the std430 layout of PointLight");
+
+// range of the light index list holding the lights of one cluster
+struct LightClusterRange
+{
+	uint32_t offset = 0;
+	uint32_t count = 0;
+};
+
+// =========================================================
+// LightClusters
+//
+// Bins point lights into the froxels of a perspective projection on the CPU.
+// Froxel bounds are view space AABBs, rebuilt only when the projection changes.
+// Every light is tested against the slices its sphere spans, a whole slice at a time
+// on the widest path the culler supports (see CullingPath).
+// Makes no GL calls, ClusteredLightBuffers uploads the result.
+// =========================================================
+class LightClusters
+{
+public:
+	// rebuilds the froxel bounds if the projection differs from the last one
+	void SetProjection(const glm::mat4& projection);
+
+	// fills the cluster ranges and the light index list, lights are indices into `lights`
+	void Bin(const glm::mat4& view, const std::vector<PointLightData>& lights);
+	void Bin(const glm::mat4& view, const std::vector<PointLightData>& lights, CullingPath path);
+
+	// one entry per cluster, index (z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x
+	const std::vector<LightClusterRange>& GetClusters() const { return clusters; }
+	const std::vector<uint32_t>& GetLightIndices() const { return lightIndices; }
+
+	// slice of a view depth is floor(log(depth) * x + y), z and w are the near and far planes
+	glm::vec4 GetDepthParams() const { return glm::vec4(sliceScale, sliceBias, nearPlane, farPlane); }
+	// -1 in front of the near plane, LIGHT_CLUSTERS_Z past the far plane
+	int GetSlice(float viewDepth) const;
+	static uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return (z * LIGHT_CLUSTERS_Y + y) * LIGHT_CLUSTERS_X + x;
+	}
+private:
+	// view space bounds of every cluster, in cluster index order
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+
+	glm::mat4 projection = glm::mat4(0.f);
+	float nearPlane = 0.f, farPlane = 0.f;
+	float sliceScale = 0.f, sliceBias = 0.f;
+
+	std::vector<LightClusterRange> clusters;
+	std::vector<uint32_t> lightIndices;
+	// (cluster, light) pairs found by the tests, sorted into lightIndices by cluster
+	std::vector<uint64_t> hits;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "Engine/Resources/MaterialManager.h"
+
+#include <vector>
+
+// =========================================================
+// MaterialTable
+//
+// Storage buffer holding the MaterialParams of every material, indexed by the material's dense id,
+// which model instances carry as their material index. Bound at MATERIAL_TABLE_BINDING.
+// Only uploaded again when some material's constants changed. Render thread only.
+// =========================================================
+class MaterialTable
+{
+public:
+	MaterialTable() = default;
+	~MaterialTable();
+
+	MaterialTable(const MaterialTable&) = delete;
+	MaterialTable& operator=(const MaterialTable&) = delete;
+
+	// uploads the constants of the materials if they changed since the last update
+	void Update(const MaterialManager& materials);
+private:
+	GLuint buffer = 0;
+	size_t capacity = 0;	// entries the buffer can hold
+	uint32_t version = 0;	// params version of the last upload, 0 before the first one
+
+	std::vector<MaterialParams> staging;
+};
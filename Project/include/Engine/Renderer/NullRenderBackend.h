@@ -0,0 +1,42 @@
+#pragma once
+#include "RenderBackend.h"
+
+// =========================================================
+// RenderCommandStats
+//
+// What a command stream would have cost on a real backend.
+// =========================================================
+struct RenderCommandStats
+{
+	uint64_t commands = 0;
+	uint64_t draws = 0;
+	uint64_t instances = 0;
+
+	uint64_t renderStateChanges = 0;
+	uint64_t shaderBinds = 0;
+	uint64_t materialBinds = 0;
+	uint64_t meshBinds = 0;
+
+	// FNV-1a over every packet, equal streams give equal hashes across runs
+	uint64_t hash = 0xcbf29ce484222325ull;
+};
+
+// =========================================================
+// NullRenderBackend
+//
+// Backend without a GPU: counts and hashes the commands instead of executing them,
+// so the CPU side of rendering can be measured and compared headless.
+// Stats accumulate over every Execute until ResetStats.
+// =========================================================
+class NullRenderBackend : public IRenderBackend
+{
+public:
+	void Execute(const CommandBuffer& commands) override;
+
+	const RenderCommandStats& GetStats() const { return stats; }
+	void ResetStats() { stats = RenderCommandStats{}; }
+private:
+	RenderCommandStats stats;
+
+	void Hash(uint64_t value);
+};
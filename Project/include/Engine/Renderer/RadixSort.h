@@ -0,0 +1,36 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <cstdint>
+
+// =========================================================
+// SortEntry
+//
+// Compact (key, index) pair sorted in place of whole RenderSubmissions.
+// `order` is a secondary 32-bit key, see RadixSort.
+// =========================================================
+struct SortEntry
+{
+	uint64_t sortKey = 0;
+	uint32_t index = 0;
+	uint32_t order = 0;
+};
+static_assert(sizeof(SortEntry) == 16, "SortEntry should stay 16 bytes");
+
+using SortList = std::pmr::vector<SortEntry>;
+
+enum class SortPriority : uint8_t
+{
+	KeyThenOrder,	// sortKey major, order breaks ties
+	OrderThenKey,	// order major, sortKey breaks ties
+};
+
+// =========================================================
+// RadixSort
+//
+// Stable LSD radix sort over 8-bit digits of (sortKey, order).
+// All digit histograms are built in a single pass and digits shared by every entry are skipped,
+// so sparse keys usually take far fewer than 12 scatter passes.
+// `scratch` is resized to entries.size() and used as the ping-pong buffer.
+// =========================================================
+void RadixSort(SortList& entries, SortList& scratch, SortPriority priority = SortPriority::KeyThenOrder);
@@ -0,0 +1,15 @@
+#pragma once
+#include "RenderCommands.h"
+
+// =========================================================
+// IRenderBackend
+//
+// Replays the command buffers recorded by the FrameRecorder.
+// =========================================================
+class IRenderBackend
+{
+public:
+	virtual ~IRenderBackend() = default;
+
+	virtual void Execute(const CommandBuffer& commands) = 0;
+};
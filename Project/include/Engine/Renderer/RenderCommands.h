@@ -0,0 +1,88 @@
+#pragma once
+#include <glad/glad.h>
+
+#include "Engine/Resources/ResourceManager.h"
+#include "InstanceStreamBuffer.h"
+
+#include <vector>
+#include <cstdint>
+
+// =========================================================
+// RenderCommandType
+// =========================================================
+enum class RenderCommandType : uint8_t
+{
+	SetRenderState,	// fixed function state, see RenderStateFlags
+	BindShader,		// shader without material, for passes that only need the geometry
+	SetMaterial,	// material, its shader, uniforms and textures
+	BindMesh,		// mesh and the instance layout its instances are read with
+	DrawInstanced,	// instances of the bound mesh from the instance stream
+};
+
+namespace RenderStateFlags
+{
+	constexpr uint8_t DepthTest = 1 << 0;
+	constexpr uint8_t DepthWrite = 1 << 1;
+	constexpr uint8_t CullBackfaces = 1 << 2;
+
+	// state the renderer starts with, and every backend leaves behind
+	constexpr uint8_t Default = DepthTest | DepthWrite | CullBackfaces;
+}
+
+// =========================================================
+// RenderCommand
+//
+// One packet of the command stream. Only the fields of its type are meaningful,
+// resources are referenced by handle so packets do not depend on any graphics API.
+// =========================================================
+struct RenderCommand
+{
+	RenderCommandType type = RenderCommandType::DrawInstanced;
+	uint8_t renderState = 0;						// SetRenderState
+	InstanceLayout layout = InstanceLayout::Model;	// BindMesh
+	GLenum primitive = 0;							// DrawInstanced, 0 to use the mesh primitive
+
+	SafeHandle resource;							// shader, material or mesh
+	TextureManager::Handle texture;					// SetMaterial, overrides the "tex" sampler if valid
+	Mesh* dynamicMesh = nullptr;					// BindMesh, used instead of the handle if set
+
+	uint32_t instanceCount = 0;						// DrawInstanced
+	uint32_t baseInstance = 0;						// DrawInstanced
+};
+
+// =========================================================
+// CommandBuffer
+//
+// Command packets of one pass, replayed by an IRenderBackend.
+// Recording drops state changes that repeat the current state,
+// so the packet counts match the state changes a backend really has to make.
+// The storage is kept between frames, so a warm buffer does not allocate.
+// =========================================================
+class CommandBuffer
+{
+public:
+	// drops the commands and forgets the recorded state
+	void Reset();
+
+	void SetRenderState(uint8_t state);
+	void BindShader(ShaderManager::Handle shader);
+	void SetMaterial(MaterialManager::Handle material, TextureManager::Handle texture = {});
+	void BindMesh(MeshManager::Handle mesh, Mesh* dynamicMesh, InstanceLayout layout);
+	void DrawInstanced(GLenum primitive, uint32_t instanceCount, uint32_t baseInstance);
+
+	const std::vector<RenderCommand>& GetCommands() const { return commands; }
+	size_t Size() const { return commands.size(); }
+private:
+	std::vector<RenderCommand> commands;
+
+	// state as of the last recorded command, to skip redundant packets
+	bool hasRenderState = false;
+	uint8_t renderState = 0;
+	ShaderManager::Handle shader;
+	MaterialManager::Handle material;
+	TextureManager::Handle texture;
+	MeshManager::Handle mesh;
+	Mesh* dynamicMesh = nullptr;
+	InstanceLayout layout = InstanceLayout::Model;
+	bool hasMesh = false;
+};
@@ -1,44 +1,138 @@
 #pragma once
 #include "Renderable.h"
 #include "Culling/Frustum.h"
+#include "Culling/OcclusionBuffer.h"
+#include "FrameArena.h"
+#include "RadixSort.h"
+#include "RenderWorld.h"
+#include "WorkerPool.h"
 
 #include <vector>
 
+// opaque submissions tested against the shadow map layers per worker chunk
+#define RENDER_QUEUE_SHADOW_CULL_CHUNK 256
+
+// =================================================
+// ShadowCasterCounts
+//
+// Shadow instances of a frame, one per caster and shadow map layer it is drawn into.
+// =================================================
+struct ShadowCasterCounts
+{
+	uint32_t staticInstances = 0;
+	uint32_t dynamicInstances = 0;
+};
+
 // =================================================
 // RenderQueue
 //
 // Collects and sorts RenderSubmissions for rendering per frame.
+// Submissions stay where they were pushed, only compact (key, index) pairs get sorted.
+// The lists live in the frame arena, see Clear and Reserve.
+// Culling the render world and sorting run on the worker pool, with results
+// merged in a fixed order so the output matches a serial run.
 // =================================================
 class RenderQueue
 {
 public:
-	RenderQueue();
+	RenderQueue(FrameArena& arena, WorkerPool& workers);
 
+	// Releases the lists' arena storage, must be called before the arena is reset
 	void Clear();
+	// Pre-sizes the lists from the last frame, must be called after the arena is reset
+	void Reserve();
 
 	// Add a renderable to the queue (copy is stoed to allow temporary objects)
 	void Push(const Renderable& renderable);
 	void Push(const std::vector<Renderable>& renderables);
+	// Culls every proxy of the world and pushes the visible ones, reusing their cached key and bounds.
+	// Proxies the occlusion buffer proves hidden are dropped from the main pass, but still cast shadows.
+	void Push(const RenderWorld& world, const OcclusionBuffer* occlusion = nullptr);
 
-	// Get a sorted list of submissions for a specific layer, called by the Renderer
-	std::vector<RenderSubmission>& GetSortedLayer(RenderLayer layer);
+	// Submissions of a layer, in push order
+	// The opaque layer also holds every shadow caster, see RenderSubmission::passMask
+	const RenderList& GetLayer(RenderLayer layer) const;
 
-	std::vector<RenderSubmission>& GetShadowCasters();
+	// Finds the shadow map layers every caster of the opaque list overlaps, see RenderSubmission::shadowLayers.
+	// Static casters are only tested against staticLayers, dynamic ones against dynamicLayers (one bit per layer)
+	ShadowCasterCounts CullShadowCasters(const Frustum* layerFrusta, uint32_t layerCount, uint8_t staticLayers, uint8_t dynamicLayers);
+
+	// Sorts every layer by sort key, the transparent one back to front from viewPos, called by the Renderer
+	void Sort(const glm::vec3& viewPos);
+	// Order of a layer after Sort, as indices into GetLayer
+	const SortList& GetOrder(RenderLayer layer) const;
 
 	size_t TotalSize() const;
 
 	void SetViewFrustum(const Frustum& frustum) { viewFrustum = frustum; }
+	// camera LOD levels are picked for, projectionScale is projection[1][1]
+	void SetLodView(const glm::vec3& viewPos, float projectionScale) { lodViewPos = viewPos; lodProjectionScale = projectionScale; }
 private:
-	std::vector<RenderSubmission> opaque;
-	std::vector<RenderSubmission> transparent;
-	std::vector<RenderSubmission> gui;
-	
-	std::vector<RenderSubmission> shadowCasters;
+	WorkerPool& workers;
+
+	RenderList opaque;
+	RenderList transparent;
+	RenderList gui;
+
+	SortList opaqueOrder;
+	SortList transparentOrder;
+	SortList guiOrder;
+	// one scratch list per layer, so the layers can be sorted at the same time
+	SortList opaqueScratch;
+	SortList transparentScratch;
+	SortList guiScratch;
+
+	// one bit per RenderWorld proxy, see CullBounds
+	std::pmr::vector<uint32_t> worldVisibility;
+
+	// submissions a chunk of the render world adds to each list
+	struct ChunkCounts
+	{
+		uint32_t opaque = 0;
+		uint32_t transparent = 0;
+		uint32_t gui = 0;
+	};
+	std::pmr::vector<ChunkCounts> worldChunks;
+
+	// sizes of the last frame, used by Reserve
+	size_t lastOpaqueSize = 0;
+	size_t lastTransparentSize = 0;
+	size_t lastGUISize = 0;
+	size_t lastVisibilityWords = 0;
 
 	uint64_t nextSubmitIndex = 1;
 
+	RenderList& GetList(RenderLayer layer);
+	SortList& GetOrderList(RenderLayer layer);
+	SortList& GetScratch(RenderLayer layer);
+	// sizes the order and scratch lists of a layer, done up front as the arena is not thread safe
+	void PrepareOrder(RenderLayer layer);
+	// fills the order list of a layer, with `order` left to be set by the caller
+	SortList& BuildOrder(RenderLayer layer);
+	void SortLayer(RenderLayer layer);
+	// same, but back to front from viewPos, submissions at the same distance keep the sort key order
+	void SortLayerBackToFront(RenderLayer layer, const glm::vec3& viewPos);
+
+	// Where a culled renderable goes: into the opaque list with this pass mask if non-zero,
+	// and into its own layer list if `toLayer` (never for opaque renderables)
+	struct Routing
+	{
+		uint8_t opaquePassMask = 0;
+		bool toLayer = false;
+	};
+	static Routing Route(const Renderable& renderable, bool visible);
+	void Enqueue(const Renderable& renderable, uint64_t sortKey, bool visible, const BoundingBox& worldBounds);
+
+	// Picks the LOD levels of a submission from its projected size, see MeshLodChain,
+	// and swaps it for its impostor past the impostor distance, see MeshImpostor.
+	// previous holds the level of the last frame for the hysteresis and gets the new one, nullptr for immediate submissions
+	void SelectLod(RenderSubmission& submission, uint8_t* previous) const;
+
 	Frustum viewFrustum;
-	ShaderManager::ShaderHandle particleShaderHandle; // cached handle to the particle shader for special treatment, to not rotate bounding box
 
+	glm::vec3 lodViewPos = glm::vec3(0.f);
+	float lodProjectionScale = 0.f;
+	// main pass LOD level of every render world proxy in the last frame, indexed by proxy id.
+	// Outlives the frame, so it is not in the arena
+	std::vector<uint8_t> proxyLods;
 };
-
@@ -0,0 +1,81 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "RenderWorld.h"
+#include "DebugDraw.h"
+#include "Lighting/LightClusters.h"
+#include "Engine/Resources/UboDefs.h"
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#define RENDER_SNAPSHOT_COUNT 2
+
+// =========================================================
+// CameraSnapshot
+//
+// Camera state of a published frame.
+// =========================================================
+struct CameraSnapshot
+{
+	glm::vec3 position = glm::vec3(0.f);
+	glm::mat4 view = glm::mat4(1.f);
+	glm::mat4 projection = glm::mat4(1.f);
+	float aspectRatio = 1.f;
+};
+
+// =========================================================
+// RenderSnapshot
+//
+// Everything the render thread reads for one frame, copied out of the simulation
+// when the frame is published, so the game thread can move on to the next frame.
+// =========================================================
+struct RenderSnapshot
+{
+	RenderWorld world;
+	CameraSnapshot camera;
+
+	LightingUBO lighting{};
+	bool lightingChanged = false; // the lighting UBO needs an upload
+
+	std::vector<Renderable> submissions;	// immediate submissions of the frame
+	std::vector<PointLightData> pointLights;
+	std::vector<DebugVertex> debugLines;
+
+	bool occlusionCulling = true;
+};
+
+// =========================================================
+// RenderSnapshotQueue
+//
+// RENDER_SNAPSHOT_COUNT snapshots handed from the game thread to the render thread in order.
+// The writer waits while every snapshot is still unread, the reader waits until one is published,
+// so the game thread runs at most one frame ahead of the frame being drawn.
+// =========================================================
+class RenderSnapshotQueue
+{
+public:
+	// game thread: the next snapshot to fill, nullptr once closed
+	RenderSnapshot* BeginWrite();
+	void EndWrite();
+	// game thread: slot of the snapshot BeginWrite hands out, in [0, RENDER_SNAPSHOT_COUNT)
+	uint32_t GetWriteIndex() const { return writeIndex; }
+
+	// render thread: the oldest published snapshot, nullptr once closed
+	const RenderSnapshot* BeginRead();
+	void EndRead();
+
+	// releases both sides for good, called when the game thread stops
+	void Close();
+private:
+	RenderSnapshot snapshots[RENDER_SNAPSHOT_COUNT];
+	bool published[RENDER_SNAPSHOT_COUNT] = {};
+
+	uint32_t writeIndex = 0;
+	uint32_t readIndex = 0;
+	bool closed = false;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+};
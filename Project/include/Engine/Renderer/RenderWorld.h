@@ -0,0 +1,126 @@
+#pragma once
+#include "Renderable.h"
+#include "Culling/FrustumCuller.h"
+
+#include <vector>
+
+// published frames a proxy has to stay untouched before it counts as static again
+#define RENDER_WORLD_STATIC_FRAMES 30
+
+// =========================================================
+// RenderProxy
+//
+// Retained copy of a Renderable, with everything derived from it cached
+// until the owner reports a change.
+// =========================================================
+struct RenderProxy
+{
+	Renderable renderable;
+	uint64_t sortKey = 0;
+	BoundingBox worldBounds; // only valid if renderable.hasBounds, also mirrored in the RenderWorld's CullingBoundsSoA
+
+	// changed within the last RENDER_WORLD_STATIC_FRAMES frames, new proxies start out dynamic
+	bool dynamic = true;
+	uint32_t lastChangeFrame = 0;
+};
+
+// =========================================================
+// RenderWorldChanges
+//
+// Ordered log of the calls that changed a RenderWorld. Replaying it into a copy
+// of the world as it was when the log started brings the copy up to date,
+// handles included, since the world reuses ids deterministically.
+// =========================================================
+struct RenderWorldChanges
+{
+	enum class Type : uint8_t { Add, Remove, UpdateTransform, Update, Clear, AdvanceFrame };
+
+	struct Change
+	{
+		Type type;
+		SafeHandle handle;
+		uint32_t payload = 0; // index into renderables (Add, Update) or matrices (UpdateTransform)
+	};
+
+	std::vector<Change> changes;
+	std::vector<Renderable> renderables;
+	std::vector<glm::mat4> matrices;
+
+	bool Empty() const { return changes.empty(); }
+	void Append(const RenderWorldChanges& other);
+	void Clear();
+};
+
+// =========================================================
+// RenderWorld
+//
+// Persistent set of render proxies owned by the Renderer.
+// Proxies are added once and only touched again when their owner pushes a delta,
+// so unchanged objects cost nothing but the per-frame culling.
+// Proxies are stored densely, handles stay stable across removals.
+// =========================================================
+class RenderWorld
+{
+public:
+	using ProxyHandle = SafeHandle;
+
+	ProxyHandle Add(const Renderable& renderable);
+	void Remove(ProxyHandle handle);
+
+	// Model matrix changed, refreshes the bounds
+	void UpdateTransform(ProxyHandle handle, const glm::mat4& modelMatrix);
+	// Any other property changed, refreshes the bounds, and the sort key if one of its inputs changed
+	void Update(ProxyHandle handle, const Renderable& renderable);
+
+	const RenderProxy* Get(ProxyHandle handle) const;
+	bool IsValid(ProxyHandle handle) const;
+
+	// Dense proxy storage, in no particular order
+	const std::vector<RenderProxy>& GetProxies() const { return proxies; }
+	// Culling bounds of every proxy, same order as GetProxies
+	const CullingBoundsSoA& GetCullingBounds() const { return cullingBounds; }
+	// Handle id of every proxy, same order as GetProxies. A proxy keeps its id while it lives,
+	// so per proxy state outside the world can be indexed by it
+	const std::vector<uint32_t>& GetProxyIds() const { return denseToId; }
+	// one past the largest handle id handed out
+	size_t GetIdCapacity() const { return slots.size(); }
+	size_t Size() const { return proxies.size(); }
+
+	// Counts a published frame, proxies that stayed untouched long enough become static again
+	void AdvanceFrame();
+	// Changes whenever the set of static shadow casters changes, or one of them moves.
+	// Shadow map layers cached for one version hold every static caster as it is drawn
+	uint64_t GetStaticCasterVersion() const { return staticCasterVersion; }
+
+	void Clear();
+
+	// Starts or stops logging every change, see RenderWorldChanges
+	void SetRecordChanges(bool record) { recordChanges = record; }
+	const RenderWorldChanges& GetChanges() const { return changes; }
+	void ClearChanges() { changes.Clear(); }
+	// Replays a log recorded by another world, this world has to match that one when the log started
+	void Apply(const RenderWorldChanges& log);
+private:
+	struct Slot {
+		uint32_t denseIndex = 0;
+		uint32_t generation = 0;
+		bool alive = false;
+	};
+
+	std::vector<RenderProxy> proxies;
+	CullingBoundsSoA cullingBounds;
+	std::vector<uint32_t> denseToId;	// handle id of each dense proxy
+	std::vector<Slot> slots;			// indexed by handle id, 0 is never used
+	std::vector<uint32_t> freeIds;
+
+	uint32_t frameIndex = 0;
+	uint64_t staticCasterVersion = 0;
+
+	bool recordChanges = false;
+	RenderWorldChanges changes;
+
+	// recomputes the bounds of a proxy in both layouts
+	void RefreshBounds(uint32_t denseIndex);
+	// marks a proxy dynamic, castShadows tells whether it was or is about to be a static caster
+	void Touch(RenderProxy& proxy, bool castShadows);
+};
@@ -2,7 +2,7 @@
 #define GLFW_INCLUDE_NONE
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include <compare>
+#include <memory_resource>
 
 #include "Engine/Resources/ResourceManager.h"
 #include "Engine/DataStructures/Transform.h"
@@ -21,32 +21,71 @@ enum class RenderLayer : uint8_t
 };
 
 // ===================================================
-// InstanceDataBase
+// ModelInstanceData
 //
-// Struct holding per-instance data for instanced rendering.
-// Served as a base for more specific instance data types.
+// Per-instance data of opaque and transparent renderables, matches InstanceLayout::Model.
+// The material index selects the material's constants in the material table,
+// so materials of one batch group can share a draw.
 // ===================================================
-struct InstanceDataBase
-{
-	virtual ~InstanceDataBase() = default;
-	uint32_t count = 0;
-};
-
-struct InstanceData : public InstanceDataBase
-{
-	std::vector<glm::mat4> modelMatrices;
+struct ModelInstanceData {
+	uint32_t materialIndex;
+	uint32_t padding[3];
+	glm::mat4 modelMatrix;
 };
 
+// ===================================================
+// GUIData
+//
+// Per-instance data of GUI renderables, matches InstanceLayout::GUI.
+// ===================================================
 struct GUIData {
 	glm::vec4 uvOffset; // x, y, width, height in uv space
 	glm::mat4 modelMatrix;
 };
 
-struct InstanceDataGUI : public InstanceDataBase
+// ===================================================
+// ShadowInstanceData
+//
+// Per-instance data of shadow casters, matches InstanceLayout::Shadow.
+// A caster gets one instance per shadow map layer (cascade or cube face) it overlaps.
+// ===================================================
+struct ShadowInstanceData {
+	uint32_t layer;
+	uint32_t padding[3];
+	glm::mat4 modelMatrix;
+};
+
+// ===================================================
+// InstanceRange
+//
+// Range of instances written to the InstanceStreamBuffer, drawn via base instance.
+// ===================================================
+struct InstanceRange
 {
-	std::vector<GUIData> guiData;
+	uint32_t baseInstance = 0;
+	uint32_t count = 0;
 };
 
+// ===================================================
+// RenderPassMask
+//
+// Passes a submission takes part in.
+// ===================================================
+namespace RenderPassMask
+{
+	constexpr uint8_t Main = 1 << 0;
+	constexpr uint8_t Shadow = 1 << 1;
+}
+
+// bits of each dense id in the sort key
+// opaque and transparent: shader | material batch group | mesh | flags
+#define SORT_KEY_SHADER_BITS 12
+#define SORT_KEY_MATERIAL_BITS 20
+#define SORT_KEY_MESH_BITS 28 // top bit marks meshes owned by the renderable
+// GUI: z order (16) | shader | material batch group | texture | flags
+#define SORT_KEY_GUI_MATERIAL_BITS 16
+#define SORT_KEY_TEXTURE_BITS 16
+
 // ===================================================
 // Renderable
 //
@@ -66,13 +105,13 @@ struct Renderable
 	// optional bounding box for culling
 	BoundingBox aabb;
 	bool hasBounds = false;
+	bool billboard = false; // always faces the camera, so rotation is ignored for culling (particles)
 
 	bool cullBackfaces = true;
 
 	bool castShadows = false;
 	bool receiveShadows = false;
-
-	InstanceDataBase* instanceData = nullptr; // optional instance data for instanced rendering
+	bool occluder = false; // rasterized into the occlusion buffer to hide what is behind it
 
 	RenderLayer layer = RenderLayer::Opaque;
 
@@ -91,9 +130,18 @@ struct Renderable
 	Renderable& operator=(const Renderable& other) noexcept = default;
 	Renderable(Renderable&& other) noexcept;
 
+	// Packs the dense ids of the shader, material and mesh (texture and z order for GUI) into a key,
+	// equal keys can be drawn as one instanced batch. See SORT_KEY_*_BITS for the room of each id
 	uint64_t GetSortKey() const;
+	// true if GetSortKey would return the same key for both
+	bool HasSameSortKeyInputs(const Renderable& other) const;
 };
 
+// World space bounds used for culling
+BoundingBox ComputeCullingBounds(const Renderable& renderable);
+// Sort key of an opaque or transparent renderable drawn with another managed mesh, like a LOD level of its own
+uint64_t ReplaceSortKeyMesh(uint64_t sortKey, MeshManager::Handle mesh);
+
 // ===================================================
 // RenderSubmission
 //
@@ -106,9 +154,31 @@ struct RenderSubmission
 	Renderable item;
 	// precomputed sort key
 	uint64_t sortKey = 0;
-	// comparator for sorting
-	std::strong_ordering operator<=>(const RenderSubmission& other) const noexcept;
+	// passes drawing this submission, shadow-only submissions share the opaque list
+	uint8_t passMask = RenderPassMask::Main;
+	// shadow map layers the caster overlaps, one bit per layer, filled by RenderQueue::CullShadowCasters
+	uint8_t shadowLayers = 0;
+	// drawn into the cached static shadow layers instead of every frame, see RenderWorld::GetStaticCasterVersion.
+	// Only render world proxies that stopped moving are static
+	bool staticShadow = false;
+
+	// LOD levels picked by the RenderQueue, item.meshHandle already is the main pass level.
+	// The shadow pass draws shadowMeshHandle, or item.meshHandle if it is not set
+	uint8_t lod = 0;
+	uint8_t shadowLod = 0;
+	MeshManager::Handle shadowMeshHandle;
+	// drawn as the impostor of shadowMeshHandle, item.meshHandle and item.materialHandle are its quad and material
+	bool impostor = false;
+
+	// culling bounds, only valid if item.hasBounds
+	BoundingBox worldBounds;
+
+	// filled by the BatchBuilder, for shadow batches it counts one instance per overlapped layer
+	InstanceRange instances;
 };
 
+// per-frame list of submissions, allocated from the Renderer's FrameArena
+using RenderList = std::pmr::vector<RenderSubmission>;
+
 
 
@@ -19,12 +19,15 @@ public:
 
 		auto& _mm = ResourceManager::Get().meshes;
 
+		// packed textures draw from their atlas, so elements sharing it also share a batch
+		TextureManager::Region region = ResourceManager::Get().textures.GetRegion(textureHandle);
+
 		Renderable renderable;
-		renderable.textureHandle = textureHandle;
+		renderable.textureHandle = region.texture;
 		renderable.modelMatrix = modelMatrix;
 
 		renderable.zOrder = zOrder;
-		renderable.uvRect = uvRect;
+		renderable.uvRect = region.Transform(uvRect);
 		renderable.layer = RenderLayer::GUI;
 		renderable.meshHandle = _mm.GetHandle("primitive/quad");
 		renderable.materialHandle = materialHandle;
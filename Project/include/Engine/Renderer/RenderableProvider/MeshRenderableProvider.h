@@ -11,6 +11,7 @@ public:
 	MaterialManager::Handle materialHandle = {};
 	glm::mat4 modelMatrix = glm::mat4(1.0f);
 	bool castShadows = false;
+	bool occluder = false;
 
 	void GenerateRenderables(std::vector<Renderable>& out) override
 	{
@@ -25,6 +26,7 @@ public:
 		renderable.materialHandle = materialHandle;
 		renderable.modelMatrix = modelMatrix;
 		renderable.castShadows = castShadows;
+		renderable.occluder = occluder;
 
 		Mesh* meshPtr = dynamicMesh ? dynamicMesh : _mm.Get(meshHandle);
 		if (meshPtr)
@@ -39,6 +41,7 @@ public:
 		Material* material = _mam.Get(materialHandle);
 		if (material) {
 			renderable.castShadows = material->castShadows;
+			renderable.occluder |= material->occluder;
 			auto val = material->GetUniform<int>("receiveShadows");
 			renderable.receiveShadows = val.value_or(false);
 
@@ -35,6 +35,7 @@ public:
 				auto* material = _mam.Get(meshEntry.material);
 				if(material){
 					renderable.castShadows = material->castShadows;
+					renderable.occluder = material->occluder;
 					auto val = material->GetUniform<int>("receiveShadows");
 					renderable.receiveShadows = val.value_or(false);
 
@@ -2,9 +2,23 @@
 #include <glad/glad.h>
 
 #include "Engine/Resources/ResourceManager.h"
-#include "RenderQueue.h"
+#include "FrameRecorder.h"
 #include "GLStateCache.h"
 #include "ShadowFramebuffer.h"
+#include "InstanceStreamBuffer.h"
+#include "FrameArena.h"
+#include "RenderWorld.h"
+#include "WorkerPool.h"
+#include "DebugDraw.h"
+#include "RenderCommands.h"
+#include "GLRenderBackend.h"
+#include "RenderSnapshot.h"
+#include "MaterialTable.h"
+#include "Lighting/LightClusters.h"
+#include "Lighting/ClusteredLightBuffers.h"
+#include "Culling/OcclusionBuffer.h"
+#include "Engine/Profiling/GpuProfiler.h"
+#include "Engine/Profiling/AllocationCounter.h"
 #include "Engine/Resources/UboDefs.h"
 
 #include "IRenderCamera.h"
@@ -15,70 +29,174 @@
 #define DEFAULT_CLEAR_COLOR_B 0.0f
 
 #define SHADOW_MAP_SIZE 2048
+#define SHADOW_LAYER_COUNT 6 // cascades of the directional light, cube faces of the point light
 #define POINT_SHADOW_TEX_NAME "shadow/point"
 #define DIR_SHADOW_TEX_NAME "shadow/dir"
+// static casters only, copied into the maps above before the dynamic casters are drawn
+#define POINT_SHADOW_CACHE_TEX_NAME "shadow/pointStatic"
+#define DIR_SHADOW_CACHE_TEX_NAME "shadow/dirStatic"
+#define SHADOW_NEAR_CASCADES 2			// directional cascades redrawn every frame
+#define SHADOW_VERTEX_LAYER 1			// 0 always routes shadow casters to their layer in a geometry shader
+#define SHADOW_FAR_CASCADE_INTERVAL 4	// frames between redraws of each further cascade, taken in turns. 1 redraws all every frame
 
 //forward declarations
 class App;
 
+// =================================================
+// Renderer
+//
+// Runs as a two stage pipeline: the game thread simulates a frame and publishes it
+// as a RenderSnapshot, then moves on to the next frame while the render thread,
+// which owns the GL context, draws the published one.
+// Everything but Render and ClosePipeline is called from the game thread.
+// =================================================
 class Renderer
 {
 public:
 	Renderer(App& app);
 	~Renderer();
 
-	void Render();
+	// game thread: hands the simulated frame over to the render thread, waits while it is a frame behind
+	void PublishFrame();
+	// render thread: draws the oldest published frame, returns false once the pipeline is closed
+	bool Render();
+	// stops the pipeline, so neither thread waits on the other anymore
+	void ClosePipeline();
 
 	// =================================================
+	// immediate submissions, only drawn for the next published frame
 	void Submit(const Renderable& r);
 	void Submit(const std::vector<Renderable>& rs);
+	// point lights of the next published frame, binned into the light clusters on the render thread
+	void Submit(const PointLightData& light);
+
+	// retained proxies, drawn every frame until removed
+	RenderWorld& GetRenderWorld() { return renderWorld; }
+
+	// shared by the render preparation steps, including the RenderSystem's extraction
+	WorkerPool& GetWorkerPool() { return workerPool; }
+
+	// lines drawn on top of the frame, for debug views
+	DebugDraw& GetDebugDraw() { return debugDraw; }
 
 	void SetRenderCamera(IRenderCamera* camera) { renderCamera = camera; }
 	void UpdateLighting(LightingUBO* light = nullptr);
+
+	// stats of the last frame the render thread finished, safe to call from the game thread
+	RendererStats GetStats() const;
+	void PrintStats() const;
 private:
 	
 	App& app;
 	ResourceManager& _rm;
 
-	RenderQueue renderQueue;
+	FrameArena frameArena;
+	WorkerPool workerPool;
+	RenderWorld renderWorld;
 	GLStateCache glState;
 
+	// sorts, batches and records the frame into command buffers, without touching GL
+	FrameRecorder frameRecorder{ frameArena, workerPool };
+	// per-instance data of the frame, shared by all passes
+	InstanceStreamBuffer instanceStream;
+
+	// constants of every material, so materials of one batch group draw together
+	MaterialTable materialTable;
+
+	// point lights of the frame binned into the froxels of the camera, see LightClusters
+	LightClusters lightClusters;
+	ClusteredLightBuffers lightBuffers;
+
+	// replays the recorded passes
+	GLRenderBackend glBackend{ glState, instanceStream };
+
+	// game thread state, copied into the snapshot when a frame is published
 	IRenderCamera* renderCamera = nullptr;
 	LightingUBO* renderLight = nullptr;
+	bool lightingDirty = false;
+	std::vector<Renderable> pendingSubmissions;
+	// world changes each snapshot slot has not seen yet, replayed into it when it is written next
+	RenderWorldChanges pendingWorldChanges[RENDER_SNAPSHOT_COUNT];
+	std::vector<PointLightData> pendingPointLights;
+
+	RenderSnapshotQueue snapshots;
+	// snapshot being drawn, only valid on the render thread during Render
+	const RenderSnapshot* frame = nullptr;
 
 	ShadowFramebuffer
-		pointShadowFBO	= ShadowFramebuffer(ShadowMapType::Point),
-		dirShadowFBO	= ShadowFramebuffer(ShadowMapType::Directional);
+		pointShadowFBO		= ShadowFramebuffer(ShadowMapType::Point, POINT_SHADOW_TEX_NAME),
+		dirShadowFBO		= ShadowFramebuffer(ShadowMapType::Directional, DIR_SHADOW_TEX_NAME),
+		pointShadowCacheFBO	= ShadowFramebuffer(ShadowMapType::Point, POINT_SHADOW_CACHE_TEX_NAME),
+		dirShadowCacheFBO	= ShadowFramebuffer(ShadowMapType::Directional, DIR_SHADOW_CACHE_TEX_NAME);
+
+	// debug lines of the frame, bounding boxes among them (B key)
+	DebugDraw debugDraw;
+
+	// heap allocations of PublishFrame (game thread) and Render (render thread), 0 once warm
+	AllocationCounter publishAllocations;
+	AllocationCounter renderAllocations;
 
-	bool showBoundingBoxes = false;
+	// software occlusion culling, occluders of the render world are rasterized on the CPU before the world is culled
+	OcclusionBuffer occlusionBuffer;
+	bool occlusionCulling = true; // toggled on the game thread, read from the snapshot
+	glm::mat4 projectionView = glm::mat4(1.f);
+
+#if ENGINE_PROFILING
+	// timer queries of the passes, render thread only
+	GpuProfiler gpuProfiler;
+#endif
 
 	// cascaded shadow mapping related variables
 	float nearPlane = 0.1f, farPlane = 10000.f;
 	fixed_float cascadeSplits[6];
 
+	// light space of every shadow map layer for this frame, casters are only drawn into the layers they overlap
+	ShadowUBO shadowData;
+	Frustum shadowFrusta[SHADOW_LAYER_COUNT];
+	bool pointShadows = false;
+	// casters are routed to their layer by the vertex shader, see ShadowFramebuffer::SupportsVertexLayer
+	bool vertexShadowLayers = false;
+
+	// What every shadow map layer was last drawn with, render thread only.
+	// A layer keeps its light space until it is redrawn, and its cached static casters
+	// until that light space or the static casters change
+	struct ShadowLayerState
+	{
+		glm::mat4 lightSpace = glm::mat4(1.f);
+		uint64_t staticCasterVersion = 0;
+		bool drawn = false;
+	};
+	ShadowLayerState shadowLayers[SHADOW_LAYER_COUNT];
+	bool shadowLayersPointLight = false;
+	glm::vec4 shadowLayersLightPos = glm::vec4(0.f);
+	uint32_t shadowFrame = 0;
+	// layers redrawn this frame, and those whose cached static casters are redrawn first, one bit per layer
+	uint8_t shadowDrawLayers = 0;
+	uint8_t shadowCacheLayers = 0;
+
 
 	// --- Rendering functions ---
 	void Clear() const;
+	void UploadLighting();
 	void UpdateCameraUBOs();
+	void ExtractRenderWorld();
+	void BinLights();
+	void BuildOcclusionBuffer();
 	void RenderFrame();
-	void ClearQueue() { renderQueue.Clear(); }
+	void UpdateShadowMatrices();
+	// picks the layers drawn this frame, layers left out get their last light space back
+	void ScheduleShadowLayers();
 
 	// -- Draw passes ---
 	void DrawShadowPass();
 	void DrawMainPass();
 
-	// --- Drawing functions ---
-	void DrawList(const std::vector<RenderSubmission>& submissions);
-	void DrawSubmission(const RenderSubmission& submission);
-	void DrawShadowSubmission(const RenderSubmission& submission);
-	void DrawGUISubmission(const RenderSubmission& submission);
-
-	// --- Util camera functions ---
+	// --- Util camera functions, render thread only ---
 	glm::mat4 GetViewMatrix() const {
-		return renderCamera->GetViewMatrix();
+		return frame->camera.view;
 	}
 	glm::mat4 GetPerspectiveMatrix() const {
-		return renderCamera->GetProjectionMatrix();
+		return frame->camera.projection;
 	}
 	glm::mat4 GetGUIViewMatrix() const {
 		return glm::ortho(-0.5f, 0.5f, -0.5f, 0.5f, -1.f, 1.f);
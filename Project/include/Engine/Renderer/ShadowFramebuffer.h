@@ -14,32 +14,43 @@ enum class ShadowMapType
 // ShadowFramebuffer
 //
 // Owns a framebuffer object + depth texture for shadow mapping.
-// Two of these are used in the Renderer, one for directional and one for point lights.
+// The Renderer uses one per light type, plus one per light type caching the static casters.
 // =========================================================
 class ShadowFramebuffer
 {
 public:
-	ShadowFramebuffer(ShadowMapType type);
+	ShadowFramebuffer(ShadowMapType type, const char* textureName);
 	~ShadowFramebuffer();
 
-	// Bind this FBO for rendering (shadow pass). For cube map faces, faceIndex in [0..5]
-	void BindForWriting(int faceIndex = -1) const;
+	// Bind this FBO for rendering (shadow pass). For cube map faces, faceIndex in [0..5].
+	// Without clear the layers keep their depth, see ClearLayers and CopyLayers
+	void BindForWriting(int faceIndex = -1, bool clear = true) const;
 
 	// Unbind (bind default framebuffer)
 	// Caller is responsible for restoring viewport if needed
 	static void Unbind(const GLStateCache& glState);
 
+	// true if the driver lets vertex shaders pick the layer they draw to (gl_Layer),
+	// so shadow casters can skip the geometry shader stage
+	static bool SupportsVertexLayer();
+
 	void Clear() const;
+	// resets the depth of some layers (cascades or cube faces), one bit per layer
+	void ClearLayers(uint8_t layerMask) const;
+	// copies the depth of some layers out of a shadow map of the same type and size
+	void CopyLayers(const ShadowFramebuffer& source, uint8_t layerMask) const;
 
 	TextureManager::TextureHandle GetTextureHandle() const { return texHandle; }
 
 	bool IsCube() const { return isCube; }
 	int GetSize() const { return size; }
+	int GetLayerCount() const { return layerCount; }
 private:
 	GLuint fbo = 0;
 	TextureManager::TextureHandle texHandle;
 	bool isCube = false;
 	int size = 0;
+	int layerCount = 0;
 
 };
 
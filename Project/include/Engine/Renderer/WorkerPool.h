@@ -0,0 +1,110 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#define WORKER_POOL_MAX_WORKERS 7
+
+class AllocationCounter;
+
+// =========================================================
+// WorkerPool
+//
+// Small fork-join pool for render preparation.
+// Work is split into contiguous chunks numbered in ascending order, so callers can
+// merge per-chunk results in chunk order and get the same output as a serial loop.
+// The calling thread works on the chunks too, and calls block until every chunk is done.
+// The game and render threads both submit work, their jobs take turns on the pool.
+// Callables are only referenced, never copied, so submitting a job does not allocate.
+// Chunks run with the submitter's AllocationCounter current.
+// =========================================================
+class WorkerPool
+{
+public:
+	// Non-owning reference to a callable taking (begin, end, chunk)
+	struct ChunkFunction
+	{
+		void* context = nullptr;
+		void (*invoke)(void* context, size_t begin, size_t end, size_t chunk) = nullptr;
+
+		void operator()(size_t begin, size_t end, size_t chunk) const { invoke(context, begin, end, chunk); }
+	};
+
+	// 0 picks one worker per spare hardware thread, up to WORKER_POOL_MAX_WORKERS
+	WorkerPool(uint32_t workerCount = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// workers plus the calling thread
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+	// Number of chunks ParallelFor splits `count` items into
+	size_t GetChunkCount(size_t count, size_t minChunkSize) const;
+
+	// Runs func over [0, count) split in GetChunkCount chunks
+	template<typename Function>
+	void ParallelFor(size_t count, size_t minChunkSize, Function&& func)
+	{
+		using FunctionType = std::remove_reference_t<Function>;
+		ChunkFunction ref;
+		ref.context = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+		ref.invoke = [](void* context, size_t begin, size_t end, size_t chunk) {
+			(*static_cast<FunctionType*>(context))(begin, end, chunk);
+			};
+		ParallelForChunks(count, minChunkSize, ref);
+	}
+
+	// Runs every task, possibly in parallel
+	template<typename... Tasks>
+	void Run(Tasks&&... tasks)
+	{
+		struct TaskRef
+		{
+			void* context;
+			void (*invoke)(void* context);
+		};
+		const TaskRef taskRefs[] = { TaskRef{
+			const_cast<void*>(static_cast<const void*>(std::addressof(tasks))),
+			[](void* context) { (*static_cast<std::remove_reference_t<Tasks>*>(context))(); }
+			}... };
+
+		ParallelFor(sizeof...(Tasks), 1, [&taskRefs](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				taskRefs[i].invoke(taskRefs[i].context);
+			}
+			});
+	}
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex submitMutex;	// held by the thread whose job is running
+	std::mutex mutex;
+	std::condition_variable wakeCondition;	// workers wait for a new job
+	std::condition_variable doneCondition;	// the submitter waits for the job to finish
+
+	// current job, only changed under the mutex while no worker is busy
+	const ChunkFunction* jobFunction = nullptr;
+	AllocationCounter* jobAllocations = nullptr;
+	size_t jobCount = 0;
+	size_t jobChunkSize = 0;
+	size_t jobChunkCount = 0;
+	uint64_t jobGeneration = 0;
+
+	std::atomic<size_t> nextChunk{ 0 };
+	std::atomic<size_t> doneChunks{ 0 };
+	uint32_t busyWorkers = 0;
+	bool stopping = false;
+
+	void ParallelForChunks(size_t count, size_t minChunkSize, const ChunkFunction& func);
+	void WorkerLoop();
+	// runs chunks of the current job until there are none left
+	void RunChunks();
+};
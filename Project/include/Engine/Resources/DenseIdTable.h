@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// =========================================================
+// DenseIdTable
+//
+// Hands out small integer ids starting at 1, reusing released ones first,
+// so the ids of live resources stay packed near the bottom of the range.
+// Used for sort keys, where every resource has to fit in a fixed number of bits.
+// =========================================================
+class DenseIdTable
+{
+public:
+	uint32_t Acquire() {
+		if (!freeIds.empty()) {
+			uint32_t id = freeIds.back();
+			freeIds.pop_back();
+			return id;
+		}
+		return ++highestId;
+	}
+
+	void Release(uint32_t id) {
+		if (id != 0) freeIds.push_back(id);
+	}
+
+	// highest id handed out so far, every live id is in [1, GetHighestId()]
+	uint32_t GetHighestId() const { return highestId; }
+private:
+	uint32_t highestId = 0;
+	std::vector<uint32_t> freeIds;
+};
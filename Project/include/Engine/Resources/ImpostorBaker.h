@@ -0,0 +1,59 @@
+#pragma once
+#include "MeshManager.h"
+#include "TextureManager.h"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#define IMPOSTOR_FRAMES 8					// views per side of the octahedral grid, mirrored in defs.glsl
+#define IMPOSTOR_FRAME_SIZE 64				// pixels per side of one view
+#define IMPOSTOR_DILATION 4					// pixels the colors of a view are grown past its silhouette, keeps mipmaps from darkening the edges
+#define IMPOSTOR_BAKE_SHADER "impostorBake"
+#define IMPOSTOR_SHADER "impostor"
+#define IMPOSTOR_QUAD_MESH "primitive/quad_backface"
+
+#define IMPOSTOR_CACHE_MAGIC 0x43504D49u	// "IMPC"
+#define IMPOSTOR_CACHE_VERSION 2			// bump whenever the layout or the bake changes
+#define IMPOSTOR_CACHE_EXTENSION ".impc"
+
+struct Material;
+
+// =========================================================
+// ImpostorAtlas
+//
+// Views of a mesh from IMPOSTOR_FRAMES x IMPOSTOR_FRAMES directions around it, laid out on an
+// octahedral grid: the view from a direction is in the cell its octahedral encoding falls in.
+// Every view is an orthographic image of the bounding sphere, see ImpostorBaker::GetQuadFrame.
+// =========================================================
+struct ImpostorAtlas {
+	std::string meshName;
+	TextureImage albedo;	// rgb color, alpha 0 outside the silhouette
+	TextureImage normals;	// object space normal * 0.5 + 0.5
+};
+
+// =========================================================
+// ImpostorBaker
+//
+// Renders impostor atlases of model meshes and caches them on disk.
+// The cache file lives next to the source model like the cooked model and goes stale with the same stamps.
+// Read and Write make no GL calls, Bake needs the GL context.
+// =========================================================
+namespace ImpostorBaker
+{
+	std::string GetCachePath(const std::string& modelFilePath);
+
+	// false if the cache is missing, stale or broken
+	bool Read(const std::string& modelFilePath, std::vector<ImpostorAtlas>& out);
+	bool Write(const std::string& modelFilePath, const std::vector<ImpostorAtlas>& atlases);
+
+	// renders the views of a mesh textured with the "albedo" sampler of its material (untextured if it has none)
+	bool Bake(const Mesh& mesh, const Material* material, ImpostorAtlas& out);
+
+	// maps primitive/quad_backface onto the bounding sphere of a mesh, in the mesh's object space
+	glm::mat4 GetQuadFrame(const BoundingBox& bounds);
+
+	// direction of a point of the octahedral grid, uv in [0, 1]
+	glm::vec3 OctahedralDecode(const glm::vec2& uv);
+}
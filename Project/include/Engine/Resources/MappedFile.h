@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// =========================================================
+// MappedFile
+//
+// Read-only memory mapping of a whole file, pages are read in by the OS when first touched.
+// The data stays valid until the object is destroyed.
+// =========================================================
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// false if the file is missing or empty
+	bool Open(const std::string& path);
+	void Close();
+
+	const uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* file = nullptr;		// HANDLE
+	void* mapping = nullptr;	// HANDLE
+#else
+	int file = -1;
+#endif
+};
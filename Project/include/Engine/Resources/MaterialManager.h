@@ -4,11 +4,18 @@
 #include "ShaderManager.h"
 #include "TextureManager.h"
 #include "UboWriter.h"
+#include "UboDefs.h"
 
 #include <json.hpp>
 
 #include <span>
 #include <vector>
+#include <optional>
+#include <mutex>
+
+// shaders that read their material constants from the material table declare this storage block
+#define MATERIAL_TABLE_BLOCK_NAME "MaterialTable"
+#define MATERIAL_TABLE_BINDING 0
 
 //forward declaration
 class MaterialPolicy;
@@ -24,19 +31,34 @@ public:
 	ShaderManager::Handle GetShader() const { return shader; }
 	ShaderReflection* GetShaderReflection() const;
 
+	// names are resolved once into handles, setting through a handle does no string work.
+	// Invalid handle if the shader has no such uniform or texture sampler
+	UniformHandle GetUniformHandle(const std::string& name) const;
+	UniformHandle GetTextureHandle(const std::string& samplerName) const;
+
+	template<typename T>
+	void SetUniform(UniformHandle uniform, const T& value, size_t index = 0) {
+		if (uniform.IsValid()) uniforms[uniform.index].value.Set(value, index);
+	}
+
 	template<typename T>
 	void SetUniform(const std::string& name, const T& value, size_t index = 0) {
-		uniforms[name].Set(value, index);
+		SetUniform(GetUniformHandle(name), value, index);
+	}
+
+	template<typename T>
+	void SetUniformArray(UniformHandle uniform, const T* arr) {
+		if (uniform.IsValid()) uniforms[uniform.index].value.SetArray(arr);
 	}
 
 	template<typename T>
 	void SetUniformArray(const std::string& name, const T* arr) {
-		uniforms[name].SetArray(arr);
+		SetUniformArray(GetUniformHandle(name), arr);
 	}
 
 	template<typename T>
 	void SetUniformArray(const std::string& name, std::span<const T> values) {
-		uniforms[name].SetArray(values.data());
+		SetUniformArray(GetUniformHandle(name), values.data());
 	}
 
 	template<typename T>
@@ -46,48 +68,84 @@ public:
 
 	template<typename T>
 	void SetUniformArray(const std::string& name, const std::vector<T>& values) {
-		uniforms[name].SetArray(values.data());
+		SetUniformArray(GetUniformHandle(name), values.data());
 	}
 
+	// packed textures resolve to their atlas if the shader has the sampler's rect uniform
+	void SetTexture(UniformHandle sampler, TextureManager::Handle tex);
 	void SetTexture(const std::string& uniformName, TextureManager::Handle tex);
 	void SetTexture(const std::string& uniformName, const std::string& texName);
+	// the "tex" sampler, overridden per draw by submissions that carry their own texture
+	void SetMainTexture(TextureManager::Handle tex) { SetTexture(mainTexture, tex); }
+	// texture set for a sampler, invalid handle if the shader has no such sampler
+	TextureManager::Handle GetTexture(UniformHandle sampler) const {
+		return sampler.IsValid() ? textures[sampler.index].texture : TextureManager::Handle{};
+	}
 
 	template <typename T>
 	std::optional<T> GetUniform(const std::string& name, size_t index = 0) const {
-		auto it = uniforms.find(name);
-		if (it == uniforms.end()) return std::nullopt;
-		return it->second.Get<T>(index);
+		UniformHandle uniform = GetUniformHandle(name);
+		if (!uniform.IsValid()) return std::nullopt;
+		return uniforms[uniform.index].value.Get<T>(index);
 	}
 
 	template <typename T>
 	std::vector<T> GetUniformArray(const std::string& name) const {
-		auto it = uniforms.find(name);
-		if (it == uniforms.end()) return {};
-		return it->second.GetArray<T>();
+		UniformHandle uniform = GetUniformHandle(name);
+		if (!uniform.IsValid()) return {};
+		return uniforms[uniform.index].value.GetArray<T>();
 	}
 
 	UboWriter* GetLocalUboWriter(const std::string& blockName);
 
 	void Apply(GLStateCache* glState = nullptr);
 
+	// constants read from the material table instead of uniforms, see MaterialManager::SetParams
+	const MaterialParams& GetParams() const { return params; }
+	bool UsesMaterialTable() const { return usesMaterialTable; }
+
 	bool castShadows = false;
+	bool occluder = false;
 
 
 private:
 	ShaderManager::Handle shader;
 
-	std::unordered_map<std::string, UniformValue> uniforms;				// local uniform values for storing non-UBO uniform data local to the material
-	std::unordered_map<std::string, UboWriter> ubos;					// local UBO writers for storing UBO data local to the material
-	std::unordered_map<std::string, TextureManager::Handle> textures;	// texture samplers
-
-	std::unordered_map<std::string, bool> dirtyTextures;				// track which textures have been modified
+	// local uniform value for storing non-UBO uniform data local to the material
+	struct MaterialUniform {
+		GLint location;
+		UniformValue value;
+	};
+	// texture bound to a sampler of the shader
+	struct MaterialTexture {
+		GLint unit;
+		TextureManager::Handle texture;
+		bool dirty = false;	// modified since it was last bound
+		UniformHandle rect;	// vec4 "<sampler>Rect" uniform, shaders that declare it can sample packed textures from their atlas
+	};
+
+	std::vector<MaterialUniform> uniforms;						// indexed by UniformHandle
+	std::vector<MaterialTexture> textures;						// indexed by UniformHandle
+	std::unordered_map<std::string, uint32_t> uniformIndices;	// only used to resolve names
+	std::unordered_map<std::string, uint32_t> textureIndices;	// dito
+	UniformHandle mainTexture;
+
+	std::unordered_map<std::string, UboWriter> ubos;			// local UBO writers for storing UBO data local to the material
+
+	MaterialParams params;
+	bool usesMaterialTable = false;	// the shader declares MATERIAL_TABLE_BLOCK_NAME
+
+	// bytes of everything Apply sets, materials with equal signatures draw the same but for their table constants
+	std::string GetStateSignature() const;
 
 	friend class MaterialPolicy;
+	friend class MaterialManager;
 };
 
 struct MaterialResourceInfo {
 	std::string shaderName;						// name of the shader to use
 	bool castShadows = false;				// whether the material should cast shadows
+	bool occluder = false;					// whether meshes using it hide what is behind them from the culler
 };
 
 class MaterialPolicy : public IResourcePolicy<Material, MaterialResourceInfo> {
@@ -111,8 +169,44 @@ public:
 	using MaterialHandle = Handle;
 
 	MaterialHandle LoadFromJSON(const std::string& JSONFilePath);
-	virtual void PreloadResources(const std::string& resourceDirectory) override;
+	// same for a material parsed beforehand, `source` names it in error messages
+	MaterialHandle LoadFromJSONObject(const nlohmann::json& j, const std::string& source);
+	virtual void QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) override;
+
+	// shader of a material without going through the resource map, invalid handle if unknown
+	ShaderManager::Handle GetMaterialShader(MaterialHandle handle) const {
+		return handle.id < materialShaders.size() ? materialShaders[handle.id] : ShaderManager::Handle{};
+	}
+
+	// Materials of one batch group share their shader, textures and uniforms, and only differ in
+	// their material table constants, so they are drawn together. Sort keys use it instead of the dense id.
+	// The group is picked when the material is added, materials that change textures or uniforms
+	// afterwards must not use the material table.
+	uint32_t GetBatchGroup(MaterialHandle handle) const {
+		return handle.id < batchGroups.size() ? batchGroups[handle.id] : 0;
+	}
+
+	// changes the constants a material has in the material table
+	void SetParams(MaterialHandle handle, const MaterialParams& params);
+	// material table constants indexed by dense id, copied into `out` only if they changed since `version`.
+	// Safe to call from the render thread while the game thread sets constants.
+	bool CopyParamsIfChanged(uint32_t& version, std::vector<MaterialParams>& out) const;
 
 	friend class ModelPolicy;
+protected:
+	void OnResourceAdded(Handle handle, const Material& material) override;
+private:
+	// registers what the policy created, or reports why it could not
+	MaterialHandle AddCreated(std::tuple<Material, std::string, std::string> created, const std::string& source);
+
+	std::vector<ShaderManager::Handle> materialShaders; // indexed by handle id
+
+	std::vector<uint32_t> batchGroups;								// indexed by handle id
+	std::unordered_map<std::string, uint32_t> sharedBatchGroups;	// state signature of material table users -> batch group
+	uint32_t nextBatchGroup = 1;
+
+	mutable std::mutex paramsMutex;
+	std::vector<MaterialParams> params;	// indexed by dense id
+	uint32_t paramsVersion = 1;
 };
 
@@ -1,12 +1,21 @@
 #pragma once
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <optional>
+#include <span>
 
 #include "ResourceManagerTemplate.h"
 #include "Engine/Renderer/Culling/BoundingBox.h"
+#include "Engine/Renderer/InstanceStreamBuffer.h"
+
+#define MESH_MAX_LODS 4					// levels of a LOD chain, the full resolution mesh included
+#define MESH_LOD_SCREEN_SIZES { 1.f, 0.2f, 0.08f, 0.03f }	// share of the screen height below which each level is drawn
+#define MESH_LOD_HYSTERESIS 0.15f			// a level is entered this much below its size and left this much above it
+#define MESH_LOD_SHADOW_BIAS 1				// levels coarser than the main pass the shadow pass draws
 
 //forward declaration
 class MeshManager;
-struct InstanceDataGUI;
 
 struct VertexAttribute {
 	GLuint index;			// attribute loctation in shader
@@ -21,10 +30,14 @@ struct Mesh : IResource {
 	GLuint vbo;				
 	GLuint ebo;
 
-	GLuint instanceVBO = 0; // optional instance VBO for instanced rendering
+	// instance attributes currently point into this stream buffer generation (0 if never bound)
+	uint32_t instanceStreamGeneration = 0;
+	InstanceLayout instanceLayout = InstanceLayout::Model;
 
-	std::vector<uint8_t> vertexData;
-	std::vector<uint32_t> indices;
+	// CPU side copy the occlusion culler rasterizes, views into `storage`
+	std::shared_ptr<const void> storage;
+	std::span<const uint8_t> vertexData;
+	std::span<const uint32_t> indices;
 
 	std::vector<VertexAttribute> attributes;
 
@@ -33,23 +46,27 @@ struct Mesh : IResource {
 	uint32_t vertexStride = 0;
 	uint32_t vertexCount = 0;
 	uint32_t indexCount = 0;
+	GLenum indexType = GL_UNSIGNED_INT;	// GL_UNSIGNED_SHORT on the GPU when every index fits
+
+	// maps quantized positions into object space, identity for float positions
+	glm::mat4 positionDecode = glm::mat4(1.f);
 
 	BoundingBox boundingBox;
 	bool cullBackfaces = true;
 
-	bool isGuiMesh = false; // if true, instance data includes uv offsets
+	// dense id of every mesh created by MeshPolicy, used in sort keys of meshes that are not in the manager
+	uint32_t sortId = 0;
 
 	void Bind() const;
 
-	void EnableInstancing(bool vaoAlreadyBound);
-	void UploadInstancedData(const void* data, size_t count);
-	void UploadInstanceDataGUI(const InstanceDataGUI* data);
-	bool isInstancingEnabled() const { return instanceVBO != 0; }
+	// points the instance attributes of the (already bound) vao into the stream buffer, if not already
+	void BindInstanceStream(const InstanceStreamBuffer& stream, InstanceLayout layout);
 
 private:
 	static MeshManager* _mm;
 
 	friend class MeshManager;
+	friend class MeshPolicy;
 };
 
 struct MeshResoruceInfo {
@@ -60,7 +77,14 @@ struct MeshResoruceInfo {
 
 	BoundingBox boundingBox;
 	bool cullBackfaces = true;
-	bool isGuiMesh = false;
+
+	glm::mat4 positionDecode = glm::mat4(1.f);	// see Mesh::positionDecode
+
+	// Used instead of the vectors above if set: data owned by `storage`, like a mapped cooked model,
+	// that meshes upload and keep without copying it.
+	std::shared_ptr<const void> storage = nullptr;
+	std::span<const uint8_t> storedVertexData = {};
+	std::span<const uint32_t> storedIndices = {};
 };
 
 class MeshPolicy : public IResourcePolicy<Mesh, MeshResoruceInfo> {
@@ -72,6 +96,44 @@ public:
 	void Destroy(Mesh& res) override;
 private:
 	void Upload(Mesh* mesh);
+
+	static DenseIdTable sortIds;
+};
+
+// =========================================================
+// MeshLodChain
+//
+// A mesh and its coarser versions, with the projected size (share of the screen height
+// its bounds cover) below which each level takes over.
+// =========================================================
+struct MeshLodChain {
+	SafeHandle levels[MESH_MAX_LODS];
+	float screenSizes[MESH_MAX_LODS] = MESH_LOD_SCREEN_SIZES;
+	uint8_t count = 0;
+
+	// level for a projected size, staying on `previous` within the hysteresis band
+	uint8_t Select(float screenSize, uint8_t previous) const {
+		uint8_t level = 0;
+		for (uint8_t l = 1; l < count; ++l) {
+			float threshold = screenSizes[l] * (l <= previous ? 1.f + MESH_LOD_HYSTERESIS : 1.f - MESH_LOD_HYSTERESIS);
+			if (screenSize >= threshold) break;
+			level = l;
+		}
+		return level;
+	}
+};
+
+// =========================================================
+// MeshImpostor
+//
+// Camera facing quad a mesh is drawn as past `distance`, see ImpostorBaker.
+// The quad frame maps primitive/quad_backface onto the bounding sphere of the mesh.
+// =========================================================
+struct MeshImpostor {
+	SafeHandle quad;
+	SafeHandle material;
+	glm::mat4 quadFrame = glm::mat4(1.f);
+	float distance = 0.f;
 };
 
 class MeshManager : public ResourceManagerTemplate<Mesh, MeshPolicy>
@@ -85,7 +147,35 @@ public:
 	void UseMesh(const MeshHandle& h);
 	void UseMesh(const Mesh& mesh);
 	void UseMesh(const std::string& name);
+	// binds no VAO, for code that bound its own VAO or left one bound
+	void UnbindMesh();
+
+	// Position decode of meshes with quantized positions, nullptr for float positions.
+	// Instances of those meshes draw with modelMatrix * decode, plain array lookup for the batch builder
+	const glm::mat4* GetPositionDecode(MeshHandle handle) const {
+		return handle.id < positionDecodes.size() && positionDecodes[handle.id] ? &*positionDecodes[handle.id] : nullptr;
+	}
+
+	// Coarser levels of a mesh, level 0 being the mesh itself. nullptr if it has none,
+	// plain array lookup for the render queue
+	void SetLodChain(MeshHandle handle, const MeshLodChain& chain);
+	const MeshLodChain* GetLodChain(MeshHandle handle) const {
+		return handle.id < lodChains.size() && lodChains[handle.id].count > 1 ? &lodChains[handle.id] : nullptr;
+	}
+
+	// Impostor of a mesh, nullptr if it has none. Set for every level of a LOD chain,
+	// plain array lookup for the render queue and the batch builder
+	void SetImpostor(MeshHandle handle, const MeshImpostor& impostor);
+	const MeshImpostor* GetImpostor(MeshHandle handle) const {
+		return handle.id < impostors.size() && impostors[handle.id].material.IsValid() ? &impostors[handle.id] : nullptr;
+	}
 
 	GLuint currentVAO = 0;
+protected:
+	void OnResourceAdded(Handle handle, const Mesh& mesh) override;
+private:
+	std::vector<std::optional<glm::mat4>> positionDecodes; // indexed by handle id
+	std::vector<MeshLodChain> lodChains; // indexed by handle id of level 0
+	std::vector<MeshImpostor> impostors; // indexed by handle id
 };
 
@@ -0,0 +1,39 @@
+#pragma once
+#include "MeshManager.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#define MESH_OPTIMIZE_ON_IMPORT 1		// 0 keeps the triangle and vertex order meshes are imported or generated with
+#define MESH_OPTIMIZER_CACHE_SIZE 16	// post-transform cache the triangle order is tuned for
+
+// =========================================================
+// MeshOptimizer
+//
+// Reorders indexed triangle lists at import time, without changing what is drawn:
+// - triangles for the post-transform vertex cache (Tipsify),
+// - clusters of those triangles so the outward facing ones draw first, which reduces overdraw,
+// - vertices in the order the triangles first use them, for the vertex fetch.
+// Runs before the mesh is created, so it costs nothing per frame.
+// =========================================================
+namespace MeshOptimizer
+{
+	struct Statistics
+	{
+		float acmr = 0.f;	// average cache miss ratio, vertex shader runs per triangle (0.5 at best, 3 at worst)
+		float atvr = 0.f;	// average transformed vertex ratio, vertex shader runs per vertex (1 at best)
+	};
+
+	// simulates a FIFO cache of MESH_OPTIMIZER_CACHE_SIZE entries
+	Statistics Analyze(const std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+	// reorders the triangles and vertices of a triangle list mesh, logging the statistics before and after.
+	// Meshes whose data is in `storage` are left alone, they were optimized when they were cooked
+	void Optimize(MeshResoruceInfo& info, const std::string& name);
+
+	// object space positions of attribute 0 (float or unorm16 through the position decode), empty for other formats
+	std::vector<glm::vec3> ReadPositions(const MeshResoruceInfo& info);
+	// stores the vertices in the order the indices first reference them, unreferenced ones are dropped
+	void CompactVertices(MeshResoruceInfo& info);
+}
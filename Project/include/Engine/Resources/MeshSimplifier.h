@@ -0,0 +1,29 @@
+#pragma once
+#include "MeshManager.h"
+
+#include <string>
+#include <vector>
+
+#define MESH_LOD_ON_IMPORT 1			// 0 imports models without LOD chains
+#define MESH_LOD_RATIOS { 0.5f, 0.25f, 0.1f }	// triangles of each coarser level, as a share of the full mesh
+#define MESH_LOD_MAX_ERROR 0.05f		// largest distance a collapse may move the surface, as a share of the bounds diagonal
+
+// =========================================================
+// MeshSimplifier
+//
+// Builds coarser versions of triangle list meshes by collapsing edges onto one of their vertices,
+// cheapest first by the quadric error metric (Garland and Heckbert).
+// Vertices only ever move onto other vertices, so a level reuses the vertex format,
+// the attributes and the position decode of the mesh it was built from.
+// UV seams collapse along the seam only and open borders are kept, so neither tears.
+// =========================================================
+namespace MeshSimplifier
+{
+	// indices of a version of the mesh with about targetIndexCount indices, or fewer collapses
+	// if going further would move the surface more than maxError (a share of the bounds diagonal)
+	std::vector<uint32_t> Simplify(const MeshResoruceInfo& info, size_t targetIndexCount, float maxError);
+
+	// coarser levels for the LOD chain of a mesh, see MESH_LOD_RATIOS.
+	// Stops early once a level does not get meaningfully smaller than the one before
+	std::vector<MeshResoruceInfo> BuildLodChain(const MeshResoruceInfo& info, const std::string& name);
+}
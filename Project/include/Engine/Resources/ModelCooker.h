@@ -0,0 +1,96 @@
+#pragma once
+#include "ModelManager.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <string>
+#include <cstdint>
+
+#define COOKED_MODEL_MAGIC 0x434C444Du		// "MDLC"
+#define COOKED_MODEL_VERSION 3				// bump whenever the layout or the import settings change
+#define COOKED_MODEL_EXTENSION ".mdlc"
+#define COOKED_MODEL_MAX_ATTRIBUTES 8
+#define COOKED_MODEL_ALIGNMENT 16			// blobs start at multiples of this, so they can be used in place
+
+// import toggles baked into the cooked data, files cooked with other settings are stale
+#define COOKED_MODEL_IMPORT_SETTINGS ((MESH_OPTIMIZE_ON_IMPORT ? 1u : 0u) | (MODEL_PACKED_VERTICES ? 2u : 0u) | (MESH_LOD_ON_IMPORT ? 4u : 0u))
+
+// =========================================================
+// Cooked model file
+//
+// Header, then one CookedMesh per mesh, each followed by those of its LOD levels,
+// then the blobs the table points at.
+// Vertex and index blobs are in the layout the GPU buffers use, so the loader uploads
+// straight from the mapped file. The stamps of the source model and its mat.json
+// tell whether the file is stale.
+// =========================================================
+struct CookedFileStamp {
+	uint64_t size = 0;
+	int64_t writeTime = 0;	// 0 with size 0 if the file does not exist
+
+	bool operator==(const CookedFileStamp& other) const { return size == other.size && writeTime == other.writeTime; }
+};
+
+// stamps of the files cooked data is built from, a model and the mat.json next to it
+struct CookedSourceStamps {
+	CookedFileStamp source;
+	CookedFileStamp materials;
+
+	bool operator==(const CookedSourceStamps& other) const { return source == other.source && materials == other.materials; }
+};
+
+struct CookedModelHeader {
+	uint32_t magic = COOKED_MODEL_MAGIC;
+	uint32_t version = COOKED_MODEL_VERSION;
+	uint32_t importSettings = COOKED_MODEL_IMPORT_SETTINGS;
+	uint32_t padding = 0;
+	CookedSourceStamps stamps;
+	uint32_t meshCount = 0;			// entries of the mesh table, LOD levels included
+	uint32_t materialsLength = 0;	// mat.json text, 0 if there is none
+	uint64_t materialsOffset = 0;
+};
+
+struct CookedAttribute {
+	uint32_t index;
+	int32_t size;
+	uint32_t type;
+	uint32_t offset;
+	uint32_t normalized;
+};
+
+struct CookedMesh {
+	uint64_t nameOffset;
+	uint32_t nameLength;
+	uint32_t stride;
+	uint64_t vertexOffset;
+	uint64_t vertexSize;
+	uint64_t indexOffset;
+	uint32_t indexCount;
+	uint32_t attributeCount;
+	CookedAttribute attributes[COOKED_MODEL_MAX_ATTRIBUTES];
+	float boundsMin[3];
+	float boundsMax[3];
+	float positionDecode[16];	// column major
+	uint32_t cullBackfaces;
+	uint32_t lodLevel;		// 0 for a mesh, n for the nth coarser level of the last mesh before it
+};
+
+// =========================================================
+// ModelCooker
+//
+// Writes and reads cooked models, the files live next to their source model.
+// Models are cooked the first time they are imported and again whenever the source or its mat.json change.
+// =========================================================
+namespace ModelCooker
+{
+	std::string GetCookedPath(const std::string& modelFilePath);
+	CookedFileStamp GetStamp(const std::string& path);
+	// current stamps of the model and its mat.json, data cooked with other stamps is stale
+	CookedSourceStamps GetSourceStamps(const std::string& modelFilePath);
+
+	// false if the file could not be written
+	bool Write(const std::string& modelFilePath, const ModelImport& modelImport);
+	// maps the cooked file of the model, the meshes of `out` point into the mapping.
+	// False if it is missing, stale or broken, the model has to be imported again then
+	bool Read(const std::string& modelFilePath, ModelImport& out);
+}
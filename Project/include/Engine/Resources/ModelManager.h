@@ -2,16 +2,21 @@
 #include "ResourceManagerTemplate.h"
 #include "MeshManager.h"
 #include "MaterialManager.h"
+#include "ImpostorBaker.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#define MODEL_PACKED_VERTICES 1	// 16 byte quantized vertices for imported models, 0 keeps float vertices
+
 struct Model : public IResource {
 	struct MeshEntry {
 		std::string name;            // Name from Assimp
 		MeshManager::Handle mesh;    // Handle to the loaded mesh
 		MaterialManager::Handle material; 
+		std::vector<MeshManager::Handle> lods;	// coarser levels of the mesh, also registered as its MeshLodChain
+		MaterialManager::Handle impostor;		// material of its impostor, also registered as its MeshImpostor
 	};
 	std::vector<MeshEntry> meshEntries;
 	std::unordered_map<std::string, uint32_t> meshNameToIndex;
@@ -21,6 +26,23 @@ struct ModelResourceInfo {
 	std::string modelFilePath;
 };
 
+// meshes and materials of a model file, converted without GL calls or manager access
+// so the import can run on a loader thread
+struct ModelImport {
+	struct ImportedMesh {
+		std::string name;
+		MeshResoruceInfo mesh;
+		std::vector<MeshResoruceInfo> lods;	// coarser levels, see MeshSimplifier
+	};
+	std::vector<ImportedMesh> meshes;
+	nlohmann::json materials;	// the mat.json next to the model, null if there is none
+	std::string filePath;		// of the source model
+	// cached impostor atlases, read with the model if its mat.json sets "impostorDistance".
+	// Meshes without one are baked when the model is created
+	std::vector<ImpostorAtlas> impostors;
+	bool valid = false;
+};
+
 class ModelPolicy : public IResourcePolicy<Model, ModelResourceInfo> {
 public:
 	using ResourceType = Model;
@@ -29,14 +51,26 @@ public:
 	Model Create(const std::string& name, const ModelResourceInfo& resourceInfo) override;
 	void Destroy(Model& res) override;
 
+	// reads the cooked model if it is up to date, imports the source with Assimp and cooks it otherwise
+	ModelImport Import(const ModelResourceInfo& resourceInfo);
+	Model CreateFromImport(const std::string& name, const ModelImport& modelImport);
+
 private:
-	void LoadMaterialsFromJSON(const std::string& JSONFilePath, Model& model);
+	ModelImport ImportSource(const ModelResourceInfo& resourceInfo);
+	void LoadMaterials(const nlohmann::json& j, Model& model);
+	// creates the impostor textures and materials of every mesh, baking and caching the atlases that were not cached
+	void LoadImpostors(const std::string& name, const ModelImport& modelImport, float distance, Model& model);
 };
 
 class ModelManager : public ResourceManagerTemplate<Model, ModelPolicy> {
 public:
 	using ModelHandle = Handle;
 
-	virtual void PreloadResources(const std::string& resourceDirectory) override;
+	ModelHandle LoadFromImport(const std::string& name, const ModelImport& modelImport);
+
+	// cooks every model of the directory that has no up to date cooked file, needs no GL context
+	static void CookModels(const std::string& resourceDirectory);
+
+	virtual void QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) override;
 };
 
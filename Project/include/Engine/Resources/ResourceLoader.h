@@ -0,0 +1,84 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#define RESOURCE_LOADER_MAX_THREADS 8
+#define RESOURCE_LOADER_NO_BUDGET -1.0	// Pump budget that runs until everything is loaded
+
+// what a loader job produces, uploads of a kind wait for the kinds it depends on
+enum class ResourceKind : uint8_t
+{
+	Shader,
+	Texture,
+	TextureAtlas,	// needs the textures it packs
+	Mesh,
+	Material,		// needs shaders and textures
+	Model,			// needs materials
+	Count
+};
+
+// =========================================================
+// ResourceLoader
+//
+// Loads resources in two steps. The prepare step reads, decodes and parses on the loader threads,
+// it must not call GL or change any manager. It returns the upload step, which creates the GL objects
+// and registers the resource on the thread calling Pump, the one owning the GL context.
+// Every job is added before Start, so the loader knows when a kind is complete.
+// =========================================================
+class ResourceLoader
+{
+public:
+	using UploadFunction = std::function<void()>;
+	// returns an empty function if the resource could not be loaded
+	using PrepareFunction = std::function<UploadFunction()>;
+
+	// 0 picks one thread per spare hardware thread, up to RESOURCE_LOADER_MAX_THREADS
+	ResourceLoader(uint32_t threadCount = 0);
+	~ResourceLoader();
+
+	ResourceLoader(const ResourceLoader&) = delete;
+	ResourceLoader& operator=(const ResourceLoader&) = delete;
+
+	void Add(ResourceKind kind, const std::string& name, PrepareFunction prepare);
+	void Start();
+
+	// runs uploads whose dependencies are met for about budgetMs, waiting for prepare steps if none is ready.
+	// Returns true once every job is uploaded
+	bool Pump(double budgetMs);
+
+	bool IsDone() const { return uploadedJobs == jobs.size(); }
+	// share of the jobs uploaded, for loading screens
+	float GetProgress() const { return jobs.empty() ? 1.f : float(uploadedJobs) / float(jobs.size()); }
+private:
+	struct Job
+	{
+		ResourceKind kind;
+		std::string name;
+		PrepareFunction prepare;
+		UploadFunction upload;
+	};
+
+	uint32_t threadCount;
+	std::vector<std::thread> threads;
+	std::vector<Job> jobs;	// not resized once started
+
+	std::atomic<size_t> nextPrepare{ 0 };
+
+	std::mutex mutex;
+	std::condition_variable preparedCondition;
+	std::vector<size_t> prepared;	// jobs waiting for their upload, in the order they finished
+
+	// only touched by the pumping thread
+	std::array<size_t, size_t(ResourceKind::Count)> pendingUploads{};
+	size_t uploadedJobs = 0;
+
+	void ThreadLoop();
+	bool DependenciesUploaded(ResourceKind kind) const;
+};
@@ -5,12 +5,23 @@
 #include "MaterialManager.h"
 #include "MeshManager.h"
 #include "ModelManager.h"
+#include "ResourceLoader.h"
+
+#include <memory>
 
 class ResourceManager
 {
 public:
     static ResourceManager& Get();
 
+	// Starts loading every resource of the directory on loader threads.
+	// Call PumpPreload from the thread owning the GL context until it returns true.
+	void BeginPreload(const std::string& resourceDirectory);
+	// creates loaded resources for about budgetMs, returns true once everything is loaded
+	bool PumpPreload(double budgetMs);
+	float GetPreloadProgress() const { return loader ? loader->GetProgress() : (preloaded ? 1.f : 0.f); }
+
+	// loads everything before returning
 	void PreloadResources(const std::string& resourceDirectory);
 	bool AreResourcesPreloaded() const { return preloaded; }
 
@@ -23,6 +34,6 @@ public:
 private:
     ResourceManager() = default;
 
+	std::unique_ptr<ResourceLoader> loader;	// only while preloading
 	bool preloaded = false;
 };
-
@@ -4,6 +4,11 @@
 #include <cstdint>
 #include <iostream>
 #include <filesystem>
+#include <vector>
+
+#include "DenseIdTable.h"
+
+class ResourceLoader;
 
 struct SafeHandle {
     uint32_t id = 0;
@@ -81,6 +86,8 @@ public:
         resources[id] = { res, gen };
         nameToHandle[name] = Handle{ id, gen };
         handleToName[id] = name;
+        AssignDenseId(id);
+        OnResourceAdded(Handle{ id, gen }, resources[id].resource);
 
         return Handle{ id, gen };
     }
@@ -96,9 +103,23 @@ public:
         resources[id] = { resource, gen };
         nameToHandle[name] = Handle{ id, gen };
         handleToName[id] = name;
+        AssignDenseId(id);
+        OnResourceAdded(Handle{ id, gen }, resources[id].resource);
         return Handle{ id, gen };
 	}
 
+    // -----------------------------
+    // Dense ids
+    // -----------------------------
+    // Small id assigned at load time, unique among the live resources of this manager (0 if not loaded).
+    // Plain array lookup, meant for hot paths like sort keys.
+    uint32_t GetDenseId(Handle handle) const {
+        return handle.id < handleToDense.size() ? handleToDense[handle.id] : 0;
+    }
+
+    // every dense id is at most this
+    uint32_t GetMaxDenseId() const { return denseIds.GetHighestId(); }
+
     // -----------------------------
     // Direct handle-based access
     // -----------------------------
@@ -154,6 +175,9 @@ public:
 
             handleToName.erase(handle.id);
             resources.erase(it);
+
+            denseIds.Release(handleToDense[handle.id]);
+            handleToDense[handle.id] = 0;
         }
     }
 
@@ -167,10 +191,14 @@ public:
 	// -----------------------------
     // Preload resources
 	// -----------------------------
-    virtual void PreloadResources(const std::string& resourceDirectory) {
+    // adds a job per resource of the directory, see ResourceLoader
+    virtual void QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) {
 	}
 
 protected:
+    // called once a resource got its handle, for managers that keep extra per-resource tables
+    virtual void OnResourceAdded(Handle handle, const ResourceType& resource) {}
+
     struct ResourceSlot {
         ResourceType resource;
         uint32_t generation = 0;
@@ -182,4 +210,13 @@ protected:
     std::unordered_map<uint32_t, ResourceSlot> resources;
     std::unordered_map<std::string, Handle> nameToHandle;
     std::unordered_map<uint32_t, std::string> handleToName;
+
+    // indexed by handle id, handle ids are never reused so the table only grows with the load count
+    std::vector<uint32_t> handleToDense;
+    DenseIdTable denseIds;
+
+    void AssignDenseId(uint32_t id) {
+        if (handleToDense.size() <= id) handleToDense.resize(id + 1, 0);
+        handleToDense[id] = denseIds.Acquire();
+    }
 };
\ No newline at end of file
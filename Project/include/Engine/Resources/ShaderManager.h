@@ -47,6 +47,8 @@ struct Shader : public IResource {
     }
 
     void SetRaw(const std::string& name, GLenum GLtype, const void* data, size_t elementCount);
+    // no lookup or type check, for locations and types resolved from the reflection beforehand
+    void SetRaw(GLint location, GLenum GLtype, const void* data, size_t elementCount) const;
 
 private:
     // reference to the ShaderManager itself (to get access to the currentProgram)
@@ -63,6 +65,13 @@ struct ShaderResourceInfo {
 	std::string geometryPath; // optional
 };
 
+// preprocessed source of every stage, read without GL calls so it can happen on a loader thread
+struct ShaderSources {
+    std::string vertex;
+    std::string fragment;
+    std::string geometry; // empty if the shader has no geometry stage
+};
+
 class ShaderPolicy : public IResourcePolicy<Shader, ShaderResourceInfo> {
 public:
     // These aliases are required by the ResourceManagerTemplate concepts to work
@@ -72,6 +81,9 @@ public:
     Shader Create(const std::string& name, const ShaderResourceInfo& resourceInfo) override;
     void Destroy(Shader& res) override;
 
+    ShaderSources LoadSources(const ShaderResourceInfo& resourceInfo);
+    Shader CreateFromSources(const std::string& name, const ShaderSources& sources);
+
 private:
     std::string LoadFile(const std::string& path);
     GLuint Compile(GLenum type, const std::string& src);
@@ -80,6 +92,7 @@ private:
 	// Reflection helpers
 	static void ReflectUniforms(GLuint program, ShaderReflection& out);
 	static void ReflectUniformBlocks(GLuint program, ShaderReflection& out);
+	static void ReflectStorageBlocks(GLuint program, ShaderReflection& out);
 	static void Reflect(GLuint program, ShaderReflection& out);
 
     static ShaderManager* _sm;
@@ -98,7 +111,9 @@ public:
 	void UseShader(const Shader& shader);
 	void UseShader(const std::string& name, GLStateCache* glState = nullptr);
 
-	virtual void PreloadResources(const std::string& resourceDirectory) override;
+	ShaderHandle LoadFromSources(const std::string& name, const ShaderSources& sources);
+
+	virtual void QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) override;
 
 	bool HasInclude() const { return hasInclude; } 
 	std::string GetDefineFileSource() const { return defineFileSource; }
@@ -9,12 +9,34 @@
 #include <glm/gtc/type_aligned.hpp>
 
 #include <stdexcept>
+#include <string_view>
+#include <cstdint>
 
 
 /*
 * Structures to hold reflection info about shader uniforms and uniform blocks.
 */
 
+// FNV-1a hash of a uniform, field or block name, usable at compile time.
+constexpr uint32_t HashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// UniformHandle indexes the flat arrays names are resolved into once (UBO fields, material uniforms and textures),
+// so hot paths set values without any string work.
+struct UniformHandle {
+    static constexpr uint32_t Invalid = UINT32_MAX;
+    uint32_t index = Invalid;
+
+    bool IsValid() const { return index != Invalid; }
+    bool operator==(const UniformHandle& other) const { return index == other.index; }
+};
+
 
 // UniformInfo holds information about a single uniform variable or array in a shader program.
 struct UniformInfo {
@@ -65,12 +87,15 @@ public:
     std::unordered_map<std::string, UniformInfo> uniforms;
     std::unordered_map<std::string, UniformBlockInfo> uniformBlocks;
     std::unordered_map<std::string, SamplerInfo> samplers;
+    std::unordered_map<std::string, GLuint> storageBlocks;      // shader storage block name -> binding point
 
     bool HasUniform(const std::string& name) const;
 	const UniformInfo* GetUniform(const std::string& name) const;
 
 	bool HasBlock(const std::string& name) const;
 	const UniformBlockInfo* GetBlock(const std::string& name) const;
+
+	bool HasStorageBlock(const std::string& name) const { return storageBlocks.contains(name); }
 };
 
 // Util function to get string representation of GL types
@@ -0,0 +1,54 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// =========================================================
+// TextureAtlasPacker
+//
+// Packs small RGBA images into one square atlas, on shelves filled tallest image first.
+// Every image is surrounded by a gutter of repeated edge texels,
+// so sampling at its border never picks up a neighbour.
+// Rows go bottom to top like the images TextureManager uploads.
+// =========================================================
+class TextureAtlasPacker
+{
+public:
+	struct Region
+	{
+		std::string name;
+		int x = 0, y = 0;			// texels, without the gutter
+		int width = 0, height = 0;
+	};
+
+	TextureAtlasPacker(int size, int padding);
+
+	// copies the image, it is placed by Pack
+	void Add(const std::string& name, int width, int height, const uint8_t* rgba);
+	// places every added image, false if they do not all fit
+	bool Pack();
+
+	int GetSize() const { return size; }
+	const std::vector<uint8_t>& GetPixels() const { return pixels; }
+	const std::vector<Region>& GetRegions() const { return regions; }
+	// x, y, width, height of a region in the uv space of the atlas
+	glm::vec4 GetUvRect(const Region& region) const;
+private:
+	struct Image
+	{
+		std::string name;
+		int width, height;
+		std::vector<uint8_t> rgba;
+	};
+
+	int size;
+	int padding;
+	std::vector<Image> images;
+
+	std::vector<uint8_t> pixels;
+	std::vector<Region> regions;
+
+	void Blit(const Image& image, int x, int y);
+};
@@ -1,14 +1,33 @@
 #pragma once
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include <optional>
 
 #include "ResourceManagerTemplate.h"
 
+class TextureAtlasPacker;
+
+// lists the atlases small textures are packed into, relative to the textures directory
+#define TEXTURE_ATLAS_MANIFEST "atlases.json"
+
+// pixels of an image file, rows bottom to top like GL expects them.
+// Decoding makes no GL calls, so it can run on a loader thread
+struct TextureImage {
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	std::vector<uint8_t> pixels;
+
+	// 0 keeps the channels of the file
+	bool Decode(const std::string& path, int desiredChannels = 0);
+};
+
 struct Texture : public IResource {
 	Texture() = default;
 	~Texture() override = default;
 
 	bool LoadFromFile(const std::string& path, bool generateMipmaps = true);
+	bool LoadFromImage(const TextureImage& image, bool generateMipmaps = true);
 	void Destroy();
 
 	void Bind(GLuint unit = 0, bool bindToUnit = true) const;
@@ -56,6 +75,17 @@ class TextureManager : public ResourceManagerTemplate<Texture, TexturePolicy> {
 public:
 	using TextureHandle = Handle;
 
+	// where a texture lives on the GPU, an atlas for packed textures, the texture itself otherwise
+	struct Region {
+		TextureHandle texture;
+		glm::vec4 uvRect = glm::vec4(0.f, 0.f, 1.f, 1.f); // x, y, width, height in uv space of `texture`
+
+		// maps a rect in the uv space of the source texture into the uv space of `texture`
+		glm::vec4 Transform(const glm::vec4& rect) const {
+			return glm::vec4(uvRect.x + rect.x * uvRect.z, uvRect.y + rect.y * uvRect.w, rect.z * uvRect.z, rect.w * uvRect.w);
+		}
+	};
+
 	TextureManager();
 	~TextureManager();
 
@@ -80,6 +110,9 @@ public:
 		int width, int height, int depth,
 		GLenum depthInternalFormat = GL_DEPTH_COMPONENT24);
 
+	// uploads an image decoded beforehand
+	TextureHandle LoadFromImage(const std::string& name, const TextureImage& image, bool generateMipmaps = true);
+
 	bool Bind(const TextureHandle& h, GLint unit, bool bindToUnit = true);
 	bool Bind(const std::string& name, GLint unit, bool bindToUnit = true);
 
@@ -92,7 +125,13 @@ public:
 	void UnbindFromUnit(int unit, bool bindToUnit = true);
 	void UnbindAll();
 
-	virtual void PreloadResources(const std::string& resourceDirectory) override;
+	// no string work, packed textures are looked up by handle id
+	Region GetRegion(const TextureHandle& h) const {
+		if (h.id < regions.size() && regions[h.id].texture.IsValid()) return regions[h.id];
+		return Region{ h };
+	}
+
+	virtual void QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) override;
 private:
 
 	// OpenGL texture unit tracking:
@@ -104,4 +143,10 @@ private:
 	std::unordered_map<TextureHandle, int> handleToUnit;
 
 	int maxUnits = 0;
+
+	// Packed textures keep their own GL texture, so code that binds them directly still works.
+	std::vector<Region> regions; // indexed by handle id, invalid texture if not packed
+
+	void QueueAtlases(ResourceLoader& loader, const std::filesystem::path& texturesDirectory);
+	void UploadAtlas(const std::string& atlasName, const TextureAtlasPacker& packer);
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_aligned.hpp>
 
+#include "ShaderReflection.h"
+
 #define STD140 alignas(16)
 
 // =========================================
@@ -96,6 +98,29 @@ public:
     float get() const { return value; }
 };
 
+// =========================================
+// UboName
+//
+// Name of a global UBO with its HashName computed at compile time,
+// so the renderer finds the UBO writers without string work.
+// =========================================
+struct UboName
+{
+	const char* name;
+	uint32_t hash;
+
+	constexpr explicit UboName(const char* name) : name(name), hash(HashName(name)) {}
+};
+
+namespace GlobalUbo
+{
+	inline constexpr UboName Shadow{ "Shadow" };
+	inline constexpr UboName Lighting{ "Lighting" };
+	inline constexpr UboName Camera{ "Camera" };
+	inline constexpr UboName GUICamera{ "GUICamera" };
+	inline constexpr UboName Time{ "Time" };
+}
+
 // --- UBO Definitions ---
 
 struct STD140 LightingUBO
@@ -113,10 +138,14 @@ struct STD140 ShadowUBO
     fixed_float cascadedSplits[6];
 };
 
-struct STD140 MaterialUBO {
-	float shininess;
-	float specularStrength;
-	float metalicity;
+// one entry of the MaterialTable storage buffer (std430), matches MaterialParams in the shaders
+struct MaterialParams {
+	float shininess = 0.f;
+	float specularStrength = 0.f;
+	float metalicity = 0.f;
+	uint32_t overrideMetalness = 0;
+
+	bool operator==(const MaterialParams& other) const = default;
 };
 
 struct STD140 CameraUBO
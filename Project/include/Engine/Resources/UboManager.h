@@ -3,6 +3,7 @@
 #include "ShaderReflection.h"
 
 #include "UboWriter.h"
+#include "UboDefs.h"
 
 // Forward declaration
 class UboManager;
@@ -39,6 +40,8 @@ public:
 	UboHandle CreateOrGet(const UniformBlockInfo& blockInfo);
 
 	UboWriter* GetUboWriter(const std::string& uboName);
+	// no string work, for the per-frame updates of the global UBOs
+	UboWriter* GetUboWriter(const UboName& uboName);
 
 	GLuint GetAndUseNextBindingPoint();
 
@@ -49,5 +52,7 @@ private:
 	GLuint nextBindingPoint = 0;
 
 	std::unordered_map<std::string, UboWriter> uboWriters;
+	// HashName of each UBO name with its writer, a handful of entries so a linear scan beats the map
+	std::vector<std::pair<uint32_t, UboWriter*>> writersByHash;
 };
 
@@ -13,45 +13,47 @@
 #include "Ubo.h"
 
 // Utility class to write data into UBOs
+// Fields are addressed by UniformHandle, resolve names once with GetFieldHandle and keep the handle,
+// the string overloads resolve the name on every call.
 class UboWriter
 {
 public:
 	UboWriter(const UniformBlockInfo* uboInfo);
 
+    // invalid handle if the block has no such field
+    UniformHandle GetFieldHandle(const std::string& memberName) const;
+    // same for a name hashed with HashName, usually at compile time
+    UniformHandle GetFieldHandle(uint32_t nameHash) const;
+
     template<typename T>
-    bool Set(const std::string& memberName, const T& value, int arrayIndex = 0) {
-        auto it = std::find_if(
-            ubo->fields.begin(),
-            ubo->fields.end(),
-            [&memberName](const UniformBlockFieldInfo& field) { return field.name == memberName; }
-        );
-        if (it == ubo->fields.end())
+    bool Set(UniformHandle field, const T& value, int arrayIndex = 0) {
+        if (!field.IsValid())
             return false;
 
-        const UniformBlockFieldInfo& m = *it;
+        const UniformBlockFieldInfo& m = ubo->fields[field.index];
 
 		// clamp arrayIndex
 		arrayIndex = std::clamp(arrayIndex, 0, m.size - 1);
 
 		size_t offset = m.offset + arrayIndex * m.arrayStride;
 
-        memcpy(data.data() + offset, &value, sizeof(T));
+        memcpy(data.data() + offset, ValuePtr(value), sizeof(T));
 		dirty = true;
         return true;
     }
 
+    template<typename T>
+    bool Set(const std::string& memberName, const T& value, int arrayIndex = 0) {
+        return Set(GetFieldHandle(memberName), value, arrayIndex);
+    }
+
     template <typename T>
-    bool SetArray(const std::string& memberName, std::span<const T> values)
+    bool SetArray(UniformHandle field, std::span<const T> values)
     {
-        auto it = std::find_if(
-            ubo->fields.begin(),
-            ubo->fields.end(),
-            [&](const UniformBlockFieldInfo& f) { return f.name == memberName; }
-        );
-        if (it == ubo->fields.end())
+        if (!field.IsValid())
             return false;
 
-        const UniformBlockFieldInfo& m = *it;
+        const UniformBlockFieldInfo& m = ubo->fields[field.index];
 
         // array must not exceed the declared size
         size_t writeCount = std::min(values.size(), static_cast<size_t>(m.size));
@@ -60,94 +62,38 @@ public:
         for (size_t i = 0; i < writeCount; i++)
         {
             size_t offset = m.offset + i * m.arrayStride;
-            memcpy(data.data() + offset, &values[i], sizeof(T));
+            memcpy(data.data() + offset, ValuePtr(values[i]), sizeof(T));
         }
         dirty = true;
         return true;
     }
 
     template <typename T>
-    bool SetArray(const std::string& memberName, const std::vector<T>& values) {
-        return SetArray(memberName, std::span<const T>(values.begin(), values.size()));
+    bool SetArray(UniformHandle field, const std::vector<T>& values) {
+        return SetArray(field, std::span<const T>(values.begin(), values.size()));
     }
 
     template <typename T>
-    bool SetArray(const std::string& memberName, std::initializer_list<T> values)
-    {
-        return SetArray(memberName, std::span<const T>(values.begin(), values.size()));
-    }
-
-	// Specialization for glm types
-	template<GlmType T>
-    bool Set(const std::string& memberName, const T& value, int arrayIndex = 0) {
-        auto it = std::find_if(
-            ubo->fields.begin(),
-            ubo->fields.end(),
-            [&memberName](const UniformBlockFieldInfo& field) { return field.name == memberName; }
-        );
-        if (it == ubo->fields.end())
-            return false;
-
-        const UniformBlockFieldInfo& m = *it;
-
-        // clamp arrayIndex
-        arrayIndex = std::clamp(arrayIndex, 0, m.size - 1);
-
-        size_t offset = m.offset + arrayIndex * m.arrayStride;
-
-        memcpy(data.data() + offset, glm::value_ptr(value), sizeof(T));
-        dirty = true;
-        return true;
+    bool SetArray(const std::string& memberName, std::span<const T> values) {
+        return SetArray(GetFieldHandle(memberName), values);
     }
 
-    template <GlmType T>
-    bool SetArray(const std::string& memberName, std::span<const T> values)
-    {
-        auto it = std::find_if(
-            ubo->fields.begin(),
-            ubo->fields.end(),
-            [&](const UniformBlockFieldInfo& f) { return f.name == memberName; }
-        );
-        if (it == ubo->fields.end())
-            return false;
-
-        const UniformBlockFieldInfo& m = *it;
-
-        size_t writeCount = std::min(values.size(), static_cast<size_t>(m.size));
-        size_t elementSize = sizeof(T);
-
-        for (size_t i = 0; i < writeCount; i++)
-        {
-            size_t offset = m.offset + i * m.arrayStride;
-            memcpy(data.data() + offset, glm::value_ptr(values[i]), elementSize);
-        }
-        dirty = true;
-        return true;
-    }
-
-    template <GlmType T>
+    template <typename T>
     bool SetArray(const std::string& memberName, const std::vector<T>& values) {
-        return SetArray(memberName, std::span<const T>(values.begin(), values.size()));
+        return SetArray(GetFieldHandle(memberName), std::span<const T>(values.begin(), values.size()));
     }
 
-    // initializer_list overload
-    template <GlmType T>
+    template <typename T>
     bool SetArray(const std::string& memberName, std::initializer_list<T> values)
     {
-        return SetArray(memberName, std::span<const T>(values.begin(), values.size()));
+        return SetArray(GetFieldHandle(memberName), std::span<const T>(values.begin(), values.size()));
     }
 
     // Raw setter for custom sizes
-    template <typename T>
-    bool SetRaw(const std::string& memberName, const void* valuePtr, size_t size, int arrayIndex = 0) {
-        auto it = std::find_if(
-            ubo->fields.begin(),
-            ubo->fields.end(),
-            [&memberName](const UniformBlockFieldInfo& field) { return field.name == memberName; }
-        );
-        if (it == ubo->fields.end())
+    bool SetRaw(UniformHandle field, const void* valuePtr, size_t size, int arrayIndex = 0) {
+        if (!field.IsValid())
             return false;
-        const UniformBlockFieldInfo& m = *it;
+        const UniformBlockFieldInfo& m = ubo->fields[field.index];
         // clamp arrayIndex
         arrayIndex = std::clamp(arrayIndex, 0, m.size - 1);
         size_t offset = m.offset + arrayIndex * m.arrayStride;
@@ -158,6 +104,10 @@ public:
         return true;
 	}
 
+    bool SetRaw(const std::string& memberName, const void* valuePtr, size_t size, int arrayIndex = 0) {
+        return SetRaw(GetFieldHandle(memberName), valuePtr, size, arrayIndex);
+    }
+
     // Setter for entire block
 	template <typename T>
     bool SetBlock(const T& block) {
@@ -172,6 +122,7 @@ public:
 	}
 
 	const UniformBlockInfo* GetUboInfo() const { return ubo; }
+	const std::vector<uint8_t>& GetData() const { return data; }
 
 	void PrintDebugInfo() const;
 
@@ -181,5 +132,14 @@ private:
 	const UniformBlockInfo* ubo;
 	std::vector<uint8_t> data;
     bool dirty = false;
+
+    // HashName of every field, same order as ubo->fields
+    std::vector<uint32_t> fieldHashes;
+
+    template<typename T>
+    static const void* ValuePtr(const T& value) {
+        if constexpr (GlmType<T>) return glm::value_ptr(value);
+        else return &value;
+    }
 };
 
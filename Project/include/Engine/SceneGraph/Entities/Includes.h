@@ -4,6 +4,7 @@
 #include "Root.h"
 #include "Camera.h"
 #include "Light.h"
+#include "PointLight.h"
 #include "TransformEntity.h"
 #include "Anchor.h"
 #include "RenderEntity.h"
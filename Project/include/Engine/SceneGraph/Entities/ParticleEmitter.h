@@ -2,6 +2,8 @@
 #include "Engine/SceneGraph/Entities/TransformEntity.h"
 #include "Engine/SceneGraph/Entities/RenderEntity.h"
 
+#include <random>
+
 struct ParticleInstanceData
 {
 	glm::vec3 position;     // local-space position
@@ -39,7 +41,7 @@ public:
 	void SetDirection(const glm::vec3& dir) { direction = glm::normalize(dir); }
 private:
 	void ProvideRenderables(std::vector<Renderable>& outRenderables) override;
-	void UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) override;
+	bool UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) override;
 	void UpdateTransform(const glm::mat4& newTransform) override;
 
 	void EmitParticle();
@@ -62,5 +64,8 @@ private:
 
 	float emissionAccumulator = 0.0f;
 
+	// own generator, as emitters are updated from worker threads
+	std::minstd_rand rng;
+
 };
 
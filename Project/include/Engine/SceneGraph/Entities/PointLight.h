@@ -0,0 +1,24 @@
+#pragma once
+#include "TransformEntity.h"
+#include "Engine/Components/PointLightComponent.h"
+
+// ======================================================
+// PointLight
+//
+// A point light that follows its transform, any number of them can light the scene.
+// ======================================================
+class PointLight : public TransformEntity
+{
+public:
+	PointLight(const std::string& name = "PointLight");
+
+	void SetColor(const glm::vec3& color) { pointLightComponent->color = color; }
+	void SetIntensity(float intensity) { pointLightComponent->intensity = intensity; }
+	void SetRadius(float radius) { pointLightComponent->radius = radius; }
+
+	glm::vec3 GetColor() const { return pointLightComponent->color; }
+	float GetIntensity() const { return pointLightComponent->intensity; }
+	float GetRadius() const { return pointLightComponent->radius; }
+private:
+	PointLightComponent* pointLightComponent;
+};
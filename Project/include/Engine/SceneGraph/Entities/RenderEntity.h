@@ -21,7 +21,9 @@ protected:
 	RenderableComponent& GetRenderableComponent() { return *renderableComponent; }
 
 	virtual void ProvideRenderables(std::vector<Renderable>& outRenderables) = 0;
-	virtual void UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) {};
+	// per-frame update, returns true if the renderables were changed
+	// called from worker threads, so it must not touch other entities or shared state
+	virtual bool UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables) { return false; };
 	virtual void UpdateTransform(const glm::mat4& newTransform) {};
 
 	RenderableComponent* renderableComponent;
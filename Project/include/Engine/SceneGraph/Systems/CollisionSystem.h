@@ -5,6 +5,7 @@
 
 //forward declaration
 class TransformEntity;
+class Renderer;
 
 
 struct Contact {
@@ -18,7 +19,7 @@ struct Contact {
 class CollisionSystem : public ISystem
 {
 public:
-	CollisionSystem(Scene* scene, int16_t order = 0, entt::registry* registry = nullptr);
+	CollisionSystem(Scene* scene, int16_t order = 0, entt::registry* registry = nullptr, Renderer* renderer = nullptr);
 	void OnUpdate(double deltaTime) override;
 
 	virtual std::string GetName() const override { return "CollisionSystem"; }
@@ -26,10 +27,12 @@ public:
 	void GiveCollisionShape(Entity* entity, const RigidBodyInitData& rigidBodyData, float mass = 1.0f, bool anchored = false);
 private:
 	entt::registry* registry;
+	Renderer* renderer; // optional, only used to draw the contacts while debug lines are enabled
 
 	void BroadPhase();
 	void NarrowPhase();
 	void ResolveContacts(double deltaTime);
+	void DrawContacts();
 
 	std::vector<std::pair<entt::entity, entt::entity>> candidatePairs;
 	std::vector<Contact> contacts;
@@ -6,6 +6,9 @@
 
 #include "Engine/Components/RenderableComponent.h"
 
+// RenderableComponents updated per worker chunk
+#define RENDER_SYSTEM_EXTRACT_CHUNK 16
+
 // forward declarations
 class Renderer;
 
@@ -13,16 +16,24 @@ class RenderSystem : public ISystem
 {
 public:
 	RenderSystem(Scene* scene, int16_t order, Renderer* renderer, entt::registry* registry = nullptr);
-	~RenderSystem() override = default;
+	~RenderSystem() override;
 	void OnUpdate(double deltaTime) override;
 
 	virtual std::string GetName() const override { return "RenderSystem"; }
 
 	void UpdateTargetCamera(glm::vec3 targetPosition); // called by the TransformSystem when the target entity's transform is updated
 private:
+	// pushes the changes of a component to its proxies in the RenderWorld
+	void SyncProxies(RenderableComponent& renderableC);
+	void RemoveProxies(RenderableComponent& renderableC);
+	void OnRenderableDestroyed(entt::registry& registry, entt::entity entity);
+
 	Renderer* renderer = nullptr;
 	entt::registry* registry = nullptr;
 
+	// components updated this frame, kept to not reallocate every frame
+	std::vector<RenderableComponent*> extractList;
+
 	CameraComponent* cameraComponent = nullptr;	
 	LightComponent* lightComponent = nullptr;
 };
@@ -1,5 +1,9 @@
 #include <Engine/App.h>
 #include "Demo/TestScene.h"
+#include <Engine/Resources/ModelManager.h>
+#include <Engine/Diagnostics/SortBenchmark.h>
+#include <Engine/Diagnostics/SelfTest.h>
+#include <Engine/Diagnostics/HeadlessRenderStats.h>
 
 // ======================================================
 // To create custom behavior, derive from Scene and implement your logic there
@@ -7,6 +11,24 @@
 
 int main(int argc, char* argv[])
 {
+	// "--cook" only cooks the models, as a build step, and exits
+	if (argc > 1 && std::string(argv[1]) == "--cook") {
+		ModelManager::CookModels("resources/");
+		return 0;
+	}
+	// "--bench-sort" times the render queue sort against std::sort, without opening a window
+	if (argc > 1 && std::string(argv[1]) == "--bench-sort") {
+		return SortBenchmark::Run();
+	}
+	// "--selftest" checks the CPU side rendering code against known results, without opening a window
+	if (argc > 1 && std::string(argv[1]) == "--selftest") {
+		return SelfTest::Run();
+	}
+	// "--render-stats <scene>" records a synthetic scene into the null backend and prints what it would draw, without opening a window
+	if (argc > 2 && std::string(argv[1]) == "--render-stats") {
+		return HeadlessRenderStats::Run(argv[2]);
+	}
+
 	App::Init(static_cast<int32_t>(argc), argv);
 	App& app = App::Get("Rocket");
 	app.SetScene(new TestScene());		// Set your custom scene here
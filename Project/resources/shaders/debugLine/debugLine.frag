@@ -2,11 +2,11 @@
 #extension GL_ARB_shading_language_include : require
 #include </defs.glsl> //! #include "../defs.glsl"
 
-out vec4 out_Color;
+in vec4 v_Color;
 
-uniform vec3 color;
+out vec4 out_Color;
 
 void main(void){
 
-	out_Color = vec4(color, 1.0f);
+	out_Color = v_Color;
 }
\ No newline at end of file
@@ -2,10 +2,11 @@
 #extension GL_ARB_shading_language_include : require
 #include </defs.glsl> //! #include "../defs.glsl"
 
-layout (location = 0) in vec4 in_Position;
-layout(location = INSTANCE_MODEL_MATRIX) in mat4 in_instanceMatrix;
+layout (location = 0) in vec3 in_Position;
+layout (location = 1) in vec4 in_Color;
 
 out vec4 gl_Position; 
+out vec4 v_Color;
 
 layout (std140) uniform Camera {
 	FIXED_VEC3 viewPos;
@@ -15,5 +16,6 @@ layout (std140) uniform Camera {
 
 void main ()
 {
-	gl_Position = projection * view * in_instanceMatrix * in_Position;
+	gl_Position = projection * view * vec4(in_Position, 1.0f);
+	v_Color = in_Color;
 }
\ No newline at end of file
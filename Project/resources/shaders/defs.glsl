@@ -11,4 +11,78 @@
 // ===========================================================
 
 #define INSTANCE_UV_OFFSET 11
-#define INSTANCE_MODEL_MATRIX 12
\ No newline at end of file
+#define INSTANCE_SHADOW_LAYER 11 // shadow instances carry their shadow map layer instead of a uv offset
+#define INSTANCE_MATERIAL_INDEX 11 // model instances carry the material table index of their material
+#define INSTANCE_MODEL_MATRIX 12
+
+// ===========================================================
+// Impostors, views per side of the octahedral grid (IMPOSTOR_FRAMES in ImpostorBaker.h)
+// ===========================================================
+
+#define IMPOSTOR_FRAMES 8
+
+// ===========================================================
+// Material table, one entry per material, indexed by INSTANCE_MATERIAL_INDEX
+// ===========================================================
+
+#define MATERIAL_TABLE_BINDING 0
+
+struct MaterialParams {
+	float shininess;
+	float specularStrength;
+	float metalicity;
+	uint overrideMetalness;
+};
+// ===========================================================
+// Clustered point lights (LightClusters.h, ClusteredLightBuffers.h)
+// Define USE_POINT_LIGHTS before the include to get the light buffers
+// ===========================================================
+
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+
+#define POINT_LIGHT_BINDING 1
+#define LIGHT_GRID_BINDING 2
+#define LIGHT_INDEX_BINDING 3
+
+struct PointLight {
+	vec4 positionRadius;
+	vec4 colorIntensity;
+};
+
+#ifdef USE_POINT_LIGHTS
+
+layout(std430, binding = POINT_LIGHT_BINDING) readonly buffer PointLights {
+	PointLight pointLights[];
+};
+
+// clusterParams: slice scale, slice bias, near and far plane of the binned projection
+layout(std430, binding = LIGHT_GRID_BINDING) readonly buffer LightGrid {
+	vec4 clusterParams;
+	uvec2 lightClusters[]; // offset and count into lightIndices
+};
+
+layout(std430, binding = LIGHT_INDEX_BINDING) readonly buffer LightIndices {
+	uint lightIndices[];
+};
+
+// offset and count of the lights reaching a fragment, empty outside the grid
+uvec2 GetLightCluster(vec2 ndc, float viewDepth)
+{
+	if (viewDepth < clusterParams.z || viewDepth >= clusterParams.w) return uvec2(0u);
+
+	uvec2 tile = uvec2(clamp((ndc * 0.5 + 0.5) * vec2(LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y),
+		vec2(0.0), vec2(LIGHT_CLUSTERS_X - 1, LIGHT_CLUSTERS_Y - 1)));
+	uint slice = uint(clamp(floor(log(viewDepth) * clusterParams.x + clusterParams.y), 0.0, float(LIGHT_CLUSTERS_Z - 1)));
+	return lightClusters[(slice * LIGHT_CLUSTERS_Y + tile.y) * LIGHT_CLUSTERS_X + tile.x];
+}
+
+// inverse square falloff windowed to reach zero at the light radius
+float PointLightAttenuation(float distance, float radius)
+{
+	float window = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+	return window * window / (distance * distance + 1.0);
+}
+
+#endif
@@ -0,0 +1,8 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+out float gl_FragDepth;
+
+void main(void){
+}
\ No newline at end of file
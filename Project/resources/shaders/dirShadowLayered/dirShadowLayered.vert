@@ -0,0 +1,25 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#include </defs.glsl> //! #include "../defs.glsl"
+
+layout (location = 0) in vec4 in_Position;
+layout(location = INSTANCE_MODEL_MATRIX) in mat4 in_instanceMatrix;
+layout(location = INSTANCE_SHADOW_LAYER) in uint in_instanceLayer;
+
+layout (std140) uniform Shadow {
+	mat4 LightSpace[6];
+    vec4 LightPos;
+    float CascadedSplits[6];
+};
+
+// every instance targets a single cascade, picked here instead of in a geometry shader.
+// Only drawn with if the driver lets the vertex shader write gl_Layer, dirShadow is the fallback
+void main ()
+{
+	gl_Position = LightSpace[in_instanceLayer] * (in_instanceMatrix * in_Position);
+#if defined(GL_ARB_shader_viewport_layer_array) || defined(GL_AMD_vertex_shader_layer)
+	gl_Layer = int(in_instanceLayer);
+#endif
+}
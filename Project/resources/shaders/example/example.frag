@@ -1,10 +1,12 @@
 #version 460
 #extension GL_ARB_shading_language_include : require
+#define USE_POINT_LIGHTS
 #include </defs.glsl> //! #include "../defs.glsl"
 
 in vec2 ex_TexCoord;
 in vec3 ex_Normal;
 in vec3 fragPos;
+flat in uint ex_MaterialIndex;
 
 out vec4 out_Color;
 
@@ -35,11 +37,8 @@ layout (std140) uniform Shadow {
     float CascadedSplits[6];
 };
 
-layout(std140) uniform Material {
-	float shininess;
-	float specularStrength;
-	float metalicity;
-	bool overrideMetalness;
+layout(std430, binding = MATERIAL_TABLE_BINDING) readonly buffer MaterialTable {
+	MaterialParams materials[];
 };
 
 struct CascadeInfo {
@@ -176,6 +175,12 @@ float ShadowCalculationPointLight(vec3 fragPos)
 }
 
 void main(void){
+	MaterialParams material = materials[ex_MaterialIndex];
+	float shininess = material.shininess;
+	float specularStrength = material.specularStrength;
+	float metalicity = material.metalicity;
+	bool overrideMetalness = material.overrideMetalness != 0u;
+
 	FIXED_VEC3_INIT(viewPos);
 	FIXED_VEC3_INIT(lightColor);
 	FIXED_VEC3_INIT(attenuationFactor);
@@ -248,6 +253,23 @@ void main(void){
 	vec3 specularComponent = specular * mix(vec3(1.0f), surfaceColor, realMetalicity);
 	vec4 result = vec4(ambient, 1.0f) * TexColor + vec4(attenuation * (diffuseComponent + specularComponent) * (1.0 - shadow), 1.0f);
 
+	// clustered point lights, unshadowed
+	vec4 clipPos = projection * view * vec4(fragPos, 1.0);
+	float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+	uvec2 cluster = GetLightCluster(clipPos.xy / clipPos.w, viewDepth);
+	for (uint i = 0u; i < cluster.y; i++) {
+		PointLight light = pointLights[lightIndices[cluster.x + i]];
+		vec3 toLight = light.positionRadius.xyz - fragPos;
+		float distance = length(toLight);
+		vec3 pointDir = toLight / max(distance, 0.0001);
+		vec3 pointColor = light.colorIntensity.rgb * light.colorIntensity.a * PointLightAttenuation(distance, light.positionRadius.w);
+
+		float pointDiff = max(dot(norm, pointDir), 0.0);
+		float pointSpec = pointDiff > 0.0 ? pow(max(dot(viewDir, reflect(-pointDir, norm)), 0.0), shininess) : 0.0;
+		result.rgb += pointColor * (pointDiff * surfaceColor * (1.0 - realMetalicity)
+			+ specularStrength * pointSpec * mix(vec3(1.0f), surfaceColor, realMetalicity));
+	}
+
     if(useFog) {
         float dist = length(viewPos - fragPos);
         // exponential fog
@@ -5,6 +5,7 @@
 layout (location = 0) in vec4 in_Position;
 layout (location = 1) in vec2 in_TexCoord;
 layout (location = 2) in vec3 in_Normal;
+layout(location = INSTANCE_MATERIAL_INDEX) in uint in_MaterialIndex;
 layout(location = INSTANCE_MODEL_MATRIX) in mat4 in_instanceMatrix;
 
 out vec4 gl_Position; 
@@ -13,6 +14,7 @@ out vec2 ex_TexCoord;
 out vec3 ex_Normal;
 
 out vec3 fragPos;
+flat out uint ex_MaterialIndex;
 
 layout (std140) uniform Camera {
 	FIXED_VEC3 viewPos;
@@ -25,5 +27,6 @@ void main ()
 	fragPos = vec3(in_instanceMatrix * in_Position);
 	gl_Position = projection * view * in_instanceMatrix * in_Position;
 	ex_TexCoord = in_TexCoord;
+	ex_MaterialIndex = in_MaterialIndex;
 	ex_Normal = mat3(transpose(inverse(in_instanceMatrix))) * in_Normal;
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+in vec2 ex_TexCoord;
+in vec3 fragPos;
+flat in mat3 ex_Rotation;
+
+out vec4 out_Color;
+
+uniform sampler2D albedo;
+uniform sampler2D normals;
+
+layout(std140) uniform Lighting {
+	vec4 lightPos;
+	FIXED_VEC3 lightColor;
+	float ambientStrength;
+	FIXED_VEC3 attenuationFactor;
+};
+
+void main(void){
+	FIXED_VEC3_INIT(lightColor);
+	FIXED_VEC3_INIT(attenuationFactor);
+
+	vec4 TexColor = texture(albedo, ex_TexCoord);
+	if (TexColor.a < 0.5) discard;
+
+	// baked in object space, relit like the mesh would be
+	vec3 norm = normalize(ex_Rotation * (texture(normals, ex_TexCoord).xyz * 2.0 - 1.0));
+
+	vec3 lightDir;
+	float attenuation = 1.0;
+	if (lightPos.w == 0.0) {
+		lightDir = normalize(lightPos.xyz);
+	}
+	else {
+		lightDir = normalize(lightPos.xyz - fragPos);
+		float distance = length(lightPos.xyz - fragPos);
+		attenuation = 1.0 / (attenuationFactor.x + attenuationFactor.y * distance + attenuationFactor.z * (distance * distance));
+	}
+
+	vec3 ambient = ambientStrength * lightColor;
+	vec3 diffuse = max(dot(norm, lightDir), 0.0) * lightColor * attenuation;
+
+	out_Color = vec4((ambient + diffuse) * TexColor.rgb, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+layout (location = 0) in vec4 in_Position;
+layout (location = 1) in vec2 in_TexCoord;
+layout(location = INSTANCE_MODEL_MATRIX) in mat4 in_instanceMatrix;
+
+out vec4 gl_Position;
+out vec2 ex_TexCoord;
+out vec3 fragPos;
+flat out mat3 ex_Rotation;
+
+layout (std140) uniform Camera {
+	FIXED_VEC3 viewPos;
+	mat4 view;
+	mat4 projection;
+};
+
+// octahedral grid position of a direction, y is the axis through the center of the grid
+vec2 OctahedralEncode(vec3 direction)
+{
+	direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+	vec2 p = direction.xz;
+	if (direction.y < 0.0) {
+		p = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return p * 0.5 + 0.5;
+}
+
+void main ()
+{
+	FIXED_VEC3_INIT(viewPos);
+
+	// the instance matrix maps the quad onto the bounding sphere of the mesh, see ImpostorBaker::GetQuadFrame
+	vec3 center = vec3(in_instanceMatrix[3]);
+	mat3 basis = mat3(in_instanceMatrix);
+	ex_Rotation = basis / length(basis[0]);
+
+	// direction to the camera in object space picks the baked view
+	vec3 viewDir = normalize(transpose(ex_Rotation) * (viewPos - center));
+	vec2 frame = min(floor(OctahedralEncode(viewDir) * IMPOSTOR_FRAMES), vec2(IMPOSTOR_FRAMES - 1));
+
+	// camera facing, with the up vector the views were baked with
+	vec3 up = abs(viewDir.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(up, viewDir));
+	up = cross(viewDir, right);
+
+	fragPos = center + basis * (right * in_Position.x + up * in_Position.y);
+	gl_Position = projection * view * vec4(fragPos, 1.0);
+	ex_TexCoord = (frame + in_TexCoord) / IMPOSTOR_FRAMES;
+}
\ No newline at end of file
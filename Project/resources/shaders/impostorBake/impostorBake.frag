@@ -0,0 +1,21 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+in vec2 ex_TexCoord;
+in vec3 ex_Normal;
+
+layout (location = 0) out vec4 out_Albedo;
+layout (location = 1) out vec4 out_Normal;
+
+uniform sampler2D albedo;
+uniform vec4 albedoRect; // where albedo lies in its atlas, x, y, width, height
+uniform int textured;
+
+void main(void){
+	vec3 color = textured != 0 ? texture(albedo, albedoRect.xy + ex_TexCoord * albedoRect.zw).rgb : vec3(1.0);
+
+	// alpha marks the silhouette, normals are stored in object space
+	out_Albedo = vec4(color, 1.0);
+	out_Normal = vec4(normalize(ex_Normal) * 0.5 + 0.5, 1.0);
+}
\ No newline at end of file
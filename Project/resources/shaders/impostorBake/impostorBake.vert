@@ -0,0 +1,21 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+layout (location = 0) in vec4 in_Position;
+layout (location = 1) in vec2 in_TexCoord;
+layout (location = 2) in vec3 in_Normal;
+
+out vec4 gl_Position;
+out vec2 ex_TexCoord;
+out vec3 ex_Normal;
+
+uniform mat4 model; // position decode of the mesh
+uniform mat4 viewProjection;
+
+void main ()
+{
+	gl_Position = viewProjection * model * in_Position;
+	ex_TexCoord = in_TexCoord;
+	ex_Normal = mat3(transpose(inverse(model))) * in_Normal;
+}
\ No newline at end of file
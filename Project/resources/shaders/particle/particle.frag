@@ -7,9 +7,10 @@ in vec2 ex_TexCoord;
 out vec4 out_Color;
 
 uniform sampler2D tex;
+uniform vec4 texRect; // where tex lies in its atlas, x, y, width, height
 
 void main(void){
-	vec4 TexColor = texture(tex, ex_TexCoord);
+	vec4 TexColor = texture(tex, texRect.xy + ex_TexCoord * texRect.zw);
 
 	out_Color = TexColor;
 }
\ No newline at end of file
@@ -4,10 +4,14 @@
 
 layout (location = 0) in vec4 in_Position;
 layout(location = INSTANCE_MODEL_MATRIX) in mat4 in_instanceMatrix;
+layout(location = INSTANCE_SHADOW_LAYER) in uint in_instanceLayer;
+
+flat out uint v_Layer;
 
 //out vec4 gl_Position; 
 
 void main ()
 {
 	gl_Position = in_instanceMatrix * in_Position;
+	v_Layer = in_instanceLayer;
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+#include </defs.glsl> //! #include "../defs.glsl"
+
+in vec4 FragPos;
+
+layout (std140) uniform Shadow {
+	mat4 LightSpace[6];
+    vec4 LightPos;
+    float CascadedSplits[6];
+};
+
+out float gl_FragDepth;
+
+void main(void){
+
+	float dist = length(FragPos.xyz - LightPos.xyz);
+	dist /= CascadedSplits[0];
+	gl_FragDepth = dist;
+}
\ No newline at end of file
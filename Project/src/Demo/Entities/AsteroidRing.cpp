@@ -84,7 +84,7 @@ void AsteroidRing::ProvideRenderables(std::vector<Renderable>& outRenderables)
 	}
 }
 
-void AsteroidRing::UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables)
+bool AsteroidRing::UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables)
 {
 	glm::mat4 entityMatrix = GetComponent<TransformComponent>().worldMatrix;
 	for(size_t i = 0; i < asteroidLocals.size(); i++) {
@@ -94,6 +94,7 @@ void AsteroidRing::UpdateRenderables(double deltaTime, std::vector<Renderable>&
 		}
 		renderables[i].modelMatrix = entityMatrix * asteroidMatrix(asteroidLocals[i]);
 	}
+	return true;
 }
 
 void AsteroidRing::UpdateTransform(const glm::mat4& newTransform) {
@@ -8,6 +8,9 @@
 
 #include <GLFW/glfw3.h>
 
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
 #include <iostream>
 
 void TestScene::OnCreate()
@@ -85,6 +88,25 @@ void TestScene::OnCreate()
 	rocket->SetGlobalPosition({ 0.0f, 0.0f, -11.0f });
 	rocket->SetGlobalRotation(glm::quat(glm::vec3(glm::radians(-90.f), 0.0f, 0.0f)));
 
+	PointLight* engineGlow = new PointLight("EngineGlow");
+	AddOrMoveEntity(*engineGlow, rocket);
+	engineGlow->SetLocalPosition({ 0.0f, -2.0f, 0.0f });
+	engineGlow->SetColor({ 1.0f, 0.55f, 0.2f });
+	engineGlow->SetIntensity(6.0f);
+	engineGlow->SetRadius(12.0f);
+
+	// a ring of beacons around the planet
+	const int beaconCount = 96;
+	for (int i = 0; i < beaconCount; ++i) {
+		float angle = glm::two_pi<float>() * static_cast<float>(i) / beaconCount;
+		PointLight* beacon = new PointLight("Beacon" + std::to_string(i));
+		AddOrMoveEntity(*beacon, planetAnchor);
+		beacon->SetLocalPosition({ 24.0f * std::cos(angle), 0.0f, 24.0f * std::sin(angle) });
+		beacon->SetColor(i % 2 ? glm::vec3(1.0f, 0.2f, 0.2f) : glm::vec3(0.3f, 0.6f, 1.0f));
+		beacon->SetIntensity(20.0f);
+		beacon->SetRadius(8.0f);
+	}
+
 	auto& rc2 = planet->GetComponent<RigidBodyComponent>();
 	rc2.anchored = true;
 
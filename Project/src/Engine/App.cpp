@@ -4,8 +4,10 @@
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/InputManager.h"
 #include "Engine/SceneGraph/Scene.h"
+#include "Engine/Profiling/Profiler.h"
 
 #include <chrono>
+#include <algorithm>
 #include <iostream>
 
 int32_t App::argc = 0;
@@ -27,17 +29,47 @@ void ScrollCallback(GLFWwindow*, double xoff, double yoff) {
 	InputManager::Get().ProcessMouseScroll(xoff, yoff);
 }
 
+// progress bar made of scissored clears, the renderer does not exist yet
+void DrawLoadingScreen(Window& window, float progress) {
+	int width = window.GetWidth();
+	int height = window.GetHeight();
+	int barWidth = width / 2;
+	int barHeight = std::max(height / 40, 4);
+	int barX = (width - barWidth) / 2;
+	int barY = (height - barHeight) / 2;
+
+	glViewport(0, 0, width, height);
+	glClearColor(0.05f, 0.05f, 0.05f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(barX, barY, barWidth, barHeight);
+	glClearColor(0.2f, 0.2f, 0.2f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(barX, barY, static_cast<int>(barWidth * progress), barHeight);
+	glClearColor(0.9f, 0.9f, 0.9f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+}
+
 App::App(const std::string& name, uint16_t width, uint16_t height) : name(name)
 {
 	srand(static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+	PROFILE_THREAD("Main");
 
 	//init InputManager with this app
 	InputManager::setApp(this);
 
 	window = new Window(width, height, name, argc, argv, *this);
 
-	//load resources
-	ResourceManager::Get().PreloadResources("resources/");
+	//load resources, files are read on loader threads while this thread creates the GL objects and shows the progress
+	ResourceManager& _rm = ResourceManager::Get();
+	_rm.BeginPreload("resources/");
+	while (!_rm.PumpPreload(LOADING_UPLOAD_BUDGET_MS)) {
+		window->PollEvents();
+		DrawLoadingScreen(*window, _rm.GetPreloadProgress());
+		window->SwapBuffers();
+	}
 
 	renderer = new Renderer(*this);
 
@@ -53,13 +85,30 @@ App::App(const std::string& name, uint16_t width, uint16_t height) : name(name)
 	InputManager::Get().BindKey(GLFW_KEY_F11, InputEventType::Pressed, [this]() {
 		this->window->ToggleFullscreen();
 		});
+#if ENGINE_PROFILING
+	// F9 starts a capture and writes it as a Chrome trace when pressed again, F10 prints the rolling averages
+	InputManager::Get().BindKey(GLFW_KEY_F9, InputEventType::Pressed, []() {
+		Profiler& profiler = Profiler::Get();
+		if (profiler.IsCapturing()) {
+			profiler.EndCapture();
+		}
+		else {
+			std::cout << "Profiler capture started" << std::endl;
+			profiler.BeginCapture();
+		}
+		});
+	InputManager::Get().BindKey(GLFW_KEY_F10, InputEventType::Pressed, []() {
+		Profiler::Get().PrintAverages();
+		});
+#endif
 }
 
 App::~App()
 {
+	// the scene removes its proxies from the renderer's world while it is destroyed
+	if (scene) delete scene;
 	delete renderer;
 	delete window;
-	if (scene) delete scene;
 }
 
 void App::Init(int32_t argc, char** argv)
@@ -76,7 +125,7 @@ App& App::Get(const std::string& name, uint16_t width, uint16_t height)
 
 void App::RunLoop()
 {
-	glfwMakeContextCurrent(window->GetNative());
+	PROFILE_THREAD("Game");
 	while (!window->ShouldClose())
 	{
 		double currentFrame = glfwGetTime();
@@ -93,10 +142,22 @@ void App::RunLoop()
 			scene->Update(deltaTime);
 		}
 
-		renderer->Render();
+		// waits only if the render thread is still a whole frame behind
+		renderer->PublishFrame();
+	}
 
+	renderer->ClosePipeline();
+}
+
+void App::RenderLoop()
+{
+	PROFILE_THREAD("Render");
+	glfwMakeContextCurrent(window->GetNative());
+	while (renderer->Render())
+	{
 		window->SwapBuffers();
 	}
+	glfwMakeContextCurrent(nullptr);
 }
 
 void App::EventLoop()
@@ -112,13 +173,19 @@ void App::EventLoop()
 void App::Run()
 {
 	glfwMakeContextCurrent(nullptr);
-	// Thread runs update + render
+	// Render thread owns the GL context and draws the frames the game thread publishes
+	std::thread renderThread([this]() { RenderLoop(); });
+	// Game thread simulates the next frame while the previous one is drawn
 	std::thread gameThread([this]() { RunLoop(); });
 
 	// Main thread pumps events (blocks on resize but game keeps drawing)
 	EventLoop();
 
 	gameThread.join();
+	renderThread.join();
+
+	// GL resources are released from this thread on shutdown
+	glfwMakeContextCurrent(window->GetNative());
 }
 
 void App::SetScene(Scene* newScene)
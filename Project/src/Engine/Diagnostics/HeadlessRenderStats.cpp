@@ -0,0 +1,297 @@
+#include "Engine/Diagnostics/HeadlessRenderStats.h"
+
+#include "Engine/Renderer/Renderer.h"
+#include "Engine/Renderer/FrameRecorder.h"
+#include "Engine/Renderer/NullRenderBackend.h"
+#include "Engine/Renderer/LightMath.h"
+#include "Engine/Profiling/AllocationCounter.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	// long enough for proxies that stopped moving to become static casters
+	constexpr uint32_t FRAME_COUNT = RENDER_WORLD_STATIC_FRAMES + 10;
+	// frames the lists, the arena and the instance buffer may still grow in while the camera moves
+	// and proxies settle, every later frame must not allocate
+	constexpr uint32_t WARM_UP_FRAMES = RENDER_WORLD_STATIC_FRAMES;
+	constexpr float NEAR_PLANE = 0.1f, FAR_PLANE = 10000.f, ASPECT_RATIO = 16.f / 9.f;
+
+	// xorshift, so scenes come out the same with every standard library
+	struct SceneRandom
+	{
+		uint32_t state = 2463534242u;
+
+		float Next(float min, float max)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return min + (max - min) * float(state >> 8) / float(1u << 24);
+		}
+	};
+
+	// proxies stay in the render world, submissions are pushed again every frame
+	struct Scene
+	{
+		std::vector<Renderable> proxies;
+		std::vector<Renderable> submissions;
+		uint32_t moveEvery = 0; // every nth proxy moves each frame, 0 for none
+	};
+
+	// what a recorded scene drew
+	struct SceneRun
+	{
+		RenderCommandStats commands;
+		RendererStats lastFrame;
+		size_t submissions[3] = {};
+		size_t batches[3] = {};
+		size_t shadowBatches = 0;
+		size_t staticShadowBatches = 0;
+		uint64_t heapAllocations[FRAME_COUNT] = {};
+	};
+
+	// nothing is uploaded, the recorder only needs the handles and the bounds
+	MeshManager::Handle RegisterMesh(const std::string& name, const glm::vec3& halfSize)
+	{
+		Mesh mesh{};
+		mesh.boundingBox.min = -halfSize;
+		mesh.boundingBox.max = halfSize;
+		return ResourceManager::Get().meshes.Register(name, mesh);
+	}
+
+	// a mesh and its coarser levels, see MeshLodChain
+	MeshManager::Handle RegisterLodMesh(const std::string& name, const glm::vec3& halfSize, uint8_t levelCount)
+	{
+		MeshLodChain chain;
+		for (uint8_t level = 0; level < levelCount; ++level) {
+			chain.levels[level] = RegisterMesh(name + "_lod" + std::to_string(level), halfSize);
+		}
+		chain.count = levelCount;
+		ResourceManager::Get().meshes.SetLodChain(chain.levels[0], chain);
+		return chain.levels[0];
+	}
+
+	MaterialManager::Handle RegisterMaterial(const std::string& name, bool castShadows)
+	{
+		Material material;
+		material.castShadows = castShadows;
+		return ResourceManager::Get().materials.Register(name, material);
+	}
+
+	Renderable MakeRenderable(MeshManager::Handle mesh, MaterialManager::Handle material, const glm::vec3& position, const glm::vec3& halfSize)
+	{
+		Renderable r;
+		r.meshHandle = mesh;
+		r.materialHandle = material;
+		r.modelMatrix = glm::translate(glm::mat4(1.f), position);
+		r.aabb.min = -halfSize;
+		r.aabb.max = halfSize;
+		r.hasBounds = true;
+		return r;
+	}
+
+	// opaque rocks with LOD chains, every 20th drifting
+	void BuildField(Scene& scene)
+	{
+		const glm::vec3 rockSize(2.f);
+		MeshManager::Handle rocks[3];
+		for (int i = 0; i < 3; ++i) {
+			rocks[i] = RegisterLodMesh("headless/rock" + std::to_string(i), rockSize, 3);
+		}
+		MaterialManager::Handle materials[6];
+		for (int i = 0; i < 6; ++i) {
+			materials[i] = RegisterMaterial("headless/rock" + std::to_string(i), true);
+		}
+
+		SceneRandom random;
+		for (int i = 0; i < 20000; ++i) {
+			glm::vec3 position(random.Next(-1000.f, 1000.f), random.Next(0.f, 200.f), random.Next(-1000.f, 1000.f));
+			Renderable r = MakeRenderable(rocks[i % 3], materials[i % 6], position, rockSize);
+			r.castShadows = true;
+			scene.proxies.push_back(r);
+		}
+		scene.moveEvery = 20;
+	}
+
+	// static buildings, with transparent windows and a GUI submitted every frame
+	void BuildMixed(Scene& scene)
+	{
+		const glm::vec3 buildingSize(5.f, 20.f, 5.f), windowSize(2.f, 2.f, 0.1f), iconSize(0.05f, 0.05f, 0.f);
+		MeshManager::Handle building = RegisterLodMesh("headless/building", buildingSize, 2);
+		MeshManager::Handle window = RegisterMesh("headless/window", windowSize);
+		RegisterMesh("primitive/quad", glm::vec3(0.5f, 0.5f, 0.f));
+		MaterialManager::Handle walls[2] = { RegisterMaterial("headless/wall0", true), RegisterMaterial("headless/wall1", true) };
+		MaterialManager::Handle glass = RegisterMaterial("headless/glass", false);
+		MaterialManager::Handle icons = RegisterMaterial("headless/icons", false);
+
+		for (int x = 0; x < 40; ++x) {
+			for (int z = 0; z < 40; ++z) {
+				glm::vec3 position(x * 25.f - 500.f, buildingSize.y, z * 25.f - 500.f);
+				Renderable r = MakeRenderable(building, walls[(x + z) % 2], position, buildingSize);
+				r.castShadows = true;
+				r.occluder = true;
+				scene.proxies.push_back(r);
+
+				Renderable w = MakeRenderable(window, glass, position + glm::vec3(0.f, 5.f, buildingSize.z + 0.2f), windowSize);
+				w.layer = RenderLayer::Transparent;
+				w.cullBackfaces = false;
+				scene.submissions.push_back(w);
+			}
+		}
+
+		for (int i = 0; i < 64; ++i) {
+			Renderable icon = MakeRenderable(MeshManager::Handle{}, icons, glm::vec3(-0.45f + (i % 8) * 0.1f, -0.45f + (i / 8) * 0.1f, 0.f), iconSize);
+			icon.hasBounds = false;
+			icon.layer = RenderLayer::GUI;
+			icon.zOrder = int16_t(i % 4);
+			scene.submissions.push_back(icon);
+		}
+	}
+
+	bool BuildScene(const std::string& name, Scene& scene)
+	{
+		if (name == "field") BuildField(scene);
+		else if (name == "mixed") BuildMixed(scene);
+		else return false;
+		return true;
+	}
+
+	// the frames the renderer would draw of the scene, with the camera flying over it
+	SceneRun RecordScene(const Scene& scene)
+	{
+		FrameArena arena;
+		WorkerPool workers;
+		FrameRecorder recorder(arena, workers);
+		InstanceHeapBuffer instances;
+		NullRenderBackend backend;
+		RenderWorld world;
+
+		std::vector<RenderWorld::ProxyHandle> handles;
+		for (const Renderable& r : scene.proxies) {
+			handles.push_back(world.Add(r));
+		}
+
+		fixed_float cascadeSplits[SHADOW_LAYER_COUNT];
+		LightMath::GetCascadeSplits(NEAR_PLANE, FAR_PLANE, SHADOW_LAYER_COUNT, 1, cascadeSplits);
+		const glm::vec3 lightDirection = glm::normalize(glm::vec3(-1.f, -2.f, -1.f));
+		// the renderer's layer scheduling is left out, every layer is redrawn every frame
+		const uint8_t allLayers = uint8_t((1u << SHADOW_LAYER_COUNT) - 1);
+
+		SceneRun run;
+		AllocationCounter frameAllocations;
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+			for (size_t i = 0; scene.moveEvery && i < handles.size(); i += scene.moveEvery) {
+				glm::vec3 offset(std::sin(frame * 0.1f + i) * 5.f, 0.f, 0.f);
+				world.UpdateTransform(handles[i], glm::translate(scene.proxies[i].modelMatrix, offset));
+			}
+
+			// counts what PublishFrame and Render would allocate
+			AllocationScope allocationScope(frameAllocations);
+			world.AdvanceFrame();
+
+			const glm::vec3 cameraPosition(frame * 2.f, 60.f, 300.f);
+			const glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(0.f, -0.3f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+			const glm::mat4 projection = glm::perspective(glm::radians(90.f), ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
+
+			RenderQueue& queue = recorder.GetQueue();
+			queue.SetViewFrustum(Frustum(projection * view));
+			queue.SetLodView(cameraPosition, projection[1][1]);
+			queue.Push(world);
+			queue.Push(scene.submissions);
+
+			glm::mat4 lightSpace[SHADOW_LAYER_COUNT];
+			LightMath::ComputeDirectionalLightCascades(lightDirection, view, 90.f, ASPECT_RATIO, NEAR_PLANE, FAR_PLANE,
+				SHADOW_LAYER_COUNT, cascadeSplits, SHADOW_MAP_SIZE, lightSpace);
+			Frustum shadowFrusta[SHADOW_LAYER_COUNT];
+			for (int layer = 0; layer < SHADOW_LAYER_COUNT; ++layer) {
+				shadowFrusta[layer] = Frustum(lightSpace[layer]);
+			}
+
+			instances.BeginFrame();
+			recorder.ResetStats();
+			recorder.GetStats().shadowLayersDrawn = SHADOW_LAYER_COUNT;
+			recorder.GetStats().shadowLayersCached = SHADOW_LAYER_COUNT;
+			recorder.BuildBatches(cameraPosition, shadowFrusta, SHADOW_LAYER_COUNT, allLayers, allLayers, instances);
+
+			// shaders are not loaded, the shadow pass binds an invalid handle
+			backend.Execute(recorder.RecordShadowPass(true, ShaderManager::Handle{}));
+			backend.Execute(recorder.RecordShadowPass(false, ShaderManager::Handle{}));
+			backend.Execute(recorder.RecordMainPass());
+			backend.Execute(recorder.RecordGUIPass());
+
+			if (frame + 1 == FRAME_COUNT) {
+				for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::Transparent, RenderLayer::GUI }) {
+					run.submissions[size_t(layer)] = queue.GetLayer(layer).size();
+					run.batches[size_t(layer)] = recorder.GetBatches(layer).size();
+				}
+				run.shadowBatches = recorder.GetShadowBatches(false).size();
+				run.staticShadowBatches = recorder.GetShadowBatches(true).size();
+				run.lastFrame = recorder.GetStats();
+			}
+			recorder.EndFrame();
+			run.heapAllocations[frame] = frameAllocations.Take();
+		}
+
+		run.commands = backend.GetStats();
+		return run;
+	}
+}
+
+// =========================================================
+// HeadlessRenderStats
+// =========================================================
+
+int HeadlessRenderStats::Run(const std::string& sceneName)
+{
+	Scene scene;
+	if (!BuildScene(sceneName, scene)) {
+		std::cerr << "Unknown scene \"" << sceneName << "\", scenes are: field, mixed\n";
+		return 1;
+	}
+
+	const SceneRun run = RecordScene(scene);
+	// the worker pool merges in a fixed order, so a second run has to record the same stream
+	const SceneRun rerun = RecordScene(scene);
+
+	std::cout << "Scene \"" << sceneName << "\", " << scene.proxies.size() << " proxies, "
+		<< scene.submissions.size() << " submissions per frame, " << FRAME_COUNT << " frames\n";
+
+	std::cout << "Last frame          opaque  transparent      GUI\n";
+	std::cout << "  submissions " << std::setw(12) << run.submissions[0] << std::setw(13) << run.submissions[1] << std::setw(9) << run.submissions[2] << "\n";
+	std::cout << "  batches     " << std::setw(12) << run.batches[0] << std::setw(13) << run.batches[1] << std::setw(9) << run.batches[2] << "\n";
+	std::cout << "  shadow batches " << run.shadowBatches << " dynamic, " << run.staticShadowBatches << " static"
+		<< " (opaque submissions include the shadow-only casters)\n";
+	run.lastFrame.Print();
+
+	const RenderCommandStats& c = run.commands;
+	std::cout << "Commands of all frames\n";
+	std::cout << "  " << c.commands << " commands, " << c.draws << " draws, " << c.instances << " instances\n";
+	std::cout << "  " << c.renderStateChanges << " render state changes, " << c.shaderBinds << " shader binds, "
+		<< c.materialBinds << " material binds, " << c.meshBinds << " mesh binds\n";
+	std::cout << "  hash " << std::hex << std::setw(16) << std::setfill('0') << c.hash << std::dec << std::setfill(' ') << "\n";
+
+	uint64_t warmAllocations = 0;
+	for (uint32_t frame = WARM_UP_FRAMES; frame < FRAME_COUNT; ++frame) {
+		warmAllocations += run.heapAllocations[frame] + rerun.heapAllocations[frame];
+	}
+	if (AllocationCounter::IsEnabled()) {
+		std::cout << "Heap allocations " << run.heapAllocations[0] << " in the first frame, "
+			<< warmAllocations << " after " << WARM_UP_FRAMES << " warm up frames\n";
+	}
+
+	if (rerun.commands.hash != c.hash || rerun.commands.commands != c.commands) {
+		std::cout << "MISMATCH: a second run recorded a different command stream\n";
+		return 1;
+	}
+	if (warmAllocations != 0) {
+		std::cout << "FAILED: the frame path allocated once warm\n";
+		return 1;
+	}
+	return 0;
+}
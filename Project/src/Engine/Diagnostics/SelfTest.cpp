@@ -0,0 +1,235 @@
+#include "Engine/Diagnostics/SelfTest.h"
+
+#include "Engine/Renderer/Culling/OcclusionBuffer.h"
+#include "Engine/Renderer/Lighting/LightClusters.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+int SelfTest::checks = 0;
+int SelfTest::failures = 0;
+
+namespace
+{
+	BoundingBox MakeBox(const glm::vec3& min, const glm::vec3& max)
+	{
+		BoundingBox box;
+		box.min = min;
+		box.max = max;
+		return box;
+	}
+
+	// every path the CPU can run, the culler falls back to a narrower one for the rest
+	std::vector<CullingPath> GetSupportedPaths()
+	{
+		std::vector<CullingPath> paths{ CullingPath::Scalar };
+		if (GetDefaultCullingPath() != CullingPath::Scalar) paths.push_back(CullingPath::SSE);
+		if (GetDefaultCullingPath() == CullingPath::AVX) paths.push_back(CullingPath::AVX);
+		return paths;
+	}
+
+	PointLightData MakeLight(const glm::vec3& position, float radius)
+	{
+		PointLightData light;
+		light.positionRadius = glm::vec4(position, radius);
+		return light;
+	}
+
+	bool SameClusters(const LightClusters& a, const LightClusters& b)
+	{
+		const auto& ca = a.GetClusters();
+		const auto& cb = b.GetClusters();
+		if (ca.size() != cb.size() || a.GetLightIndices() != b.GetLightIndices()) return false;
+		for (size_t i = 0; i < ca.size(); ++i) {
+			if (ca[i].offset != cb[i].offset || ca[i].count != cb[i].count) return false;
+		}
+		return true;
+	}
+}
+
+// =========================================================
+// SelfTest
+// =========================================================
+
+int SelfTest::Run()
+{
+	checks = 0;
+	failures = 0;
+
+	TestOcclusionBuffer();
+	TestLightClusters();
+
+	std::cout << "SelfTest: " << checks - failures << "/" << checks << " checks passed\n";
+	return failures == 0 ? 0 : 1;
+}
+
+void SelfTest::Check(bool passed, const std::string& what)
+{
+	checks++;
+	if (passed) return;
+	failures++;
+	std::cout << "  FAILED " << what << "\n";
+}
+
+void SelfTest::TestOcclusionBuffer()
+{
+	// camera at the origin looking down -z, a 4x4 quad 10 units in front of it
+	const glm::mat4 projectionView =
+		glm::perspective(glm::radians(60.f), float(OCCLUSION_BUFFER_WIDTH) / OCCLUSION_BUFFER_HEIGHT, 0.1f, 100.f) *
+		glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+	const float quad[] = {
+		-2.f, -2.f, -10.f,
+		 2.f, -2.f, -10.f,
+		 2.f,  2.f, -10.f,
+		-2.f,  2.f, -10.f,
+	};
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	struct BoxCase
+	{
+		const char* name;
+		BoundingBox box;
+		bool visible;
+	};
+	const BoxCase cases[] = {
+		// the quad covers [-4, 4] at twice its distance
+		{ "box fully behind the quad", MakeBox({ -1.f, -1.f, -21.f }, { 1.f, 1.f, -19.f }), false },
+		{ "box partly behind the quad", MakeBox({ 2.f, -1.f, -21.f }, { 6.f, 1.f, -19.f }), true },
+		{ "box in front of the quad", MakeBox({ -0.5f, -0.5f, -5.5f }, { 0.5f, 0.5f, -4.5f }), true },
+		{ "box crossing the near plane", MakeBox({ -0.2f, -0.2f, -20.f }, { 0.2f, 0.2f, -0.05f }), true },
+		{ "box reaching behind the camera", MakeBox({ -0.2f, -0.2f, -20.f }, { 0.2f, 0.2f, 1.f }), true },
+	};
+
+	// the AVX path rasterizes with the SSE loop, so two paths cover it
+	for (CullingPath path : { CullingPath::Scalar, CullingPath::SSE }) {
+		const std::string prefix = std::string("OcclusionBuffer (") + GetCullingPathName(path) + "): ";
+
+		OcclusionBuffer buffer;
+		buffer.SetRasterPath(path);
+
+		// nothing rasterized yet, nothing can be hidden
+		buffer.Begin(projectionView);
+		buffer.Finish();
+		Check(buffer.IsVisible(cases[0].box), prefix + "box visible without occluders");
+
+		buffer.Begin(projectionView);
+		buffer.RasterizeTriangles(reinterpret_cast<const uint8_t*>(quad), 3 * sizeof(float), 0, 4, indices, 6, glm::mat4(1.f));
+		buffer.Finish();
+		Check(buffer.HasOccluders(), prefix + "quad writes depth");
+
+		// the center pixel holds the depth of the quad
+		const float ndcDepth = projectionView[2][2] * -10.f + projectionView[3][2];
+		const float expected = ndcDepth / 10.f * 0.5f + 0.5f;
+		const float center = buffer.GetDepth(buffer.GetWidth() / 2, buffer.GetHeight() / 2);
+		Check(std::abs(center - expected) < 1e-4f, prefix + "quad depth at the center");
+
+		for (const BoxCase& c : cases) {
+			Check(buffer.IsVisible(c.box) == c.visible, prefix + c.name + (c.visible ? " is visible" : " is hidden"));
+		}
+	}
+}
+
+void SelfTest::TestLightClusters()
+{
+	// 90 degrees vertically at 16:9 makes the tiles square, d / 4.5 wide at view depth d.
+	// far / near = 2^12 puts the slice boundaries at depths sqrt(2)^z
+	const glm::mat4 projection = glm::perspective(glm::radians(90.f), 16.f / 9.f, 1.f, 4096.f);
+	const glm::mat4 view = glm::mat4(1.f);
+
+	struct ExpectedLight
+	{
+		const char* name;
+		PointLightData light;
+		// inclusive cluster coordinates, empty when first > last
+		glm::ivec3 first, last;
+	};
+	const ExpectedLight expected[] = {
+		{ "light inside one froxel", MakeLight({ 1.5f, 0.f, -19.f }, 0.5f), { 8, 4, 8 }, { 8, 4, 8 } },
+		{ "light on a tile edge", MakeLight({ 0.f, 0.f, -19.f }, 0.5f), { 7, 4, 8 }, { 8, 4, 8 } },
+		{ "light on a slice edge", MakeLight({ 1.5f, 0.f, -16.f }, 0.5f), { 8, 4, 7 }, { 8, 4, 8 } },
+		{ "light crossing the near plane", MakeLight({ 0.f, 0.f, -0.5f }, 0.58f), { 6, 3, 0 }, { 9, 5, 0 } },
+		{ "light behind the camera", MakeLight({ 0.f, 0.f, 5.f }, 1.f), { 0, 0, 0 }, { -1, -1, -1 } },
+		{ "light past the far plane", MakeLight({ 0.f, 0.f, -5000.f }, 10.f), { 0, 0, 0 }, { -1, -1, -1 } },
+		{ "light without radius", MakeLight({ 1.5f, 0.f, -19.f }, 0.f), { 0, 0, 0 }, { -1, -1, -1 } },
+	};
+
+	std::vector<PointLightData> lights;
+	std::vector<std::vector<uint32_t>> expectedLists(LIGHT_CLUSTER_COUNT);
+	for (uint32_t light = 0; light < std::size(expected); ++light) {
+		const ExpectedLight& e = expected[light];
+		lights.push_back(e.light);
+		for (int z = e.first.z; z <= e.last.z; ++z)
+			for (int y = e.first.y; y <= e.last.y; ++y)
+				for (int x = e.first.x; x <= e.last.x; ++x)
+					expectedLists[LightClusters::GetClusterIndex(x, y, z)].push_back(light);
+	}
+
+	// ranges are packed in cluster order
+	std::vector<LightClusterRange> expectedRanges(LIGHT_CLUSTER_COUNT);
+	std::vector<uint32_t> expectedIndices;
+	for (uint32_t i = 0; i < LIGHT_CLUSTER_COUNT; ++i) {
+		expectedRanges[i].offset = uint32_t(expectedIndices.size());
+		expectedRanges[i].count = uint32_t(expectedLists[i].size());
+		expectedIndices.insert(expectedIndices.end(), expectedLists[i].begin(), expectedLists[i].end());
+	}
+
+	LightClusters reference;
+	reference.SetProjection(projection);
+	Check(reference.GetSlice(0.5f) == -1 && reference.GetSlice(19.f) == 8 && reference.GetSlice(5000.f) == LIGHT_CLUSTERS_Z,
+		"LightClusters: slice of a view depth");
+
+	for (CullingPath path : GetSupportedPaths()) {
+		const std::string prefix = std::string("LightClusters (") + GetCullingPathName(path) + "): ";
+
+		LightClusters clusters;
+		clusters.SetProjection(projection);
+		clusters.Bin(view, lights, path);
+
+		const auto& ranges = clusters.GetClusters();
+		bool rangesMatch = ranges.size() == LIGHT_CLUSTER_COUNT;
+		for (uint32_t i = 0; rangesMatch && i < LIGHT_CLUSTER_COUNT; ++i) {
+			rangesMatch = ranges[i].offset == expectedRanges[i].offset && ranges[i].count == expectedRanges[i].count;
+		}
+		Check(rangesMatch, prefix + "cluster ranges of the known lights");
+		Check(clusters.GetLightIndices() == expectedIndices, prefix + "light index list of the known lights");
+
+		// per light, to name the one that went wrong
+		if (ranges.size() != LIGHT_CLUSTER_COUNT) continue;
+		for (uint32_t light = 0; light < std::size(expected); ++light) {
+			bool placed = true;
+			for (uint32_t i = 0; placed && i < LIGHT_CLUSTER_COUNT; ++i) {
+				const bool wanted = std::find(expectedLists[i].begin(), expectedLists[i].end(), light) != expectedLists[i].end();
+				const auto begin = clusters.GetLightIndices().begin() + ranges[i].offset;
+				const bool found = std::find(begin, begin + ranges[i].count, light) != begin + ranges[i].count;
+				placed = wanted == found;
+			}
+			Check(placed, prefix + expected[light].name);
+		}
+	}
+
+	// many overlapping lights from a moving camera, every path has to bin them exactly like the scalar one
+	std::vector<PointLightData> crowd;
+	uint32_t seed = 12345u;
+	auto next = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / float(1u << 24);
+	};
+	for (int i = 0; i < 512; ++i) {
+		crowd.push_back(MakeLight({ next() * 200.f - 100.f, next() * 40.f - 20.f, next() * 200.f - 100.f }, next() * 20.f));
+	}
+	const glm::mat4 crowdView = glm::lookAt(glm::vec3(3.f, 5.f, 60.f), glm::vec3(-10.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+
+	reference.Bin(crowdView, crowd, CullingPath::Scalar);
+	Check(!reference.GetLightIndices().empty(), "LightClusters: crowd of lights is binned");
+	for (CullingPath path : GetSupportedPaths()) {
+		if (path == CullingPath::Scalar) continue;
+		LightClusters clusters;
+		clusters.SetProjection(projection);
+		clusters.Bin(crowdView, crowd, path);
+		Check(SameClusters(clusters, reference), std::string("LightClusters (") + GetCullingPathName(path) + "): crowd matches the scalar path");
+	}
+}
@@ -0,0 +1,103 @@
+#include "Engine/Diagnostics/SortBenchmark.h"
+
+#include "Engine/Renderer/Renderable.h"
+#include "Engine/Renderer/RadixSort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// keys shaped like Renderable::GetSortKey: few shaders, more materials, many meshes, so keys repeat like batches do
+	std::vector<RenderSubmission> MakeSubmissions(size_t count)
+	{
+		std::mt19937_64 random(count);
+		std::uniform_int_distribution<uint64_t> shader(0, 15), material(0, 511), mesh(0, 4095), flags(0, 1);
+
+		std::vector<RenderSubmission> submissions(count);
+		for (size_t i = 0; i < count; ++i) {
+			RenderSubmission& submission = submissions[i];
+			submission.sortKey = (shader(random) << 52) | (material(random) << 32) | (mesh(random) << 4) | flags(random);
+			// remembers the push position through std::sort, which moves whole submissions
+			submission.item.modelMatrix[3][0] = static_cast<float>(i);
+		}
+		return submissions;
+	}
+}
+
+// =========================================================
+// SortBenchmark
+// =========================================================
+
+int SortBenchmark::Run()
+{
+	std::cout << "Opaque list sort, best of 5 runs\n";
+	std::cout << std::setw(10) << "entries" << std::setw(16) << "RadixSort ms" << std::setw(16) << "std::sort ms" << std::setw(10) << "speedup" << "\n";
+
+	bool matched = true;
+	for (size_t count : { size_t(10000), size_t(100000), size_t(1000000) }) {
+		matched &= RunSize(count, 5);
+	}
+	return matched ? 0 : 1;
+}
+
+bool SortBenchmark::RunSize(size_t count, int repeats)
+{
+	const std::vector<RenderSubmission> submissions = MakeSubmissions(count);
+
+	double radixMs = 1e30, stdMs = 1e30;
+	SortList order, scratch;
+	std::vector<RenderSubmission> sorted;
+	for (int run = 0; run < repeats; ++run) {
+		// the order list is built from the submissions every frame, so it is part of the cost
+		auto start = Clock::now();
+		order.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			order[i] = SortEntry{ submissions[i].sortKey, static_cast<uint32_t>(i), 0 };
+		}
+		RadixSort(order, scratch, SortPriority::KeyThenOrder);
+		radixMs = std::min(radixMs, ElapsedMs(start));
+
+		sorted = submissions;
+		start = Clock::now();
+		std::sort(sorted.begin(), sorted.end(), [](const RenderSubmission& a, const RenderSubmission& b) {
+			return a.sortKey < b.sortKey;
+			});
+		stdMs = std::min(stdMs, ElapsedMs(start));
+	}
+
+	// same keys in the same order, and the radix sort keeps equal keys in push order
+	bool matched = order.size() == sorted.size();
+	for (size_t i = 0; matched && i < count; ++i) {
+		matched = order[i].sortKey == sorted[i].sortKey && submissions[order[i].index].sortKey == order[i].sortKey;
+		if (matched && i > 0 && order[i].sortKey == order[i - 1].sortKey) matched = order[i].index > order[i - 1].index;
+	}
+	// std::sort is not stable, so only the set of submissions of each key can be compared with it
+	for (size_t begin = 0; matched && begin < count;) {
+		size_t end = begin;
+		while (end < count && sorted[end].sortKey == sorted[begin].sortKey) end++;
+
+		std::vector<uint32_t> fromStd;
+		for (size_t i = begin; i < end; ++i) fromStd.push_back(static_cast<uint32_t>(sorted[i].item.modelMatrix[3][0]));
+		std::sort(fromStd.begin(), fromStd.end());
+		for (size_t i = begin; matched && i < end; ++i) matched = order[i].index == fromStd[i - begin];
+		begin = end;
+	}
+
+	std::cout << std::setw(10) << count << std::fixed << std::setprecision(3)
+		<< std::setw(16) << radixMs << std::setw(16) << stdMs
+		<< std::setprecision(1) << std::setw(9) << stdMs / radixMs << "x"
+		<< (matched ? "" : "   ORDER MISMATCH") << "\n";
+	return matched;
+}
@@ -0,0 +1,83 @@
+#include "Engine/Profiling/AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+// =========================================================
+// AllocationCounter
+// =========================================================
+
+namespace
+{
+	// constant initialized, so it is safe to read from operator new at any point of a thread's life
+	thread_local AllocationCounter* currentCounter = nullptr;
+}
+
+AllocationCounter* AllocationCounter::GetCurrent()
+{
+	return currentCounter;
+}
+
+void AllocationCounter::SetCurrent(AllocationCounter* counter)
+{
+	currentCounter = counter;
+}
+
+void AllocationCounter::CountCurrent()
+{
+	if (currentCounter) {
+		currentCounter->count.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+#if ENGINE_COUNT_ALLOCATIONS
+// =========================================================
+// Global operator new
+//
+// The array, nothrow and sized forms of the standard library forward to these.
+// =========================================================
+
+void* operator new(std::size_t size)
+{
+	AllocationCounter::CountCurrent();
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	AllocationCounter::CountCurrent();
+	size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+	void* p = _aligned_malloc(size ? size : 1, align);
+#else
+	void* p = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+	if (p) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(p, alignment);
+}
+#endif
@@ -0,0 +1,61 @@
+#include "Engine/Profiling/GpuProfiler.h"
+
+// =========================================================
+// GpuProfiler
+// =========================================================
+
+GpuProfiler::~GpuProfiler()
+{
+	if (!initialized) return;
+	for (FrameQueries& frameQueries : frames)
+		glDeleteQueries(PROFILER_GPU_MAX_SCOPES, frameQueries.queries);
+}
+
+void GpuProfiler::BeginFrame()
+{
+	if (!initialized)
+	{
+		for (FrameQueries& frameQueries : frames)
+			glGenQueries(PROFILER_GPU_MAX_SCOPES, frameQueries.queries);
+		initialized = true;
+	}
+
+	frameIndex = (frameIndex + 1) % PROFILER_GPU_QUERY_FRAMES;
+	// the oldest frame of the ring, its queries are reused now
+	FrameQueries& frameQueries = frames[frameIndex];
+	CollectResults(frameQueries);
+	frameQueries.count = 0;
+}
+
+bool GpuProfiler::BeginScope(const char* name)
+{
+	FrameQueries& frameQueries = frames[frameIndex];
+	if (!initialized || scopeOpen || frameQueries.count == PROFILER_GPU_MAX_SCOPES) return false;
+
+	uint32_t index = frameQueries.count++;
+	frameQueries.scopes[index] = { name, Profiler::Get().Now() };
+	glBeginQuery(GL_TIME_ELAPSED, frameQueries.queries[index]);
+	scopeOpen = true;
+	return true;
+}
+
+void GpuProfiler::EndScope()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	scopeOpen = false;
+}
+
+void GpuProfiler::CollectResults(FrameQueries& frameQueries)
+{
+	Profiler& profiler = Profiler::Get();
+	for (uint32_t i = 0; i < frameQueries.count; i++)
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(frameQueries.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(frameQueries.queries[i], GL_QUERY_RESULT, &elapsed);
+		profiler.Record(frameQueries.scopes[i].name, frameQueries.scopes[i].cpuStart, elapsed, true);
+	}
+}
@@ -0,0 +1,190 @@
+#include "Engine/Profiling/Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+	thread_local uint32_t threadId = UINT32_MAX;
+
+	uint64_t SteadyNanoseconds()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void WriteJsonString(std::ostream& out, const char* text)
+	{
+		out << '"';
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\') out << '\\';
+			out << *c;
+		}
+		out << '"';
+	}
+}
+
+// =========================================================
+// Profiler
+// =========================================================
+
+Profiler::Profiler() : epoch(SteadyNanoseconds())
+{
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+uint64_t Profiler::Now() const
+{
+	return SteadyNanoseconds() - epoch;
+}
+
+uint32_t Profiler::GetThreadId()
+{
+	// mutex is held by the caller
+	if (threadId == UINT32_MAX)
+	{
+		threadId = (uint32_t)threadNames.size();
+		threadNames.push_back("Thread " + std::to_string(threadId));
+	}
+	return threadId;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	threadNames[GetThreadId()] = name;
+}
+
+const char* Profiler::Intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	// set elements keep their address until erased
+	return internedNames.insert(name).first->c_str();
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t duration, bool gpu)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	uint32_t thread = GetThreadId();
+
+	scopes[{ name, thread, gpu }].frameTotal += duration;
+
+	if (capturing && captured.size() < PROFILER_MAX_CAPTURE_EVENTS)
+		captured.push_back({ name, start, duration, thread, gpu });
+}
+
+void Profiler::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& [key, history] : scopes)
+	{
+		history.frames[frameCursor] = history.frameTotal;
+		history.frameTotal = 0;
+	}
+	frameCursor = (frameCursor + 1) % PROFILER_AVERAGE_FRAMES;
+	framesRecorded = std::min(framesRecorded + 1, (uint32_t)PROFILER_AVERAGE_FRAMES);
+}
+
+std::vector<ScopeAverage> Profiler::GetAverages() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<ScopeAverage> averages;
+	if (framesRecorded == 0) return averages;
+
+	averages.reserve(scopes.size());
+	for (const auto& [key, history] : scopes)
+	{
+		uint64_t total = 0;
+		uint64_t slowest = 0;
+		for (uint32_t i = 0; i < framesRecorded; i++)
+		{
+			total += history.frames[i];
+			slowest = std::max(slowest, history.frames[i]);
+		}
+		averages.push_back({ key.name, threadNames[key.thread], key.gpu, (double)total / framesRecorded * 1e-6, (double)slowest * 1e-6 });
+	}
+
+	std::sort(averages.begin(), averages.end(), [](const ScopeAverage& a, const ScopeAverage& b)
+		{
+			return a.averageMs > b.averageMs;
+		});
+	return averages;
+}
+
+void Profiler::PrintAverages() const
+{
+	std::vector<ScopeAverage> averages = GetAverages();
+	std::cout << "Profiler averages over " << PROFILER_AVERAGE_FRAMES << " frames (avg / max ms):" << std::endl;
+	for (const ScopeAverage& average : averages)
+	{
+		std::cout << "  " << (average.gpu ? "[GPU] " : "") << average.name << " (" << average.thread << "): "
+			<< average.averageMs << " / " << average.maxMs << std::endl;
+	}
+}
+
+void Profiler::BeginCapture()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	captured.clear();
+	capturing = true;
+}
+
+bool Profiler::EndCapture(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	capturing = false;
+	bool written = WriteChromeTrace(path);
+	captured.clear();
+	captured.shrink_to_fit();
+	return written;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out.is_open())
+	{
+		std::cerr << "Profiler: could not write trace to " << path << std::endl;
+		return false;
+	}
+
+	// GPU scopes get their own track next to the thread that issued them
+	const uint32_t gpuTrackOffset = 1000;
+
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (uint32_t thread = 0; thread < threadNames.size(); thread++)
+	{
+		for (int gpu = 0; gpu < 2; gpu++)
+		{
+			if (!first) out << ",\n";
+			first = false;
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread + gpu * gpuTrackOffset << ",\"args\":{\"name\":";
+			WriteJsonString(out, gpu ? (threadNames[thread] + " GPU").c_str() : threadNames[thread].c_str());
+			out << "}}";
+		}
+	}
+
+	out.setf(std::ios::fixed);
+	out.precision(3);
+	for (const ProfileEvent& event : captured)
+	{
+		if (!first) out << ",\n";
+		first = false;
+		out << "{\"name\":";
+		WriteJsonString(out, event.name);
+		out << ",\"cat\":\"" << (event.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread + (event.gpu ? gpuTrackOffset : 0)
+			<< ",\"ts\":" << event.start * 1e-3 << ",\"dur\":" << event.duration * 1e-3 << "}";
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	std::cout << "Profiler: wrote " << captured.size() << " events to " << path << std::endl;
+	return true;
+}
@@ -1,117 +1,119 @@
 #include "Engine/Renderer/BatchBuilder.h"
+#include "Engine/Profiling/Profiler.h"
 
-#include "Engine/App.h"
-#include "Engine/Window.h"
+#include <iostream>
 
-std::vector<RenderSubmission> BatchBuilder::Build(std::vector<RenderSubmission>& sorted)
+InstanceBlock BatchBuilder::Reserve(uint32_t instanceCount, size_t maxBatches, IInstanceAllocator& instances, InstanceLayout layout, RenderList& outBatched)
 {
-	std::vector<RenderSubmission> batched;
-	if (sorted.empty()) return batched;
+	InstanceBlock block;
+	if (instanceCount == 0) return block;
+
+	// the whole list is written as one block, so a batch is just a range inside it
+	block.data = static_cast<uint8_t*>(instances.Allocate(layout, instanceCount, block.baseInstance));
+	if (!block.data) {
+		std::cerr << "BatchBuilder: instance memory is full, dropping " << instanceCount << " instances\n";
+		return block;
+	}
 
-	size_t batchStart = 0;
-	RenderSubmission& current = sorted[0];
-	InitInstanceData(current);
+	// Build must never grow the list, the arena is not thread safe
+	outBatched.reserve(outBatched.size() + maxBatches);
+	return block;
+}
 
-	if(sorted.size() == 1)
-	{
-		batched.push_back(std::move(current));
-		return batched;
-	}
+void BatchBuilder::Build(const RenderList& submissions, const SortList& order, const InstanceBlock& block, InstanceLayout layout, RenderList& outBatched)
+{
+	PROFILE_SCOPE("BatchBuilder::Build");
+	if (order.empty() || !block.data) return;
 
-	uint64_t currentKey = current.sortKey;
+	const size_t stride = GetInstanceStride(layout);
+	const size_t firstBatch = outBatched.size();
 
-	for(size_t i = 1; i < sorted.size(); ++i)
+	uint32_t written = 0;
+	for (const auto& entry : order)
 	{
-		uint64_t nextKey = sorted[i].sortKey;
-		const RenderSubmission& next = sorted[i];
-		if (currentKey == nextKey)
-		{
-			AppendInstanceData(current, next.item);
-		}
-		else
-		{
-			batched.push_back(std::move(current));
+		const RenderSubmission& next = submissions[entry.index];
+		// shadow-only casters are drawn by the shadow batches
+		if (!(next.passMask & RenderPassMask::Main)) continue;
 
-			current = next;
-			InitInstanceData(current);
-			currentKey = nextKey;
-			batchStart = i;
-		}
-	}
-	// push the last batch
-	batched.push_back(std::move(current));
+		WriteInstance(block.data + stride * written, next, layout);
 
-	return batched;
+		RenderSubmission& batch = GetBatch(next, firstBatch, outBatched);
+		if (batch.instances.count == 0) batch.instances.baseInstance = block.baseInstance + written;
+		batch.instances.count++;
+		written++;
+	}
 }
 
-void BatchBuilder::InitInstanceData(RenderSubmission& cmd)
+void BatchBuilder::BuildShadow(const RenderList& submissions, const SortList& order, bool staticCasters, const InstanceBlock& block, RenderList& outBatched)
 {
-	// if alreadt batched, skip
-	if (cmd.item.instanceData != nullptr) return;
-
-	if(cmd.item.layer != RenderLayer::GUI) cmd.item.instanceData = new InstanceData();
-	else cmd.item.instanceData = new InstanceDataGUI();
-	cmd.item.instanceData->count = 1;
-	if (cmd.item.layer != RenderLayer::GUI) {
-		dynamic_cast<InstanceData*>(cmd.item.instanceData)->modelMatrices.emplace_back(cmd.item.modelMatrix);
-	}
-	else {
-		auto& win = AppAttorney::GetWindow(App::Get());
-		float screenWidth = static_cast<float>(win.GetWidth());
-		float screenHeight = static_cast<float>(win.GetHeight());
-		auto* instanceData = dynamic_cast<InstanceDataGUI*>(cmd.item.instanceData);
+	PROFILE_SCOPE("BatchBuilder::BuildShadow");
+	if (order.empty() || !block.data) return;
 
-		//instanceData->guiData.emplace_back(GUIData{ cmd.item.uvRect, cmd.item.transform.GetGUIModelMatrix(cmd.item.relativePosition, cmd.item.relativeSize, cmd.item.anchorPoint, screenWidth, screenHeight) });
-		instanceData->guiData.emplace_back(GUIData{ cmd.item.uvRect, cmd.item.modelMatrix });
-	}
-}
+	ShadowInstanceData* dst = reinterpret_cast<ShadowInstanceData*>(block.data);
+	const size_t firstBatch = outBatched.size();
 
-void BatchBuilder::AppendInstanceData(RenderSubmission& batch, const Renderable& r)
-{
-	if(r.instanceData != nullptr)
+	uint32_t written = 0;
+	for (const auto& entry : order)
 	{
-		// already batched, merge
-		if(batch.item.layer != RenderLayer::GUI)
-		{
-			auto* batchData = dynamic_cast<InstanceData*>(batch.item.instanceData);
-			auto* srcData = dynamic_cast<InstanceData*>(r.instanceData);
+		const RenderSubmission& next = submissions[entry.index];
+		if (!(next.passMask & RenderPassMask::Shadow) || next.shadowLayers == 0) continue;
+		if (next.staticShadow != staticCasters) continue;
 
-			if(batchData && srcData)
-			{
-				batchData->modelMatrices.reserve(batchData->modelMatrices.size() + srcData->modelMatrices.size());
-				batchData->modelMatrices.insert(batchData->modelMatrices.end(), srcData->modelMatrices.begin(), srcData->modelMatrices.end());
+		RenderSubmission& batch = GetBatch(next, firstBatch, outBatched);
+		if (batch.instances.count == 0) batch.instances.baseInstance = block.baseInstance + written;
 
-				batch.item.instanceData->count += srcData->count;
-			}
-		}
-		else
+		for (uint32_t layer = 0; layer < 8; ++layer)
 		{
-			auto* batchData = dynamic_cast<InstanceDataGUI*>(batch.item.instanceData);
-			auto* srcData = dynamic_cast<InstanceDataGUI*>(r.instanceData);
+			if (!(next.shadowLayers & (1u << layer))) continue;
 
-			if (batchData && srcData) {
-				// Reserve and append both model matrices and uv offsets
-				batchData->guiData.reserve(batchData->guiData.size() + srcData->guiData.size());
-				batchData->guiData.insert(batchData->guiData.end(), srcData->guiData.begin(), srcData->guiData.end());
+			ShadowInstanceData data{};
+			data.layer = layer;
+			data.modelMatrix = GetInstanceMatrix(next.item.modelMatrix, next.shadowMeshHandle.IsValid() ? next.shadowMeshHandle : next.item.meshHandle);
+			memcpy(dst + written, &data, sizeof(ShadowInstanceData));
 
-				batch.item.instanceData->count += srcData->count;
-			}
+			batch.instances.count++;
+			written++;
 		}
-		return;
 	}
+}
 
-
-	batch.item.instanceData->count += 1;
-	if (batch.item.layer != RenderLayer::GUI) {
-		dynamic_cast<InstanceData*>(batch.item.instanceData)->modelMatrices.emplace_back(r.modelMatrix);
+void BatchBuilder::WriteInstance(uint8_t* dst, const RenderSubmission& submission, InstanceLayout layout)
+{
+	const Renderable& r = submission.item;
+	if (layout == InstanceLayout::GUI) {
+		GUIData data{ r.uvRect, r.modelMatrix };
+		memcpy(dst, &data, sizeof(GUIData));
 	}
 	else {
-		auto& win = AppAttorney::GetWindow(App::Get());
-		float screenWidth = static_cast<float>(win.GetWidth());
-		float screenHeight = static_cast<float>(win.GetHeight());
-		auto* instanceData = dynamic_cast<InstanceDataGUI*>(batch.item.instanceData);
+		ModelInstanceData data{};
+		data.materialIndex = ResourceManager::Get().materials.GetDenseId(r.materialHandle);
+		data.modelMatrix = GetInstanceMatrix(submission);
+		memcpy(dst, &data, sizeof(ModelInstanceData));
+	}
+}
+
+glm::mat4 BatchBuilder::GetInstanceMatrix(const RenderSubmission& submission)
+{
+	// impostors keep the model matrix of their mesh, which the shadow pass still draws
+	if (submission.impostor) {
+		const MeshImpostor* impostor = ResourceManager::Get().meshes.GetImpostor(submission.shadowMeshHandle);
+		return impostor ? submission.item.modelMatrix * impostor->quadFrame : submission.item.modelMatrix;
+	}
+	return GetInstanceMatrix(submission.item.modelMatrix, submission.item.meshHandle);
+}
+
+glm::mat4 BatchBuilder::GetInstanceMatrix(const glm::mat4& modelMatrix, MeshManager::Handle mesh)
+{
+	const glm::mat4* decode = ResourceManager::Get().meshes.GetPositionDecode(mesh);
+	return decode ? modelMatrix * *decode : modelMatrix;
+}
 
-		//instanceData->guiData.emplace_back(GUIData{r.uvRect,  r.transform.GetGUIModelMatrix(r.relativePosition, r.relativeSize, r.anchorPoint, screenWidth, screenHeight)});
-		instanceData->guiData.emplace_back(GUIData{ r.uvRect,  r.modelMatrix});
+RenderSubmission& BatchBuilder::GetBatch(const RenderSubmission& next, size_t firstBatch, RenderList& outBatched)
+{
+	if (outBatched.size() == firstBatch || outBatched.back().sortKey != next.sortKey)
+	{
+		outBatched.push_back(next);
+		outBatched.back().instances = InstanceRange{};
 	}
+	return outBatched.back();
 }
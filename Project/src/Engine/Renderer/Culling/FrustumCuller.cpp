@@ -0,0 +1,244 @@
+#include "Engine/Renderer/Culling/FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CULLING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define CULLING_X86 0
+#endif
+
+// MSVC allows AVX intrinsics in any function, other compilers need them enabled per function
+#if defined(_MSC_VER)
+#define CULLING_TARGET_AVX
+#else
+#define CULLING_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+// large enough to pass every plane, small enough to not overflow to inf in the plane sum
+#define CULLING_UNBOUNDED_EXTENT 1e30f
+
+// =========================================================
+// CullingBoundsSoA
+// =========================================================
+
+void CullingBoundsSoA::Resize(size_t size)
+{
+	centerX.resize(size); centerY.resize(size); centerZ.resize(size);
+	extentX.resize(size); extentY.resize(size); extentZ.resize(size);
+}
+
+void CullingBoundsSoA::Set(size_t index, const BoundingBox& box)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	centerX[index] = center.x; centerY[index] = center.y; centerZ[index] = center.z;
+	extentX[index] = extent.x; extentY[index] = extent.y; extentZ[index] = extent.z;
+}
+
+void CullingBoundsSoA::SetUnbounded(size_t index)
+{
+	centerX[index] = 0.f; centerY[index] = 0.f; centerZ[index] = 0.f;
+	extentX[index] = CULLING_UNBOUNDED_EXTENT;
+	extentY[index] = CULLING_UNBOUNDED_EXTENT;
+	extentZ[index] = CULLING_UNBOUNDED_EXTENT;
+}
+
+void CullingBoundsSoA::SwapRemove(size_t index)
+{
+	size_t last = Size() - 1;
+	if (index != last) {
+		centerX[index] = centerX[last]; centerY[index] = centerY[last]; centerZ[index] = centerZ[last];
+		extentX[index] = extentX[last]; extentY[index] = extentY[last]; extentZ[index] = extentZ[last];
+	}
+	Resize(last);
+}
+
+void CullingBoundsSoA::Clear()
+{
+	Resize(0);
+}
+
+// =========================================================
+// FrustumCuller
+// =========================================================
+
+namespace
+{
+	// frustum planes split per component, with the absolute normal precomputed for the extent projection
+	struct FrustumPlanesSoA
+	{
+		float nx[6], ny[6], nz[6];
+		float ax[6], ay[6], az[6];
+		float d[6];
+	};
+
+	FrustumPlanesSoA SplitPlanes(const Frustum& frustum)
+	{
+		const Plane* planes[6] = {
+			&frustum.left, &frustum.right,
+			&frustum.top, &frustum.bottom,
+			&frustum.near, &frustum.far
+		};
+
+		FrustumPlanesSoA out;
+		for (int p = 0; p < 6; ++p) {
+			const glm::vec3& n = planes[p]->normal;
+			out.nx[p] = n.x; out.ny[p] = n.y; out.nz[p] = n.z;
+			out.ax[p] = std::fabs(n.x); out.ay[p] = std::fabs(n.y); out.az[p] = std::fabs(n.z);
+			out.d[p] = planes[p]->d;
+		}
+		return out;
+	}
+
+	// a box is outside a plane if its center is further behind it than the extent projected on the normal,
+	// same result as testing the positive vertex
+	void CullScalar(const FrustumPlanesSoA& planes, const CullingBoundsSoA& b, size_t begin, size_t end, uint32_t* out)
+	{
+		for (size_t i = begin; i < end; ++i) {
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; ++p) {
+				float dist = planes.nx[p] * b.centerX[i] + planes.ny[p] * b.centerY[i] + planes.nz[p] * b.centerZ[i] + planes.d[p];
+				float radius = planes.ax[p] * b.extentX[i] + planes.ay[p] * b.extentY[i] + planes.az[p] * b.extentZ[i];
+				visible = dist + radius >= 0.f;
+			}
+			if (visible) {
+				out[i >> 5] |= 1u << (i & 31);
+			}
+		}
+	}
+
+#if CULLING_X86
+	size_t CullSSE(const FrustumPlanesSoA& planes, const CullingBoundsSoA& b, size_t begin, size_t end, uint32_t* out)
+	{
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			__m128 cx = _mm_loadu_ps(&b.centerX[i]);
+			__m128 cy = _mm_loadu_ps(&b.centerY[i]);
+			__m128 cz = _mm_loadu_ps(&b.centerZ[i]);
+			__m128 ex = _mm_loadu_ps(&b.extentX[i]);
+			__m128 ey = _mm_loadu_ps(&b.extentY[i]);
+			__m128 ez = _mm_loadu_ps(&b.extentZ[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p) {
+				__m128 dist = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(planes.nx[p])), _mm_mul_ps(cy, _mm_set1_ps(planes.ny[p]))),
+					_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(planes.nz[p])), _mm_set1_ps(planes.d[p])));
+				__m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(planes.ax[p])), _mm_mul_ps(ey, _mm_set1_ps(planes.ay[p]))),
+					_mm_mul_ps(ez, _mm_set1_ps(planes.az[p])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+			}
+
+			// begin is a multiple of 32, so the 4 bits never straddle two words
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+			out[i >> 5] |= mask << (i & 31);
+		}
+		return i;
+	}
+
+	CULLING_TARGET_AVX size_t CullAVX(const FrustumPlanesSoA& planes, const CullingBoundsSoA& b, size_t begin, size_t end, uint32_t* out)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			__m256 cx = _mm256_loadu_ps(&b.centerX[i]);
+			__m256 cy = _mm256_loadu_ps(&b.centerY[i]);
+			__m256 cz = _mm256_loadu_ps(&b.centerZ[i]);
+			__m256 ex = _mm256_loadu_ps(&b.extentX[i]);
+			__m256 ey = _mm256_loadu_ps(&b.extentY[i]);
+			__m256 ez = _mm256_loadu_ps(&b.extentZ[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p) {
+				__m256 dist = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(planes.nx[p])), _mm256_mul_ps(cy, _mm256_set1_ps(planes.ny[p]))),
+					_mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(planes.nz[p])), _mm256_set1_ps(planes.d[p])));
+				__m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(planes.ax[p])), _mm256_mul_ps(ey, _mm256_set1_ps(planes.ay[p]))),
+					_mm256_mul_ps(ez, _mm256_set1_ps(planes.az[p])));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+			}
+
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+			out[i >> 5] |= mask << (i & 31);
+		}
+		return i;
+	}
+
+	bool CPUSupportsAVX()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		// the OS must also save the ymm registers on context switches
+		return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+#endif
+}
+
+CullingPath GetDefaultCullingPath()
+{
+#if CULLING_X86
+	static const CullingPath path = CPUSupportsAVX() ? CullingPath::AVX : CullingPath::SSE;
+	return path;
+#else
+	return CullingPath::Scalar;
+#endif
+}
+
+const char* GetCullingPathName(CullingPath path)
+{
+	switch (path) {
+	case CullingPath::AVX:
+		return "AVX";
+	case CullingPath::SSE:
+		return "SSE";
+	case CullingPath::Scalar:
+	default:
+		return "Scalar";
+	}
+}
+
+void CullBounds(const Frustum& frustum, const CullingBoundsSoA& bounds, std::pmr::vector<uint32_t>& outVisibility)
+{
+	CullBounds(frustum, bounds, outVisibility, GetDefaultCullingPath());
+}
+
+void CullBounds(const Frustum& frustum, const CullingBoundsSoA& bounds, std::pmr::vector<uint32_t>& outVisibility, CullingPath path)
+{
+	size_t count = bounds.Size();
+	outVisibility.assign((count + 31) / 32, 0u);
+	CullBoundsRange(frustum, bounds, 0, count, outVisibility.data(), path);
+}
+
+void CullBoundsRange(const Frustum& frustum, const CullingBoundsSoA& bounds, size_t begin, size_t end, uint32_t* outVisibility, CullingPath path)
+{
+	if (begin >= end) return;
+
+	FrustumPlanesSoA planes = SplitPlanes(frustum);
+
+	size_t done = begin;
+#if CULLING_X86
+	if (path == CullingPath::AVX) {
+		done = CullAVX(planes, bounds, begin, end, outVisibility);
+	}
+	else if (path == CullingPath::SSE) {
+		done = CullSSE(planes, bounds, begin, end, outVisibility);
+	}
+#endif
+	CullScalar(planes, bounds, done, end, outVisibility);
+}
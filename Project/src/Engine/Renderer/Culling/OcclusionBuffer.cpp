@@ -0,0 +1,284 @@
+#include "Engine/Renderer/Culling/OcclusionBuffer.h"
+
+#include "Engine/Resources/MeshManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OCCLUSION_X86 1
+#include <emmintrin.h>
+#else
+#define OCCLUSION_X86 0
+#endif
+
+// vertices closer than this to the camera plane are not projected, their triangles are dropped
+#define OCCLUSION_MIN_W 1e-5f
+
+namespace
+{
+	// edge functions and depth plane of a triangle in pixel space, and the pixels it may cover
+	struct TriangleSetup
+	{
+		float ea[3], eb[3], ec[3];
+		float za, zb, zc;
+		int minX, maxX, minY, maxY;
+	};
+
+	bool RasterizeScalar(const TriangleSetup& t, float* depth, uint32_t width)
+	{
+		bool wrote = false;
+		for (int y = t.minY; y <= t.maxY; ++y) {
+			float py = float(y) + 0.5f;
+			float* row = depth + size_t(y) * width;
+			for (int x = t.minX; x <= t.maxX; ++x) {
+				float px = float(x) + 0.5f;
+				if (t.ea[0] * px + t.eb[0] * py + t.ec[0] < 0.f) continue;
+				if (t.ea[1] * px + t.eb[1] * py + t.ec[1] < 0.f) continue;
+				if (t.ea[2] * px + t.eb[2] * py + t.ec[2] < 0.f) continue;
+				row[x] = std::min(row[x], t.za * px + t.zb * py + t.zc);
+				wrote = true;
+			}
+		}
+		return wrote;
+	}
+
+#if OCCLUSION_X86
+	// 4 pixels per iteration, rows start on a multiple of 4 so they never run past the buffer
+	bool RasterizeSSE(const TriangleSetup& t, float* depth, uint32_t width)
+	{
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 e0Step = _mm_set1_ps(t.ea[0] * 4.f);
+		const __m128 e1Step = _mm_set1_ps(t.ea[1] * 4.f);
+		const __m128 e2Step = _mm_set1_ps(t.ea[2] * 4.f);
+		const __m128 zStep = _mm_set1_ps(t.za * 4.f);
+
+		bool wrote = false;
+		int startX = t.minX & ~3;
+		for (int y = t.minY; y <= t.maxY; ++y) {
+			float py = float(y) + 0.5f;
+			__m128 px = _mm_add_ps(_mm_set1_ps(float(startX)), laneOffsets);
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.ea[0]), px), _mm_set1_ps(t.eb[0] * py + t.ec[0]));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.ea[1]), px), _mm_set1_ps(t.eb[1] * py + t.ec[1]));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.ea[2]), px), _mm_set1_ps(t.eb[2] * py + t.ec[2]));
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.za), px), _mm_set1_ps(t.zb * py + t.zc));
+
+			float* row = depth + size_t(y) * width;
+			for (int x = startX; x <= t.maxX; x += 4) {
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside) != 0) {
+					__m128 old = _mm_loadu_ps(row + x);
+					__m128 nearest = _mm_min_ps(old, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+					wrote = true;
+				}
+				e0 = _mm_add_ps(e0, e0Step);
+				e1 = _mm_add_ps(e1, e1Step);
+				e2 = _mm_add_ps(e2, e2Step);
+				z = _mm_add_ps(z, zStep);
+			}
+		}
+		return wrote;
+	}
+#endif
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+	: width(width), height(height),
+	tilesX(width / OCCLUSION_TILE_SIZE), tilesY(height / OCCLUSION_TILE_SIZE),
+	depth(size_t(width) * height, 1.f),
+	tileMaxDepth(size_t(tilesX) * tilesY, 1.f)
+{
+}
+
+void OcclusionBuffer::Begin(const glm::mat4& projectionView)
+{
+	this->projectionView = projectionView;
+	hasOccluders = false;
+	std::fill(depth.begin(), depth.end(), 1.f);
+	std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.f);
+}
+
+void OcclusionBuffer::RasterizeMesh(const Mesh& mesh, const glm::mat4& modelMatrix)
+{
+	if (mesh.primitive != GL_TRIANGLES || mesh.vertexData.empty()) return;
+
+	const VertexAttribute* position = nullptr;
+	for (const auto& attribute : mesh.attributes) {
+		if (attribute.index == 0) {
+			position = &attribute;
+			break;
+		}
+	}
+	if (!position || position->size < 3) return;
+	bool quantized = position->type == GL_UNSIGNED_SHORT && position->normalized;
+	if (position->type != GL_FLOAT && !quantized) return;
+
+	RasterizeTriangles(mesh.vertexData.data(), mesh.vertexStride, position->offset, mesh.vertexCount,
+		mesh.indices.empty() ? nullptr : mesh.indices.data(),
+		mesh.indices.empty() ? mesh.vertexCount : mesh.indices.size(),
+		modelMatrix * mesh.positionDecode, quantized);
+}
+
+void OcclusionBuffer::RasterizeTriangles(const uint8_t* vertexData, uint32_t vertexStride, uint32_t positionOffset, uint32_t vertexCount,
+	const uint32_t* indices, size_t indexCount, const glm::mat4& modelMatrix, bool quantized)
+{
+	const glm::mat4 toClip = projectionView * modelMatrix;
+
+	clipPositions.resize(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i) {
+		const uint8_t* source = vertexData + size_t(i) * vertexStride + positionOffset;
+		glm::vec3 p;
+		if (quantized) {
+			uint16_t q[3];
+			std::memcpy(q, source, sizeof(q));
+			p = glm::vec3(q[0], q[1], q[2]) * (1.f / 65535.f);
+		}
+		else {
+			// glm::vec3 may be padded to 16 bytes, only 3 floats are in the vertex
+			float f[3];
+			std::memcpy(f, source, sizeof(f));
+			p = glm::vec3(f[0], f[1], f[2]);
+		}
+		clipPositions[i] = toClip * glm::vec4(p, 1.f);
+	}
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		uint32_t i0 = indices ? indices[i] : uint32_t(i);
+		uint32_t i1 = indices ? indices[i + 1] : uint32_t(i + 1);
+		uint32_t i2 = indices ? indices[i + 2] : uint32_t(i + 2);
+		if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+		RasterizeTriangle(clipPositions[i0], clipPositions[i1], clipPositions[i2]);
+	}
+}
+
+void OcclusionBuffer::RasterizeTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2)
+{
+	// no near plane clipping: dropping the triangle only loses occlusion, it never hides anything wrongly
+	if (c0.w < OCCLUSION_MIN_W || c1.w < OCCLUSION_MIN_W || c2.w < OCCLUSION_MIN_W) return;
+
+	// to pixel space, depth to [0, 1]
+	glm::vec3 v[3];
+	const glm::vec4* clip[3] = { &c0, &c1, &c2 };
+	for (int k = 0; k < 3; ++k) {
+		float invW = 1.f / clip[k]->w;
+		v[k].x = (clip[k]->x * invW * 0.5f + 0.5f) * float(width);
+		v[k].y = (clip[k]->y * invW * 0.5f + 0.5f) * float(height);
+		v[k].z = clip[k]->z * invW * 0.5f + 0.5f;
+	}
+	if (v[0].z > 1.f && v[1].z > 1.f && v[2].z > 1.f) return;
+
+	float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+	if (std::abs(area) < 1e-8f) return;
+	// both windings are drawn, the nearest depth wins anyway
+	if (area < 0.f) {
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	// pixels whose center may be inside the triangle
+	TriangleSetup t;
+	t.minX = std::max(0, int(std::ceil(std::min({ v[0].x, v[1].x, v[2].x }) - 0.5f)));
+	t.maxX = std::min(int(width) - 1, int(std::floor(std::max({ v[0].x, v[1].x, v[2].x }) - 0.5f)));
+	t.minY = std::max(0, int(std::ceil(std::min({ v[0].y, v[1].y, v[2].y }) - 0.5f)));
+	t.maxY = std::min(int(height) - 1, int(std::floor(std::max({ v[0].y, v[1].y, v[2].y }) - 0.5f)));
+	if (t.minX > t.maxX || t.minY > t.maxY) return;
+
+	// edge functions E(x, y) = a * x + b * y + c, positive inside; edge k is opposite to vertex k.
+	// c is taken from the same endpoint whichever way the edge runs, so the two triangles sharing an
+	// edge get exactly negated functions and pixel centers on it can't be missed by both
+	for (int k = 0; k < 3; ++k) {
+		const glm::vec3& from = v[(k + 1) % 3];
+		const glm::vec3& to = v[(k + 2) % 3];
+		const glm::vec3& anchor = (from.x < to.x || (from.x == to.x && from.y < to.y)) ? from : to;
+		t.ea[k] = -(to.y - from.y);
+		t.eb[k] = to.x - from.x;
+		t.ec[k] = -(t.ea[k] * anchor.x + t.eb[k] * anchor.y);
+	}
+
+	// depth is linear in screen space, so it is a plane too
+	float invArea = 1.f / area;
+	t.za = (t.ea[0] * v[0].z + t.ea[1] * v[1].z + t.ea[2] * v[2].z) * invArea;
+	t.zb = (t.eb[0] * v[0].z + t.eb[1] * v[1].z + t.eb[2] * v[2].z) * invArea;
+	t.zc = (t.ec[0] * v[0].z + t.ec[1] * v[1].z + t.ec[2] * v[2].z) * invArea;
+
+#if OCCLUSION_X86
+	bool wrote = rasterPath == CullingPath::Scalar ? RasterizeScalar(t, depth.data(), width) : RasterizeSSE(t, depth.data(), width);
+#else
+	bool wrote = RasterizeScalar(t, depth.data(), width);
+#endif
+	hasOccluders |= wrote;
+}
+
+void OcclusionBuffer::Finish()
+{
+	for (uint32_t ty = 0; ty < tilesY; ++ty) {
+		for (uint32_t tx = 0; tx < tilesX; ++tx) {
+			float farthest = 0.f;
+			for (uint32_t y = ty * OCCLUSION_TILE_SIZE; y < (ty + 1) * OCCLUSION_TILE_SIZE; ++y) {
+				const float* row = depth.data() + size_t(y) * width + tx * OCCLUSION_TILE_SIZE;
+				for (uint32_t x = 0; x < OCCLUSION_TILE_SIZE; ++x) {
+					farthest = std::max(farthest, row[x]);
+				}
+			}
+			tileMaxDepth[ty * tilesX + tx] = farthest;
+		}
+	}
+}
+
+bool OcclusionBuffer::IsVisible(const BoundingBox& worldBounds) const
+{
+	if (!hasOccluders) return true;
+
+	// screen rectangle and nearest depth of the box
+	float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+	float nearestDepth = INFINITY;
+	for (const glm::vec3& corner : worldBounds.GetCorners()) {
+		glm::vec4 clip = projectionView * glm::vec4(corner, 1.f);
+		// reaches behind the camera, the projected rectangle would be wrong
+		if (clip.w < OCCLUSION_MIN_W) return true;
+
+		float invW = 1.f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * float(width);
+		float y = (clip.y * invW * 0.5f + 0.5f) * float(height);
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		nearestDepth = std::min(nearestDepth, clip.z * invW * 0.5f + 0.5f);
+	}
+
+	// every pixel the rectangle touches
+	int x0 = std::max(0, int(std::floor(minX)));
+	int x1 = std::min(int(width) - 1, int(std::floor(maxX)));
+	int y0 = std::max(0, int(std::floor(minY)));
+	int y1 = std::min(int(height) - 1, int(std::floor(maxY)));
+	// off screen, that is for the frustum test to decide
+	if (x0 > x1 || y0 > y1) return true;
+
+	int tx0 = x0 / OCCLUSION_TILE_SIZE, tx1 = x1 / OCCLUSION_TILE_SIZE;
+	int ty0 = y0 / OCCLUSION_TILE_SIZE, ty1 = y1 / OCCLUSION_TILE_SIZE;
+	for (int ty = ty0; ty <= ty1; ++ty) {
+		for (int tx = tx0; tx <= tx1; ++tx) {
+			// every pixel of the tile is in front of the box
+			if (tileMaxDepth[ty * tilesX + tx] < nearestDepth) continue;
+
+			int px0 = std::max(x0, tx * OCCLUSION_TILE_SIZE);
+			int px1 = std::min(x1, (tx + 1) * OCCLUSION_TILE_SIZE - 1);
+			int py0 = std::max(y0, ty * OCCLUSION_TILE_SIZE);
+			int py1 = std::min(y1, (ty + 1) * OCCLUSION_TILE_SIZE - 1);
+
+			// the farthest pixel of the tile is covered by the box
+			if (px1 - px0 + 1 == OCCLUSION_TILE_SIZE && py1 - py0 + 1 == OCCLUSION_TILE_SIZE) return true;
+
+			for (int y = py0; y <= py1; ++y) {
+				const float* row = depth.data() + size_t(y) * width;
+				for (int x = px0; x <= px1; ++x) {
+					if (row[x] >= nearestDepth) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
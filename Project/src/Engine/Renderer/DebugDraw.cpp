@@ -0,0 +1,153 @@
+#include "Engine/Renderer/DebugDraw.h"
+
+#include "Engine/Resources/ResourceManager.h"
+#include "Engine/Renderer/GLStateCache.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+DebugDraw::DebugDraw()
+{
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+
+	capacity = DEBUG_DRAW_INITIAL_VERTICES;
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	vertices.reserve(DEBUG_DRAW_INITIAL_VERTICES);
+}
+
+DebugDraw::~DebugDraw()
+{
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+}
+
+void DebugDraw::AddLine(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color)
+{
+	if (!enabled) return;
+
+	uint32_t packed = PackColor(color);
+	vertices.push_back({ from, packed });
+	vertices.push_back({ to, packed });
+}
+
+void DebugDraw::AddBox(const BoundingBox& box, const glm::vec3& color)
+{
+	if (!enabled) return;
+
+	const glm::vec3& a = box.min;
+	const glm::vec3& b = box.max;
+	glm::vec3 c[8] = {
+		{ a.x, a.y, a.z }, { b.x, a.y, a.z }, { b.x, b.y, a.z }, { a.x, b.y, a.z },
+		{ a.x, a.y, b.z }, { b.x, a.y, b.z }, { b.x, b.y, b.z }, { a.x, b.y, b.z },
+	};
+	for (int i = 0; i < 4; ++i) {
+		AddLine(c[i], c[(i + 1) % 4], color);			// min z face
+		AddLine(c[i + 4], c[(i + 1) % 4 + 4], color);	// max z face
+		AddLine(c[i], c[i + 4], color);					// edges along z
+	}
+}
+
+void DebugDraw::AddSphere(const glm::vec3& center, float radius, const glm::vec3& color, uint32_t segments)
+{
+	if (!enabled || segments < 3) return;
+
+	const float step = glm::two_pi<float>() / float(segments);
+	for (uint32_t i = 0; i < segments; ++i) {
+		float a0 = step * float(i);
+		float a1 = step * float(i + 1);
+		glm::vec2 p0 = glm::vec2(std::cos(a0), std::sin(a0)) * radius;
+		glm::vec2 p1 = glm::vec2(std::cos(a1), std::sin(a1)) * radius;
+
+		AddLine(center + glm::vec3(p0.x, p0.y, 0.f), center + glm::vec3(p1.x, p1.y, 0.f), color);
+		AddLine(center + glm::vec3(p0.x, 0.f, p0.y), center + glm::vec3(p1.x, 0.f, p1.y), color);
+		AddLine(center + glm::vec3(0.f, p0.x, p0.y), center + glm::vec3(0.f, p1.x, p1.y), color);
+	}
+}
+
+void DebugDraw::AddFrustum(const glm::mat4& projectionView, const glm::vec3& color)
+{
+	if (!enabled) return;
+
+	// corners of the NDC cube back in world space
+	glm::mat4 inverse = glm::inverse(projectionView);
+	glm::vec3 c[8];
+	for (int i = 0; i < 8; ++i) {
+		glm::vec4 ndc((i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f, (i & 4) ? 1.f : -1.f, 1.f);
+		glm::vec4 world = inverse * ndc;
+		c[i] = glm::vec3(world) / world.w;
+	}
+
+	// corners differing by exactly one bit share an edge
+	for (int i = 0; i < 8; ++i) {
+		for (int bit = 1; bit < 8; bit <<= 1) {
+			if (!(i & bit)) AddLine(c[i], c[i | bit], color);
+		}
+	}
+}
+
+void DebugDraw::AddNormal(const glm::vec3& point, const glm::vec3& normal, float length, const glm::vec3& color)
+{
+	if (!enabled) return;
+
+	AddLine(point, point + normal * length, color);
+
+	float marker = length * 0.1f;
+	AddLine(point - glm::vec3(marker, 0.f, 0.f), point + glm::vec3(marker, 0.f, 0.f), color);
+	AddLine(point - glm::vec3(0.f, marker, 0.f), point + glm::vec3(0.f, marker, 0.f), color);
+	AddLine(point - glm::vec3(0.f, 0.f, marker), point + glm::vec3(0.f, 0.f, marker), color);
+}
+
+void DebugDraw::Publish(std::vector<DebugVertex>& out)
+{
+	out.swap(vertices);
+	vertices.clear();
+}
+
+void DebugDraw::Draw(const std::vector<DebugVertex>& lines, GLStateCache& glState)
+{
+	if (lines.empty()) return;
+
+	auto& _sm = ResourceManager::Get().shaders;
+	auto shader = _sm.GetHandle(DEBUG_DRAW_SHADER_NAME);
+	if (!shader.IsValid()) return;
+	_sm.UseShader(shader, &glState);
+
+	if (lines.size() > capacity) {
+		capacity = std::max(lines.size(), capacity * 2);
+	}
+
+	// orphan the storage (growing it if needed), so the upload never waits on last frame's draw
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, lines.size() * sizeof(DebugVertex), lines.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(vao);
+	glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.size()));
+	ResourceManager::Get().meshes.UnbindMesh();
+
+	// the cached mesh is no longer bound
+	glState.currentMesh = MeshManager::Handle{};
+	glState.currentDynamicMesh = nullptr;
+}
+
+uint32_t DebugDraw::PackColor(const glm::vec3& color)
+{
+	glm::vec3 c = glm::clamp(color, 0.f, 1.f) * 255.f + 0.5f;
+	return uint32_t(c.r) | (uint32_t(c.g) << 8) | (uint32_t(c.b) << 16) | (255u << 24);
+}
@@ -0,0 +1,80 @@
+#include "Engine/Renderer/FrameArena.h"
+
+#include <algorithm>
+#include <new>
+
+// =========================================================
+// FrameArena
+// =========================================================
+
+FrameArena::FrameArena(size_t initialSize)
+{
+	// the block list itself should never allocate after warm up either
+	blocks.reserve(16);
+	AllocateBlock(initialSize);
+}
+
+FrameArena::~FrameArena()
+{
+	FreeBlocks();
+}
+
+void FrameArena::Reset()
+{
+	if (blocks.size() > 1) {
+		size_t totalSize = GetCapacity();
+		FreeBlocks();
+		AllocateBlock(totalSize);
+	}
+	offset = 0;
+	usedBytes = 0;
+
+	lastFrameHeapAllocations = frameHeapAllocations;
+	frameHeapAllocations = 0;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const auto& block : blocks) {
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+	size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+	if (blocks.empty() || aligned + bytes > blocks.back().size) {
+		// grow geometrically, so a growing frame needs few extra blocks
+		size_t lastSize = blocks.empty() ? FRAME_ARENA_DEFAULT_SIZE : blocks.back().size;
+		AllocateBlock(std::max(lastSize * 2, bytes + alignment));
+		aligned = 0;
+	}
+
+	offset = aligned + bytes;
+	usedBytes += bytes;
+	return blocks.back().data + aligned;
+}
+
+void FrameArena::AllocateBlock(size_t size)
+{
+	Block block;
+	block.size = size;
+	block.data = static_cast<uint8_t*>(::operator new(size, std::align_val_t(FRAME_ARENA_ALIGNMENT)));
+	blocks.push_back(block);
+	offset = 0;
+
+	frameHeapAllocations++;
+	totalHeapAllocations++;
+}
+
+void FrameArena::FreeBlocks()
+{
+	for (auto& block : blocks) {
+		::operator delete(block.data, std::align_val_t(FRAME_ARENA_ALIGNMENT));
+	}
+	blocks.clear();
+	offset = 0;
+}
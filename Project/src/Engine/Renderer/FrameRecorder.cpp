@@ -0,0 +1,210 @@
+#include "Engine/Renderer/FrameRecorder.h"
+
+#include "Engine/Renderer/BatchBuilder.h"
+#include "Engine/Profiling/Profiler.h"
+#include "Engine/Profiling/AllocationCounter.h"
+
+#include <iostream>
+
+// =================================================
+// RendererStats
+// =================================================
+
+void RendererStats::Print() const
+{
+	std::cout << "LOD   draws (instances)   shadow draws (instances)\n";
+	for (int level = 0; level < MESH_MAX_LODS; ++level)
+	{
+		std::cout << "  " << level << "   " << lodDraws[level] << " (" << lodInstances[level] << ")"
+			<< "   " << shadowLodDraws[level] << " (" << shadowLodInstances[level] << ")\n";
+	}
+	std::cout << "Impostors " << impostorDraws << " (" << impostorInstances << ")\n";
+	std::cout << "Point lights " << pointLights << " (" << clusteredLightIndices << " cluster entries)\n";
+	std::cout << "Shadow layers drawn " << shadowLayersDrawn << ", static casters redrawn in " << shadowLayersCached << "\n";
+	if (AllocationCounter::IsEnabled())
+		std::cout << "Heap allocations " << heapAllocations << "\n";
+}
+
+// =================================================
+// FrameRecorder
+// =================================================
+
+FrameRecorder::FrameRecorder(FrameArena& arena, WorkerPool& workers) : arena(arena), workers(workers), renderQueue(arena, workers)
+{
+}
+
+void FrameRecorder::BuildBatches(const glm::vec3& viewPos, const Frustum* shadowFrusta, uint32_t shadowLayerCount,
+	uint8_t staticLayers, uint8_t dynamicLayers, IInstanceAllocator& instances)
+{
+	PROFILE_SCOPE("BuildBatches");
+	renderQueue.Sort(viewPos);
+	auto& opaqueOrder = renderQueue.GetOrder(RenderLayer::Opaque);
+	auto& transparentOrder = renderQueue.GetOrder(RenderLayer::Transparent);
+	auto& guiOrder = renderQueue.GetOrder(RenderLayer::GUI);
+
+	ShadowCasterCounts shadowInstances = renderQueue.CullShadowCasters(shadowFrusta, shadowLayerCount, staticLayers, dynamicLayers);
+
+	// every list is written as one block, the extra stride per list covers the alignment between blocks
+	const size_t modelStride = GetInstanceStride(InstanceLayout::Model);
+	const size_t guiStride = GetInstanceStride(InstanceLayout::GUI);
+	const size_t shadowStride = GetInstanceStride(InstanceLayout::Shadow);
+	instances.Reserve(
+		(opaqueOrder.size() + transparentOrder.size() + 1) * modelStride +
+		(guiOrder.size() + 1) * guiStride +
+		(shadowInstances.staticInstances + shadowInstances.dynamicInstances + 2) * shadowStride);
+
+	// blocks are reserved in a fixed order, so the instance layout does not depend on thread timing
+	auto reserve = [&instances](const SortList& order, InstanceLayout layout, RenderList& outBatched) {
+		return BatchBuilder::Reserve(static_cast<uint32_t>(order.size()), order.size(), instances, layout, outBatched);
+		};
+	InstanceBlock opaqueBlock = reserve(opaqueOrder, InstanceLayout::Model, batchedOpaque);
+	InstanceBlock transparentBlock = reserve(transparentOrder, InstanceLayout::Model, batchedTransparent);
+	InstanceBlock guiBlock = reserve(guiOrder, InstanceLayout::GUI, batchedGUI);
+	InstanceBlock shadowBlock = BatchBuilder::Reserve(shadowInstances.dynamicInstances, opaqueOrder.size(), instances, InstanceLayout::Shadow, batchedShadow);
+	InstanceBlock staticShadowBlock = BatchBuilder::Reserve(shadowInstances.staticInstances, opaqueOrder.size(), instances, InstanceLayout::Shadow, batchedStaticShadow);
+
+	workers.Run(
+		[&]() { BatchBuilder::Build(renderQueue.GetLayer(RenderLayer::Opaque), opaqueOrder, opaqueBlock, InstanceLayout::Model, batchedOpaque); },
+		[&]() { BatchBuilder::BuildShadow(renderQueue.GetLayer(RenderLayer::Opaque), opaqueOrder, false, shadowBlock, batchedShadow); },
+		[&]() { BatchBuilder::BuildShadow(renderQueue.GetLayer(RenderLayer::Opaque), opaqueOrder, true, staticShadowBlock, batchedStaticShadow); },
+		[&]() { BatchBuilder::Build(renderQueue.GetLayer(RenderLayer::Transparent), transparentOrder, transparentBlock, InstanceLayout::Model, batchedTransparent); },
+		[&]() { BatchBuilder::Build(renderQueue.GetLayer(RenderLayer::GUI), guiOrder, guiBlock, InstanceLayout::GUI, batchedGUI); }
+		);
+}
+
+const RenderList& FrameRecorder::GetBatches(RenderLayer layer) const
+{
+	switch (layer) {
+	case RenderLayer::Transparent:
+		return batchedTransparent;
+	case RenderLayer::GUI:
+		return batchedGUI;
+	case RenderLayer::Opaque:
+	default:
+		return batchedOpaque;
+	}
+}
+
+void FrameRecorder::EndFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(lastFrameStatsMutex);
+		lastFrameStats = stats;
+	}
+
+	// every list lives in the frame arena, so they let go of their storage before it is reset
+	renderQueue.Clear();
+	ReleaseArenaStorage(batchedOpaque);
+	ReleaseArenaStorage(batchedShadow);
+	ReleaseArenaStorage(batchedStaticShadow);
+	ReleaseArenaStorage(batchedTransparent);
+	ReleaseArenaStorage(batchedGUI);
+
+	arena.Reset();
+
+	// pre-size the lists from this frame, so next frame does not regrow them through the arena
+	// the batch lists are sized by BatchBuilder::Reserve
+	renderQueue.Reserve();
+}
+
+RendererStats FrameRecorder::GetLastFrameStats() const
+{
+	std::lock_guard<std::mutex> lock(lastFrameStatsMutex);
+	return lastFrameStats;
+}
+
+// =================================================
+// Record functions
+// =================================================
+
+const CommandBuffer& FrameRecorder::RecordShadowPass(bool staticCasters, ShaderManager::Handle shader)
+{
+	commands.Reset();
+	//face culling is always enabled for shadow pass
+	commands.SetRenderState(RenderStateFlags::Default);
+	// no material application needed for shadow pass
+	commands.BindShader(shader);
+	for (auto& submission : GetShadowBatches(staticCasters))
+	{
+		RecordShadowSubmission(submission);
+	}
+	return commands;
+}
+
+const CommandBuffer& FrameRecorder::RecordMainPass()
+{
+	commands.Reset();
+	RecordList(batchedOpaque, RenderLayer::Opaque);
+	RecordList(batchedTransparent, RenderLayer::Transparent);
+	return commands;
+}
+
+const CommandBuffer& FrameRecorder::RecordGUIPass()
+{
+	commands.Reset();
+	RecordList(batchedGUI, RenderLayer::GUI);
+	return commands;
+}
+
+void FrameRecorder::RecordList(const RenderList& submissions, RenderLayer layer)
+{
+	if (layer == RenderLayer::GUI) {
+		commands.SetRenderState(0);
+
+		MeshManager::Handle quad = ResourceManager::Get().meshes.GetHandle("primitive/quad");
+		for (const auto& submission : submissions) {
+			RecordGUISubmission(submission, quad);
+		}
+		return;
+	}
+
+	// transparent surfaces are blended over each other, so they do not write depth
+	uint8_t state = RenderStateFlags::DepthTest;
+	if (layer != RenderLayer::Transparent) state |= RenderStateFlags::DepthWrite;
+
+	for (const auto& submission : submissions) {
+		RecordSubmission(submission, state);
+	}
+}
+
+void FrameRecorder::RecordSubmission(const RenderSubmission& submission, uint8_t layerState)
+{
+	//check and set face culling
+	uint8_t state = layerState;
+	if (submission.item.cullBackfaces) state |= RenderStateFlags::CullBackfaces;
+
+	commands.SetRenderState(state);
+	commands.SetMaterial(submission.item.materialHandle);
+	commands.BindMesh(submission.item.meshHandle, submission.item.mesh, InstanceLayout::Model);
+	commands.DrawInstanced(submission.item.primitive, submission.instances.count, submission.instances.baseInstance);
+
+	if (submission.impostor) {
+		stats.impostorDraws++;
+		stats.impostorInstances += submission.instances.count;
+	}
+	else {
+		stats.lodDraws[submission.lod]++;
+		stats.lodInstances[submission.lod] += submission.instances.count;
+	}
+}
+
+void FrameRecorder::RecordShadowSubmission(const RenderSubmission& submission)
+{
+	if (submission.instances.count == 0) return; // outside every shadow map layer
+
+	MeshManager::Handle mesh = submission.shadowMeshHandle.IsValid() ? submission.shadowMeshHandle : submission.item.meshHandle;
+	commands.BindMesh(mesh, submission.item.mesh, InstanceLayout::Shadow);
+	commands.DrawInstanced(submission.item.primitive, submission.instances.count, submission.instances.baseInstance);
+
+	stats.shadowLodDraws[submission.shadowLod]++;
+	stats.shadowLodInstances[submission.shadowLod] += submission.instances.count;
+}
+
+void FrameRecorder::RecordGUISubmission(const RenderSubmission& submission, MeshManager::Handle quad)
+{
+	MeshManager::Handle mesh = submission.item.meshHandle.IsValid() ? submission.item.meshHandle : quad;
+
+	commands.SetMaterial(submission.item.materialHandle, submission.item.textureHandle);
+	commands.BindMesh(mesh, nullptr, InstanceLayout::GUI);
+	commands.DrawInstanced(submission.item.primitive, submission.instances.count, submission.instances.baseInstance);
+}
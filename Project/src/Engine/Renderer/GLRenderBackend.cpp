@@ -0,0 +1,92 @@
+#include "Engine/Renderer/GLRenderBackend.h"
+
+#include "Engine/Renderer/GLStateCache.h"
+#include "Engine/Renderer/InstanceStreamBuffer.h"
+
+// =========================================================
+// GLRenderBackend
+// =========================================================
+
+GLRenderBackend::GLRenderBackend(GLStateCache& glState, InstanceStreamBuffer& instanceStream)
+	: glState(glState), instanceStream(instanceStream)
+{
+}
+
+void GLRenderBackend::Execute(const CommandBuffer& commands)
+{
+	auto& _rm = ResourceManager::Get();
+
+	Mesh* mesh = nullptr;
+	bool hasProgram = false;
+
+	for (const RenderCommand& command : commands.GetCommands()) {
+		switch (command.type) {
+		case RenderCommandType::SetRenderState:
+			ApplyRenderState(command.renderState);
+			break;
+
+		case RenderCommandType::BindShader:
+			hasProgram = _rm.shaders.Get(command.resource) != nullptr;
+			if (hasProgram) _rm.shaders.UseShader(command.resource, &glState);
+			break;
+
+		case RenderCommandType::SetMaterial: {
+			Material* material = _rm.materials.Get(command.resource);
+			hasProgram = material != nullptr;
+			if (!material) break;
+
+			//override texture if a textureHandle is provided
+			if (command.texture.IsValid()) {
+				material->SetMainTexture(command.texture);
+			}
+			material->Apply(&glState);
+			break;
+		}
+
+		case RenderCommandType::BindMesh:
+			mesh = command.dynamicMesh ? command.dynamicMesh : _rm.meshes.Get(command.resource);
+			if (!mesh) break;
+
+			if ((command.resource.IsValid() && glState.currentMesh != command.resource) ||
+				(glState.currentDynamicMesh != command.dynamicMesh)) {
+				mesh->Bind();
+				glState.currentMesh = command.resource;
+				glState.currentDynamicMesh = command.dynamicMesh;
+			}
+			mesh->BindInstanceStream(instanceStream, command.layout);
+			break;
+
+		case RenderCommandType::DrawInstanced: {
+			if (!mesh || !hasProgram) break;
+
+			GLenum primitive = command.primitive != 0 ? command.primitive : mesh->primitive;
+			glDrawElementsInstancedBaseInstance(primitive, mesh->indexCount, mesh->indexType, 0,
+				command.instanceCount, command.baseInstance);
+			break;
+		}
+		}
+	}
+
+	// the code drawing outside the command stream expects the default state
+	ApplyRenderState(RenderStateFlags::Default);
+}
+
+void GLRenderBackend::ApplyRenderState(uint8_t state)
+{
+	uint8_t changed = renderState ^ state;
+	if (changed == 0) return;
+	renderState = state;
+
+	if (changed & RenderStateFlags::DepthTest) {
+		if (state & RenderStateFlags::DepthTest) glEnable(GL_DEPTH_TEST);
+		else glDisable(GL_DEPTH_TEST);
+	}
+	if (changed & RenderStateFlags::DepthWrite) {
+		glDepthMask((state & RenderStateFlags::DepthWrite) ? GL_TRUE : GL_FALSE);
+	}
+	if (changed & RenderStateFlags::CullBackfaces) {
+		glState.cullBackfaces = (state & RenderStateFlags::CullBackfaces) != 0;
+		if (glState.cullBackfaces) glEnable(GL_CULL_FACE);
+		else glDisable(GL_CULL_FACE);
+	}
+}
@@ -0,0 +1,47 @@
+#include "Engine/Renderer/InstanceAllocator.h"
+
+#include "Engine/Renderer/Renderable.h"
+
+#include <algorithm>
+
+uint32_t GetInstanceStride(InstanceLayout layout)
+{
+	switch (layout) {
+	case InstanceLayout::GUI:
+		return sizeof(GUIData);
+	case InstanceLayout::Shadow:
+		return sizeof(ShadowInstanceData);
+	case InstanceLayout::Model:
+	default:
+		return sizeof(ModelInstanceData);
+	}
+}
+
+// =========================================================
+// InstanceHeapBuffer
+// =========================================================
+
+void InstanceHeapBuffer::Reserve(size_t bytes)
+{
+	// growing drops the written data and at least doubles the size, same as the stream buffer
+	size_t elements = (bytes + sizeof(glm::vec4) - 1) / sizeof(glm::vec4);
+	if (elements > storage.size()) {
+		storage.assign(std::max(elements, storage.size() * 2), glm::vec4(0.f));
+		usedBytes = 0;
+	}
+}
+
+void* InstanceHeapBuffer::Allocate(InstanceLayout layout, uint32_t count, uint32_t& outBaseInstance)
+{
+	const size_t stride = GetInstanceStride(layout);
+	size_t offset = (usedBytes + stride - 1) / stride * stride;
+
+	size_t end = offset + stride * count;
+	if (end > storage.size() * sizeof(glm::vec4)) {
+		return nullptr;
+	}
+
+	usedBytes = end;
+	outBaseInstance = static_cast<uint32_t>(offset / stride);
+	return reinterpret_cast<uint8_t*>(storage.data()) + offset;
+}
@@ -0,0 +1,128 @@
+#include "Engine/Renderer/InstanceStreamBuffer.h"
+
+#include <iostream>
+#include <algorithm>
+
+// =========================================================
+// InstanceStreamBuffer
+// =========================================================
+
+// shared between all stream buffers, so a mesh can never mistake one buffer for another
+static uint32_t nextGeneration = 1;
+
+InstanceStreamBuffer::InstanceStreamBuffer(size_t regionSize)
+{
+	CreateStorage(regionSize);
+}
+
+InstanceStreamBuffer::~InstanceStreamBuffer()
+{
+	DestroyStorage();
+}
+
+void InstanceStreamBuffer::BeginFrame()
+{
+	currentRegion = (currentRegion + 1) % INSTANCE_STREAM_REGION_COUNT;
+	WaitForRegion(currentRegion);
+	regionOffset = 0;
+}
+
+void InstanceStreamBuffer::EndFrame()
+{
+	if (fences[currentRegion]) {
+		glDeleteSync(fences[currentRegion]);
+	}
+	fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void InstanceStreamBuffer::Reserve(size_t bytes)
+{
+	if (bytes <= regionSize) return;
+
+	// the old storage may still be read by frames in flight
+	for (uint32_t i = 0; i < INSTANCE_STREAM_REGION_COUNT; ++i) {
+		WaitForRegion(i);
+	}
+
+	size_t newSize = std::max(bytes, regionSize * 2);
+	DestroyStorage();
+	CreateStorage(newSize);
+	regionOffset = 0;
+}
+
+void* InstanceStreamBuffer::Allocate(InstanceLayout layout, uint32_t count, uint32_t& outBaseInstance)
+{
+	if (!mapped) return nullptr;
+
+	// base instance counts whole instances from the start of the buffer, so align the absolute offset to the stride
+	size_t stride = GetInstanceStride(layout);
+	size_t regionStart = currentRegion * regionSize;
+	size_t offset = regionStart + regionOffset;
+	offset = (offset + stride - 1) / stride * stride;
+
+	size_t end = offset + stride * count;
+	if (end > regionStart + regionSize) {
+		return nullptr;
+	}
+
+	regionOffset = end - regionStart;
+	outBaseInstance = static_cast<uint32_t>(offset / stride);
+	return mapped + offset;
+}
+
+void InstanceStreamBuffer::CreateStorage(size_t size)
+{
+	regionSize = size;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr totalSize = static_cast<GLsizeiptr>(regionSize * INSTANCE_STREAM_REGION_COUNT);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, totalSize, nullptr, flags);
+	mapped = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!mapped) {
+		std::cerr << "InstanceStreamBuffer: failed to map " << totalSize << " bytes\n";
+	}
+
+	generation = nextGeneration++;
+}
+
+void InstanceStreamBuffer::DestroyStorage()
+{
+	for (auto& fence : fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (buffer != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	mapped = nullptr;
+}
+
+void InstanceStreamBuffer::WaitForRegion(uint32_t region)
+{
+	GLsync& fence = fences[region];
+	if (!fence) return;
+
+	// flush on the first try, so the fence is guaranteed to signal eventually
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, 0, 1000000); // 1ms
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "InstanceStreamBuffer: fence wait failed for region " << region << "\n";
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
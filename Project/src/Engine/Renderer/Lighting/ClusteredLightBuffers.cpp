@@ -0,0 +1,54 @@
+#include "Engine/Renderer/Lighting/ClusteredLightBuffers.h"
+
+#include <cstring>
+
+// =========================================================
+// ClusteredLightBuffers
+// =========================================================
+
+ClusteredLightBuffers::~ClusteredLightBuffers()
+{
+	for (Buffer* buffer : { &lightBuffer, &gridBuffer, &indexBuffer }) {
+		if (buffer->id) glDeleteBuffers(1, &buffer->id);
+	}
+}
+
+void ClusteredLightBuffers::Upload(const std::vector<PointLightData>& lights, const LightClusters& clusters)
+{
+	// every cluster stays empty, which the buffers already say
+	if (uploaded && lights.empty() && !hadLights) return;
+	uploaded = true;
+	hadLights = !lights.empty();
+
+	// empty lists still get a buffer, the shaders index into all three
+	static const uint32_t none[4] = {};
+	const auto& ranges = clusters.GetClusters();
+	const auto& indices = clusters.GetLightIndices();
+
+	const glm::vec4 params = clusters.GetDepthParams();
+	gridStaging.resize(sizeof(glm::vec4) + ranges.size() * sizeof(LightClusterRange));
+	memcpy(gridStaging.data(), &params, sizeof(glm::vec4));
+	if (!ranges.empty()) memcpy(gridStaging.data() + sizeof(glm::vec4), ranges.data(), ranges.size() * sizeof(LightClusterRange));
+
+	Write(lightBuffer, POINT_LIGHT_BINDING, lights.empty() ? static_cast<const void*>(none) : lights.data(),
+		lights.empty() ? sizeof(none) : lights.size() * sizeof(PointLightData));
+	Write(gridBuffer, LIGHT_GRID_BINDING, gridStaging.data(), gridStaging.size());
+	Write(indexBuffer, LIGHT_INDEX_BINDING, indices.empty() ? static_cast<const void*>(none) : indices.data(),
+		indices.empty() ? sizeof(none) : indices.size() * sizeof(uint32_t));
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ClusteredLightBuffers::Write(Buffer& buffer, GLuint binding, const void* data, size_t bytes)
+{
+	if (!buffer.id) glGenBuffers(1, &buffer.id);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+
+	if (bytes > buffer.capacity) {
+		// leaves room for the lights added later on
+		buffer.capacity = bytes * 2;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, buffer.capacity, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer.id);
+	}
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data);
+}
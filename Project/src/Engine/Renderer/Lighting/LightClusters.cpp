@@ -0,0 +1,222 @@
+#include "Engine/Renderer/Lighting/LightClusters.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LIGHT_CLUSTERS_X86 1
+#include <immintrin.h>
+#else
+#define LIGHT_CLUSTERS_X86 0
+#endif
+
+// MSVC allows AVX intrinsics in any function, other compilers need them enabled per function
+#if defined(_MSC_VER)
+#define LIGHT_CLUSTERS_TARGET_AVX
+#else
+#define LIGHT_CLUSTERS_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace
+{
+	constexpr uint32_t SLICE_SIZE = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+
+	// view space sphere of a light, with everything the tests broadcast
+	struct LightSphere
+	{
+		float x, y, z;
+		float radiusSq;
+		uint32_t light;
+	};
+
+	struct ClusterBounds
+	{
+		const float* minX; const float* minY; const float* minZ;
+		const float* maxX; const float* maxY; const float* maxZ;
+	};
+
+	void AddHit(std::vector<uint64_t>& hits, uint32_t cluster, uint32_t light)
+	{
+		hits.push_back((uint64_t(cluster) << 32) | light);
+	}
+
+	// a sphere touches a box if the closest point of the box is within its radius
+	void TestScalar(const ClusterBounds& b, const LightSphere& s, uint32_t begin, uint32_t end, std::vector<uint64_t>& hits)
+	{
+		for (uint32_t i = begin; i < end; ++i) {
+			float dx = std::max(std::max(b.minX[i] - s.x, s.x - b.maxX[i]), 0.f);
+			float dy = std::max(std::max(b.minY[i] - s.y, s.y - b.maxY[i]), 0.f);
+			float dz = std::max(std::max(b.minZ[i] - s.z, s.z - b.maxZ[i]), 0.f);
+			if (dx * dx + dy * dy + dz * dz <= s.radiusSq) AddHit(hits, i, s.light);
+		}
+	}
+
+#if LIGHT_CLUSTERS_X86
+	uint32_t TestSSE(const ClusterBounds& b, const LightSphere& s, uint32_t begin, uint32_t end, std::vector<uint64_t>& hits)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 sx = _mm_set1_ps(s.x), sy = _mm_set1_ps(s.y), sz = _mm_set1_ps(s.z);
+		const __m128 radiusSq = _mm_set1_ps(s.radiusSq);
+
+		uint32_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(b.minX + i), sx), _mm_sub_ps(sx, _mm_loadu_ps(b.maxX + i))), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(b.minY + i), sy), _mm_sub_ps(sy, _mm_loadu_ps(b.maxY + i))), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(b.minZ + i), sz), _mm_sub_ps(sz, _mm_loadu_ps(b.maxZ + i))), zero);
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distSq, radiusSq)));
+			for (; mask; mask &= mask - 1) {
+				AddHit(hits, i + uint32_t(std::countr_zero(mask)), s.light);
+			}
+		}
+		return i;
+	}
+
+	LIGHT_CLUSTERS_TARGET_AVX uint32_t TestAVX(const ClusterBounds& b, const LightSphere& s, uint32_t begin, uint32_t end, std::vector<uint64_t>& hits)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 sx = _mm256_set1_ps(s.x), sy = _mm256_set1_ps(s.y), sz = _mm256_set1_ps(s.z);
+		const __m256 radiusSq = _mm256_set1_ps(s.radiusSq);
+
+		uint32_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			__m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(b.minX + i), sx), _mm256_sub_ps(sx, _mm256_loadu_ps(b.maxX + i))), zero);
+			__m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(b.minY + i), sy), _mm256_sub_ps(sy, _mm256_loadu_ps(b.maxY + i))), zero);
+			__m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(b.minZ + i), sz), _mm256_sub_ps(sz, _mm256_loadu_ps(b.maxZ + i))), zero);
+			__m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(distSq, radiusSq, _CMP_LE_OQ)));
+			for (; mask; mask &= mask - 1) {
+				AddHit(hits, i + uint32_t(std::countr_zero(mask)), s.light);
+			}
+		}
+		return i;
+	}
+#endif
+}
+
+// =========================================================
+// LightClusters
+// =========================================================
+
+void LightClusters::SetProjection(const glm::mat4& newProjection)
+{
+	if (newProjection == projection && !minX.empty()) return;
+	projection = newProjection;
+
+	minX.assign(LIGHT_CLUSTER_COUNT, 0.f); minY.assign(LIGHT_CLUSTER_COUNT, 0.f); minZ.assign(LIGHT_CLUSTER_COUNT, 0.f);
+	maxX.assign(LIGHT_CLUSTER_COUNT, 0.f); maxY.assign(LIGHT_CLUSTER_COUNT, 0.f); maxZ.assign(LIGHT_CLUSTER_COUNT, 0.f);
+
+	// only perspective projections have froxels, anything else leaves every cluster empty
+	if (projection[2][3] != -1.f || projection[0][0] == 0.f || projection[1][1] == 0.f) {
+		nearPlane = farPlane = 0.f;
+		return;
+	}
+	nearPlane = projection[3][2] / (projection[2][2] - 1.f);
+	farPlane = projection[3][2] / (projection[2][2] + 1.f);
+	if (!(nearPlane > 0.f) || !(farPlane > nearPlane)) {
+		nearPlane = farPlane = 0.f;
+		return;
+	}
+
+	const float logRatio = std::log(farPlane / nearPlane);
+	sliceScale = float(LIGHT_CLUSTERS_Z) / logRatio;
+	sliceBias = -float(LIGHT_CLUSTERS_Z) * std::log(nearPlane) / logRatio;
+
+	// a point at normalized device xy and view depth d sits at d * (ndc + offset) / scale in view space
+	auto viewOffset = [&](float ndc, int axis, float depth) {
+		return depth * (ndc + projection[2][axis]) / projection[axis][axis];
+		};
+
+	for (uint32_t z = 0; z < LIGHT_CLUSTERS_Z; ++z) {
+		float depth0 = nearPlane * std::pow(farPlane / nearPlane, float(z) / LIGHT_CLUSTERS_Z);
+		float depth1 = nearPlane * std::pow(farPlane / nearPlane, float(z + 1) / LIGHT_CLUSTERS_Z);
+		for (uint32_t y = 0; y < LIGHT_CLUSTERS_Y; ++y) {
+			float ndcY0 = -1.f + 2.f * float(y) / LIGHT_CLUSTERS_Y;
+			float ndcY1 = -1.f + 2.f * float(y + 1) / LIGHT_CLUSTERS_Y;
+			for (uint32_t x = 0; x < LIGHT_CLUSTERS_X; ++x) {
+				float ndcX0 = -1.f + 2.f * float(x) / LIGHT_CLUSTERS_X;
+				float ndcX1 = -1.f + 2.f * float(x + 1) / LIGHT_CLUSTERS_X;
+
+				// the froxel widens with depth, so its box spans the corners of both ends
+				uint32_t i = GetClusterIndex(x, y, z);
+				minX[i] = std::min({ viewOffset(ndcX0, 0, depth0), viewOffset(ndcX0, 0, depth1) });
+				maxX[i] = std::max({ viewOffset(ndcX1, 0, depth0), viewOffset(ndcX1, 0, depth1) });
+				minY[i] = std::min({ viewOffset(ndcY0, 1, depth0), viewOffset(ndcY0, 1, depth1) });
+				maxY[i] = std::max({ viewOffset(ndcY1, 1, depth0), viewOffset(ndcY1, 1, depth1) });
+				// the camera looks down -z
+				minZ[i] = -depth1;
+				maxZ[i] = -depth0;
+			}
+		}
+	}
+}
+
+int LightClusters::GetSlice(float viewDepth) const
+{
+	if (viewDepth < nearPlane) return -1;
+	if (viewDepth >= farPlane) return LIGHT_CLUSTERS_Z;
+	int slice = int(std::floor(std::log(viewDepth) * sliceScale + sliceBias));
+	return std::clamp(slice, 0, LIGHT_CLUSTERS_Z - 1);
+}
+
+void LightClusters::Bin(const glm::mat4& view, const std::vector<PointLightData>& lights)
+{
+	Bin(view, lights, GetDefaultCullingPath());
+}
+
+void LightClusters::Bin(const glm::mat4& view, const std::vector<PointLightData>& lights, CullingPath path)
+{
+	clusters.assign(LIGHT_CLUSTER_COUNT, LightClusterRange{});
+	lightIndices.clear();
+	hits.clear();
+	if (farPlane <= 0.f) return;
+
+	const ClusterBounds bounds{ minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+
+	for (uint32_t light = 0; light < lights.size(); ++light) {
+		const float radius = lights[light].GetRadius();
+		if (radius <= 0.f) continue;
+
+		glm::vec3 center = glm::vec3(view * glm::vec4(lights[light].GetPosition(), 1.f));
+		float depth = -center.z;
+		if (depth + radius < nearPlane || depth - radius >= farPlane) continue;
+
+		// only the slices the sphere spans in depth can hold it
+		int firstSlice = std::max(GetSlice(depth - radius), 0);
+		int lastSlice = std::min(GetSlice(depth + radius), LIGHT_CLUSTERS_Z - 1);
+
+		LightSphere sphere{ center.x, center.y, center.z, radius * radius, light };
+		uint32_t begin = uint32_t(firstSlice) * SLICE_SIZE;
+		uint32_t end = uint32_t(lastSlice + 1) * SLICE_SIZE;
+
+		uint32_t done = begin;
+#if LIGHT_CLUSTERS_X86
+		if (path == CullingPath::AVX) {
+			done = TestAVX(bounds, sphere, begin, end, hits);
+		}
+		else if (path == CullingPath::SSE) {
+			done = TestSSE(bounds, sphere, begin, end, hits);
+		}
+#endif
+		TestScalar(bounds, sphere, done, end, hits);
+	}
+
+	// counting sort by cluster, every cluster keeps its lights in light order
+	for (uint64_t hit : hits) {
+		clusters[uint32_t(hit >> 32)].count++;
+	}
+	uint32_t offset = 0;
+	for (LightClusterRange& cluster : clusters) {
+		cluster.offset = offset;
+		offset += cluster.count;
+		cluster.count = 0;
+	}
+	lightIndices.resize(offset);
+	for (uint64_t hit : hits) {
+		LightClusterRange& cluster = clusters[uint32_t(hit >> 32)];
+		lightIndices[cluster.offset + cluster.count++] = uint32_t(hit & 0xFFFFFFFFu);
+	}
+}
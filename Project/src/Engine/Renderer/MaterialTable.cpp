@@ -0,0 +1,30 @@
+#include "Engine/Renderer/MaterialTable.h"
+
+// =========================================================
+// MaterialTable
+// =========================================================
+
+MaterialTable::~MaterialTable()
+{
+	if (buffer) glDeleteBuffers(1, &buffer);
+}
+
+void MaterialTable::Update(const MaterialManager& materials)
+{
+	if (!materials.CopyParamsIfChanged(version, staging)) return;
+	if (staging.empty()) return;
+
+	if (!buffer) glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+	const size_t bytes = staging.size() * sizeof(MaterialParams);
+	if (staging.size() > capacity) {
+		// leaves room for the materials loaded later on
+		capacity = staging.size() * 2;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(MaterialParams), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_BINDING, buffer);
+	}
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, staging.data());
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
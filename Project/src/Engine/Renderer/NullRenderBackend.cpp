@@ -0,0 +1,52 @@
+#include "Engine/Renderer/NullRenderBackend.h"
+
+// =========================================================
+// NullRenderBackend
+// =========================================================
+
+void NullRenderBackend::Execute(const CommandBuffer& commands)
+{
+	for (const RenderCommand& command : commands.GetCommands()) {
+		stats.commands++;
+
+		// fields are hashed one by one, the padding between them is not deterministic
+		Hash(static_cast<uint64_t>(command.type));
+		switch (command.type) {
+		case RenderCommandType::SetRenderState:
+			stats.renderStateChanges++;
+			Hash(command.renderState);
+			break;
+		case RenderCommandType::BindShader:
+			stats.shaderBinds++;
+			Hash(command.resource.id);
+			break;
+		case RenderCommandType::SetMaterial:
+			stats.materialBinds++;
+			Hash(command.resource.id);
+			Hash(command.texture.id);
+			break;
+		case RenderCommandType::BindMesh:
+			stats.meshBinds++;
+			// dynamic meshes have no stable identity across runs, only their presence is hashed
+			Hash(command.resource.id);
+			Hash(command.dynamicMesh != nullptr);
+			Hash(static_cast<uint64_t>(command.layout));
+			break;
+		case RenderCommandType::DrawInstanced:
+			stats.draws++;
+			stats.instances += command.instanceCount;
+			Hash(command.primitive);
+			Hash(command.instanceCount);
+			Hash(command.baseInstance);
+			break;
+		}
+	}
+}
+
+void NullRenderBackend::Hash(uint64_t value)
+{
+	for (int i = 0; i < 8; ++i) {
+		stats.hash ^= (value >> (i * 8)) & 0xff;
+		stats.hash *= 0x100000001b3ull;
+	}
+}
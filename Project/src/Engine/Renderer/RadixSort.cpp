@@ -0,0 +1,63 @@
+#include "Engine/Renderer/RadixSort.h"
+
+#include <array>
+#include <utility>
+
+// digits 0..3 are the order bytes, 4..11 the sortKey bytes, least significant first
+static constexpr int ORDER_DIGITS = 4;
+static constexpr int KEY_DIGITS = 8;
+static constexpr int DIGIT_COUNT = ORDER_DIGITS + KEY_DIGITS;
+
+static inline uint32_t GetDigit(const SortEntry& e, int digit)
+{
+	if (digit < ORDER_DIGITS) return (e.order >> (digit * 8)) & 0xFF;
+	return static_cast<uint32_t>(e.sortKey >> ((digit - ORDER_DIGITS) * 8)) & 0xFF;
+}
+
+void RadixSort(SortList& entries, SortList& scratch, SortPriority priority)
+{
+	const size_t count = entries.size();
+	if (count < 2) return;
+
+	// histogram every digit at once
+	std::array<std::array<uint32_t, 256>, DIGIT_COUNT> histograms{};
+	for (const auto& e : entries) {
+		for (int d = 0; d < DIGIT_COUNT; ++d) {
+			histograms[d][GetDigit(e, d)]++;
+		}
+	}
+
+	// least significant digit first
+	std::array<int, DIGIT_COUNT> passes;
+	for (int i = 0; i < DIGIT_COUNT; ++i) {
+		if (priority == SortPriority::KeyThenOrder) passes[i] = i;
+		else passes[i] = (i + ORDER_DIGITS) % DIGIT_COUNT; // key digits first, then order digits
+	}
+
+	scratch.resize(count);
+	SortList* src = &entries;
+	SortList* dst = &scratch;
+
+	for (int digit : passes) {
+		auto& histogram = histograms[digit];
+
+		// every entry has the same digit, the pass would not change anything
+		if (histogram[GetDigit((*src)[0], digit)] == count) continue;
+
+		uint32_t offsets[256];
+		uint32_t sum = 0;
+		for (int b = 0; b < 256; ++b) {
+			offsets[b] = sum;
+			sum += histogram[b];
+		}
+
+		for (const auto& e : *src) {
+			(*dst)[offsets[GetDigit(e, digit)]++] = e;
+		}
+		std::swap(src, dst);
+	}
+
+	if (src != &entries) {
+		entries.swap(scratch);
+	}
+}
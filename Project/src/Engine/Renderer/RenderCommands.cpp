@@ -0,0 +1,84 @@
+#include "Engine/Renderer/RenderCommands.h"
+
+// =========================================================
+// CommandBuffer
+// =========================================================
+
+void CommandBuffer::Reset()
+{
+	commands.clear();
+
+	hasRenderState = false;
+	renderState = 0;
+	shader = {};
+	material = {};
+	texture = {};
+	mesh = {};
+	dynamicMesh = nullptr;
+	layout = InstanceLayout::Model;
+	hasMesh = false;
+}
+
+void CommandBuffer::SetRenderState(uint8_t state)
+{
+	if (hasRenderState && renderState == state) return;
+	hasRenderState = true;
+	renderState = state;
+
+	RenderCommand& command = commands.emplace_back();
+	command.type = RenderCommandType::SetRenderState;
+	command.renderState = state;
+}
+
+void CommandBuffer::BindShader(ShaderManager::Handle shader)
+{
+	if (this->shader.IsValid() && this->shader == shader) return;
+	this->shader = shader;
+	// the shader replaces the material's
+	material = {};
+	texture = {};
+
+	RenderCommand& command = commands.emplace_back();
+	command.type = RenderCommandType::BindShader;
+	command.resource = shader;
+}
+
+void CommandBuffer::SetMaterial(MaterialManager::Handle material, TextureManager::Handle texture)
+{
+	if (this->material.IsValid() && this->material == material && this->texture == texture) return;
+	this->material = material;
+	this->texture = texture;
+	// the material binds its own shader
+	shader = {};
+
+	RenderCommand& command = commands.emplace_back();
+	command.type = RenderCommandType::SetMaterial;
+	command.resource = material;
+	command.texture = texture;
+}
+
+void CommandBuffer::BindMesh(MeshManager::Handle mesh, Mesh* dynamicMesh, InstanceLayout layout)
+{
+	if (hasMesh && this->mesh == mesh && this->dynamicMesh == dynamicMesh && this->layout == layout) return;
+	hasMesh = true;
+	this->mesh = mesh;
+	this->dynamicMesh = dynamicMesh;
+	this->layout = layout;
+
+	RenderCommand& command = commands.emplace_back();
+	command.type = RenderCommandType::BindMesh;
+	command.resource = mesh;
+	command.dynamicMesh = dynamicMesh;
+	command.layout = layout;
+}
+
+void CommandBuffer::DrawInstanced(GLenum primitive, uint32_t instanceCount, uint32_t baseInstance)
+{
+	if (instanceCount == 0) return;
+
+	RenderCommand& command = commands.emplace_back();
+	command.type = RenderCommandType::DrawInstanced;
+	command.primitive = primitive;
+	command.instanceCount = instanceCount;
+	command.baseInstance = baseInstance;
+}
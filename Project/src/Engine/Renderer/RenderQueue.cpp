@@ -1,107 +1,412 @@
 #include "Engine/Renderer/RenderQueue.h"
 
+#include "Engine/DataStructures/TransformFunctions.h"
+#include "Engine/Profiling/Profiler.h"
+
 #include <algorithm>
+#include <bit>
+#include <atomic>
 
 // =================================================
 // RenderQueue
 // =================================================
 
-RenderQueue::RenderQueue()
+RenderQueue::RenderQueue(FrameArena& arena, WorkerPool& workers) :
+	workers(workers),
+	opaque(&arena),
+	transparent(&arena),
+	gui(&arena),
+	opaqueOrder(&arena),
+	transparentOrder(&arena),
+	guiOrder(&arena),
+	opaqueScratch(&arena),
+	transparentScratch(&arena),
+	guiScratch(&arena),
+	worldVisibility(&arena),
+	worldChunks(&arena)
 {
-	particleShaderHandle = ResourceManager::Get().shaders.GetHandle("particle");
 }
 
 void RenderQueue::Clear()
 {
-	opaque.clear();
-	transparent.clear();
-	gui.clear();
-	shadowCasters.clear();
+	lastOpaqueSize = ReleaseArenaStorage(opaque);
+	lastTransparentSize = ReleaseArenaStorage(transparent);
+	lastGUISize = ReleaseArenaStorage(gui);
+	ReleaseArenaStorage(opaqueOrder);
+	ReleaseArenaStorage(transparentOrder);
+	ReleaseArenaStorage(guiOrder);
+	ReleaseArenaStorage(opaqueScratch);
+	ReleaseArenaStorage(transparentScratch);
+	ReleaseArenaStorage(guiScratch);
+	lastVisibilityWords = ReleaseArenaStorage(worldVisibility);
+	ReleaseArenaStorage(worldChunks);
 	nextSubmitIndex = 1;
 }
 
+void RenderQueue::Reserve()
+{
+	opaque.reserve(lastOpaqueSize);
+	transparent.reserve(lastTransparentSize);
+	gui.reserve(lastGUISize);
+	opaqueOrder.reserve(lastOpaqueSize);
+	transparentOrder.reserve(lastTransparentSize);
+	guiOrder.reserve(lastGUISize);
+	opaqueScratch.reserve(lastOpaqueSize);
+	transparentScratch.reserve(lastTransparentSize);
+	guiScratch.reserve(lastGUISize);
+	worldVisibility.reserve(lastVisibilityWords);
+	worldChunks.reserve(workers.GetChunkCount(lastVisibilityWords, 1));
+}
+
 void RenderQueue::Push(const Renderable& renderable)
 {
+	// Check if renderable is within the view frustum if it has bounds
+	bool visible = true;
+	BoundingBox worldBounds;
+	if (renderable.hasBounds) {
+		worldBounds = ComputeCullingBounds(renderable);
+		visible = AABBInFrustum(viewFrustum, worldBounds);
+	}
 
-	RenderSubmission submission;
-	submission.item = renderable;
-	submission.sortKey = renderable.GetSortKey();
+	Enqueue(renderable, renderable.GetSortKey(), visible, worldBounds);
+}
 
-	if(submission.item.castShadows) {
-		shadowCasters.push_back(submission);
+void RenderQueue::Push(const std::vector<Renderable>& renderables)
+{
+	for (const auto& renderable : renderables) {
+		Push(renderable);
 	}
+}
 
-	// Check if renderable is within the view frustum if it has bounds
-	if (renderable.hasBounds) {
-		//get transformed AABB
-		glm::mat4 modelMatrix = renderable.modelMatrix;
-
-		if(renderable.materialHandle == particleShaderHandle) {
-			//particles are always facing the camera, so we skip rotation for AABB culling
-
-			float sx = glm::length(glm::vec3(modelMatrix[0]));  
-			float sy = glm::length(glm:: vec3(modelMatrix[1]));  
-			float sz = glm::length(glm::vec3(modelMatrix[2]));
-			modelMatrix[0] = glm::vec4(sx, 0.0f, 0.0f, 0.0f);
-			modelMatrix[1] = glm::vec4(0.0f, sy, 0.0f, 0.0f);
-			modelMatrix[2] = glm::vec4(0.0f, 0.0f, sz, 0.0f);
+void RenderQueue::Push(const RenderWorld& world, const OcclusionBuffer* occlusion)
+{
+	PROFILE_SCOPE("RenderQueue::Push");
+	const auto& proxies = world.GetProxies();
+	const auto& bounds = world.GetCullingBounds();
+	if (proxies.empty()) return;
+
+	// chunks are whole visibility words, so no two threads write the same word
+	const size_t words = (proxies.size() + 31) / 32;
+	worldVisibility.assign(words, 0u);
+	worldChunks.assign(workers.GetChunkCount(words, 1), ChunkCounts{});
+
+	// first pass: cull each chunk and count what it adds to every list
+	workers.ParallelFor(words, 1, [&](size_t beginWord, size_t endWord, size_t chunk) {
+		size_t begin = beginWord * 32;
+		size_t end = std::min(endWord * 32, proxies.size());
+		CullBoundsRange(viewFrustum, bounds, begin, end, worldVisibility.data());
+
+		// occlusion only runs on what survived the frustum, the buffer is read only by now
+		if (occlusion && occlusion->HasOccluders()) {
+			for (size_t i = begin; i < end; ++i) {
+				const RenderProxy& proxy = proxies[i];
+				if (!proxy.renderable.hasBounds || proxy.renderable.layer == RenderLayer::GUI) continue;
+				if (!IsVisible(worldVisibility, i)) continue;
+				if (!occlusion->IsVisible(proxy.worldBounds)) {
+					worldVisibility[i >> 5] &= ~(1u << (i & 31));
+				}
+			}
+		}
+
+		ChunkCounts& counts = worldChunks[chunk];
+		for (size_t i = begin; i < end; ++i) {
+			const Renderable& renderable = proxies[i].renderable;
+			Routing routing = Route(renderable, IsVisible(worldVisibility, i));
+			if (routing.opaquePassMask != 0) counts.opaque++;
+			if (routing.toLayer) {
+				if (renderable.layer == RenderLayer::Transparent) counts.transparent++;
+				else if (renderable.layer == RenderLayer::GUI) counts.gui++;
+			}
 		}
+		});
+
+	// turn the counts into each chunk's write offsets, in chunk order so the result matches a serial push
+	size_t opaqueOffset = opaque.size();
+	size_t transparentOffset = transparent.size();
+	size_t guiOffset = gui.size();
+	for (auto& counts : worldChunks) {
+		ChunkCounts offsets{ uint32_t(opaqueOffset), uint32_t(transparentOffset), uint32_t(guiOffset) };
+		opaqueOffset += counts.opaque;
+		transparentOffset += counts.transparent;
+		guiOffset += counts.gui;
+		counts = offsets;
+	}
+	opaque.resize(opaqueOffset);
+	transparent.resize(transparentOffset);
+	gui.resize(guiOffset);
+
+	// a proxy only ever touches its own entry, so the chunks can update them in parallel
+	const auto& proxyIds = world.GetProxyIds();
+	if (proxyLods.size() < world.GetIdCapacity()) proxyLods.resize(world.GetIdCapacity(), 0);
 
-		BoundingBox transformedAABB = TransformAABB(renderable.aabb, modelMatrix);
+	// second pass: every chunk writes its submissions into its own slots
+	workers.ParallelFor(words, 1, [&](size_t beginWord, size_t endWord, size_t chunk) {
+		size_t begin = beginWord * 32;
+		size_t end = std::min(endWord * 32, proxies.size());
 
-		if (!AABBInFrustum(viewFrustum, transformedAABB)) {
-			// Cull the renderable
-			return;
+		ChunkCounts& cursor = worldChunks[chunk];
+		for (size_t i = begin; i < end; ++i) {
+			const RenderProxy& proxy = proxies[i];
+			Routing routing = Route(proxy.renderable, IsVisible(worldVisibility, i));
+
+			if (routing.opaquePassMask != 0) {
+				RenderSubmission& submission = opaque[cursor.opaque++];
+				submission.item = proxy.renderable;
+				submission.sortKey = proxy.sortKey;
+				submission.passMask = routing.opaquePassMask;
+				submission.staticShadow = !proxy.dynamic;
+				submission.worldBounds = proxy.worldBounds;
+				SelectLod(submission, &proxyLods[proxyIds[i]]);
+			}
+			if (routing.toLayer) {
+				RenderSubmission* submission = nullptr;
+				if (proxy.renderable.layer == RenderLayer::Transparent) submission = &transparent[cursor.transparent++];
+				else if (proxy.renderable.layer == RenderLayer::GUI) submission = &gui[cursor.gui++];
+				if (submission) {
+					submission->item = proxy.renderable;
+					submission->sortKey = proxy.sortKey;
+					submission->passMask = RenderPassMask::Main;
+					submission->worldBounds = proxy.worldBounds;
+					SelectLod(*submission, &proxyLods[proxyIds[i]]);
+				}
+			}
 		}
+		});
+}
+
+RenderQueue::Routing RenderQueue::Route(const Renderable& renderable, bool visible)
+{
+	Routing routing;
+	if (renderable.layer == RenderLayer::Opaque) {
+		// opaque shadow casters are kept in the opaque list even when culled,
+		// so the shadow and main pass can draw from the same instances
+		if (visible) routing.opaquePassMask |= RenderPassMask::Main;
+		if (renderable.castShadows) routing.opaquePassMask |= RenderPassMask::Shadow;
+		return routing;
+	}
+
+	// other layers are drawn separately in the main pass, so their shadow goes through the opaque list on its own
+	if (renderable.castShadows) routing.opaquePassMask = RenderPassMask::Shadow;
+	routing.toLayer = visible;
+	return routing;
+}
+
+void RenderQueue::Enqueue(const Renderable& renderable, uint64_t sortKey, bool visible, const BoundingBox& worldBounds)
+{
+	Routing routing = Route(renderable, visible);
+
+	RenderSubmission submission;
+	submission.item = renderable;
+	submission.sortKey = sortKey;
+	submission.worldBounds = worldBounds;
+	SelectLod(submission, nullptr);
+
+	if (routing.opaquePassMask != 0) {
+		submission.passMask = routing.opaquePassMask;
+		opaque.push_back(submission);
 	}
 
+	if (!routing.toLayer) {
+		return;
+	}
+
+	submission.passMask = RenderPassMask::Main;
 	switch (renderable.layer) {
-		case RenderLayer::Opaque:
-			opaque.push_back(std::move(submission));
-			break;
 		case RenderLayer::Transparent:
 			transparent.push_back(std::move(submission));
 			break;
 		case RenderLayer::GUI:
 			gui.push_back(std::move(submission));
 			break;
+		default:
+			break;
 	}
 }
 
-void RenderQueue::Push(const std::vector<Renderable>& renderables)
+void RenderQueue::SelectLod(RenderSubmission& submission, uint8_t* previous) const
 {
-	for (const auto& renderable : renderables) {
-		Push(renderable);
+	Renderable& item = submission.item;
+	if (item.mesh || !item.hasBounds || item.layer == RenderLayer::GUI) return;
+
+	const MeshManager& meshes = ResourceManager::Get().meshes;
+	const MeshLodChain* chain = meshes.GetLodChain(item.meshHandle);
+	// alpha tested, so only opaque meshes switch to their impostor
+	const MeshImpostor* impostor = item.layer == RenderLayer::Opaque ? meshes.GetImpostor(item.meshHandle) : nullptr;
+	if (!chain && !impostor) return;
+
+	// share of the screen height covered by the bounding sphere
+	glm::vec3 center = (submission.worldBounds.min + submission.worldBounds.max) * 0.5f;
+	float radius = glm::length(submission.worldBounds.max - submission.worldBounds.min) * 0.5f;
+	float distance = glm::length(center - lodViewPos);
+	float screenSize = distance > radius ? radius * lodProjectionScale / distance : 1.f;
+
+	MeshManager::Handle mesh = item.meshHandle;
+	if (chain) {
+		uint8_t level = chain->Select(screenSize, previous ? *previous : 0);
+		if (previous) *previous = level;
+
+		submission.lod = level;
+		submission.shadowLod = uint8_t(std::min<uint32_t>(level + MESH_LOD_SHADOW_BIAS, chain->count - 1u));
+		submission.shadowMeshHandle = chain->levels[submission.shadowLod];
+		if (level != 0) {
+			item.meshHandle = chain->levels[level];
+			submission.sortKey = ReplaceSortKeyMesh(submission.sortKey, item.meshHandle);
+		}
+	}
+
+	// Every impostor of a mesh has the same sort key, so they draw as one batch.
+	// Their shadow is the coarsest level, which keeps it the same within that batch
+	if (impostor && distance > impostor->distance) {
+		submission.impostor = true;
+		submission.shadowLod = chain ? uint8_t(chain->count - 1) : 0;
+		submission.shadowMeshHandle = chain ? chain->levels[submission.shadowLod] : mesh;
+		item.meshHandle = impostor->quad;
+		item.materialHandle = impostor->material;
+		item.cullBackfaces = false;
+		submission.sortKey = item.GetSortKey();
 	}
 }
 
-std::vector<RenderSubmission>& RenderQueue::GetSortedLayer(RenderLayer layer)
+const RenderList& RenderQueue::GetLayer(RenderLayer layer) const
 {
-	std::vector<RenderSubmission>* target = nullptr;
+	switch (layer) {
+	case RenderLayer::Transparent:
+		return transparent;
+	case RenderLayer::GUI:
+		return gui;
+	case RenderLayer::Opaque:
+	default:
+		return opaque;
+	}
+}
+
+RenderList& RenderQueue::GetList(RenderLayer layer)
+{
+	return const_cast<RenderList&>(static_cast<const RenderQueue*>(this)->GetLayer(layer));
+}
 
+const SortList& RenderQueue::GetOrder(RenderLayer layer) const
+{
 	switch (layer) {
+	case RenderLayer::Transparent:
+		return transparentOrder;
+	case RenderLayer::GUI:
+		return guiOrder;
 	case RenderLayer::Opaque:
-		target = &opaque;
-		break;
+	default:
+		return opaqueOrder;
+	}
+}
+
+SortList& RenderQueue::GetOrderList(RenderLayer layer)
+{
+	return const_cast<SortList&>(static_cast<const RenderQueue*>(this)->GetOrder(layer));
+}
+
+SortList& RenderQueue::GetScratch(RenderLayer layer)
+{
+	switch (layer) {
 	case RenderLayer::Transparent:
-		target = &transparent;
-		break;
+		return transparentScratch;
 	case RenderLayer::GUI:
-		target = &gui;
-		break;
+		return guiScratch;
+	case RenderLayer::Opaque:
+	default:
+		return opaqueScratch;
+	}
+}
+
+void RenderQueue::PrepareOrder(RenderLayer layer)
+{
+	size_t size = GetLayer(layer).size();
+	GetOrderList(layer).resize(size);
+	GetScratch(layer).resize(size);
+}
+
+SortList& RenderQueue::BuildOrder(RenderLayer layer)
+{
+	const RenderList& list = GetLayer(layer);
+	SortList& order = GetOrderList(layer);
+
+	for (size_t i = 0; i < list.size(); ++i) {
+		order[i].sortKey = list[i].sortKey;
+		order[i].index = static_cast<uint32_t>(i);
 	}
+	return order;
+}
 
-	std::sort(target->begin(), target->end());
-	return *target;
+ShadowCasterCounts RenderQueue::CullShadowCasters(const Frustum* layerFrusta, uint32_t layerCount, uint8_t staticLayers, uint8_t dynamicLayers)
+{
+	std::atomic<uint32_t> staticCount{ 0 };
+	std::atomic<uint32_t> dynamicCount{ 0 };
+
+	workers.ParallelFor(opaque.size(), RENDER_QUEUE_SHADOW_CULL_CHUNK, [&](size_t begin, size_t end, size_t) {
+		uint32_t chunkStatic = 0;
+		uint32_t chunkDynamic = 0;
+		for (size_t i = begin; i < end; ++i) {
+			RenderSubmission& submission = opaque[i];
+			submission.shadowLayers = 0;
+			if (!(submission.passMask & RenderPassMask::Shadow)) continue;
+
+			const uint8_t layers = submission.staticShadow ? staticLayers : dynamicLayers;
+			uint32_t& count = submission.staticShadow ? chunkStatic : chunkDynamic;
+			for (uint32_t layer = 0; layer < layerCount; ++layer) {
+				if (!(layers & (1u << layer))) continue;
+				if (!submission.item.hasBounds || AABBInFrustum(layerFrusta[layer], submission.worldBounds)) {
+					submission.shadowLayers |= uint8_t(1u << layer);
+					count++;
+				}
+			}
+		}
+		staticCount.fetch_add(chunkStatic, std::memory_order_relaxed);
+		dynamicCount.fetch_add(chunkDynamic, std::memory_order_relaxed);
+		});
+
+	return ShadowCasterCounts{ staticCount.load(), dynamicCount.load() };
 }
 
-std::vector<RenderSubmission>& RenderQueue::GetShadowCasters()
+void RenderQueue::Sort(const glm::vec3& viewPos)
 {
-	std::sort(shadowCasters.begin(), shadowCasters.end());
-	return shadowCasters;
+	PROFILE_SCOPE("RenderQueue::Sort");
+	PrepareOrder(RenderLayer::Opaque);
+	PrepareOrder(RenderLayer::Transparent);
+	PrepareOrder(RenderLayer::GUI);
+
+	// the layers share nothing once their lists are sized
+	workers.Run(
+		[this]() { SortLayer(RenderLayer::Opaque); },
+		[this, &viewPos]() { SortLayerBackToFront(RenderLayer::Transparent, viewPos); },
+		[this]() { SortLayer(RenderLayer::GUI); }
+		);
+}
+
+void RenderQueue::SortLayer(RenderLayer layer)
+{
+	SortList& order = BuildOrder(layer);
+	for (auto& entry : order) {
+		entry.order = 0; // the sort is stable, so submissions of a key stay in push order
+	}
+
+	RadixSort(order, GetScratch(layer), SortPriority::KeyThenOrder);
+}
+
+void RenderQueue::SortLayerBackToFront(RenderLayer layer, const glm::vec3& viewPos)
+{
+	RenderList& list = GetList(layer);
+	SortList& order = BuildOrder(layer);
+	for (auto& entry : order) {
+		auto& item = list[entry.index].item;
+		glm::vec3 objPos = TransformFunctions::DecomposePosition(item.modelMatrix);
+		item.sortDistance = glm::length(viewPos - objPos);
+
+		// non-negative floats sort like their bit patterns, inverted for back to front
+		entry.order = ~std::bit_cast<uint32_t>(item.sortDistance);
+	}
+
+	RadixSort(order, GetScratch(layer), SortPriority::OrderThenKey);
 }
 
 size_t RenderQueue::TotalSize() const
 {
 	return opaque.size() + transparent.size() + gui.size();
-}
\ No newline at end of file
+}
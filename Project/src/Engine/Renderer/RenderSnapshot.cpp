@@ -0,0 +1,52 @@
+#include "Engine/Renderer/RenderSnapshot.h"
+
+// =========================================================
+// RenderSnapshotQueue
+// =========================================================
+
+RenderSnapshot* RenderSnapshotQueue::BeginWrite()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	// the render thread may still be reading the oldest snapshot
+	condition.wait(lock, [this]() { return closed || !published[writeIndex]; });
+	if (closed) return nullptr;
+	return &snapshots[writeIndex];
+}
+
+void RenderSnapshotQueue::EndWrite()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		published[writeIndex] = true;
+		writeIndex = (writeIndex + 1) % RENDER_SNAPSHOT_COUNT;
+	}
+	condition.notify_all();
+}
+
+const RenderSnapshot* RenderSnapshotQueue::BeginRead()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this]() { return closed || published[readIndex]; });
+	// frames published before closing are dropped, nobody waits for them anymore
+	if (closed) return nullptr;
+	return &snapshots[readIndex];
+}
+
+void RenderSnapshotQueue::EndRead()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		published[readIndex] = false;
+		readIndex = (readIndex + 1) % RENDER_SNAPSHOT_COUNT;
+	}
+	condition.notify_all();
+}
+
+void RenderSnapshotQueue::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+	}
+	condition.notify_all();
+}
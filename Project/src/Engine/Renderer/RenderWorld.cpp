@@ -0,0 +1,214 @@
+#include "Engine/Renderer/RenderWorld.h"
+
+#include <cassert>
+
+// =========================================================
+// RenderWorldChanges
+// =========================================================
+
+void RenderWorldChanges::Append(const RenderWorldChanges& other)
+{
+	const uint32_t renderableBase = static_cast<uint32_t>(renderables.size());
+	const uint32_t matrixBase = static_cast<uint32_t>(matrices.size());
+	for (Change change : other.changes) {
+		if (change.type == Type::Add || change.type == Type::Update) change.payload += renderableBase;
+		else if (change.type == Type::UpdateTransform) change.payload += matrixBase;
+		changes.push_back(change);
+	}
+	renderables.insert(renderables.end(), other.renderables.begin(), other.renderables.end());
+	matrices.insert(matrices.end(), other.matrices.begin(), other.matrices.end());
+}
+
+void RenderWorldChanges::Clear()
+{
+	changes.clear();
+	renderables.clear();
+	matrices.clear();
+}
+
+// =========================================================
+// RenderWorld
+// =========================================================
+
+RenderWorld::ProxyHandle RenderWorld::Add(const Renderable& renderable)
+{
+	if (slots.empty()) {
+		slots.emplace_back(); // keep id 0 invalid
+	}
+
+	uint32_t id;
+	if (!freeIds.empty()) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+		id = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+
+	Slot& slot = slots[id];
+	slot.denseIndex = static_cast<uint32_t>(proxies.size());
+	slot.generation++;
+	slot.alive = true;
+
+	RenderProxy& proxy = proxies.emplace_back();
+	proxy.renderable = renderable;
+	proxy.sortKey = renderable.GetSortKey();
+	proxy.lastChangeFrame = frameIndex;
+	denseToId.push_back(id);
+
+	cullingBounds.Resize(proxies.size());
+	RefreshBounds(slot.denseIndex);
+
+	ProxyHandle handle{ id, slot.generation };
+	if (recordChanges) {
+		changes.changes.push_back({ RenderWorldChanges::Type::Add, handle, static_cast<uint32_t>(changes.renderables.size()) });
+		changes.renderables.push_back(renderable);
+	}
+	return handle;
+}
+
+void RenderWorld::Remove(ProxyHandle handle)
+{
+	if (!IsValid(handle)) return;
+	if (recordChanges) changes.changes.push_back({ RenderWorldChanges::Type::Remove, handle });
+
+	Slot& slot = slots[handle.id];
+	uint32_t index = slot.denseIndex;
+	const RenderProxy& removed = proxies[index];
+	if (!removed.dynamic && removed.renderable.castShadows) staticCasterVersion++;
+
+	uint32_t last = static_cast<uint32_t>(proxies.size() - 1);
+
+	// swap the last proxy into the hole to keep the storage dense
+	if (index != last) {
+		proxies[index] = std::move(proxies[last]);
+		denseToId[index] = denseToId[last];
+		slots[denseToId[index]].denseIndex = index;
+	}
+	cullingBounds.SwapRemove(index);
+	proxies.pop_back();
+	denseToId.pop_back();
+
+	slot.alive = false;
+	freeIds.push_back(handle.id);
+}
+
+void RenderWorld::UpdateTransform(ProxyHandle handle, const glm::mat4& modelMatrix)
+{
+	if (!IsValid(handle)) return;
+	uint32_t index = slots[handle.id].denseIndex;
+	if (recordChanges) {
+		changes.changes.push_back({ RenderWorldChanges::Type::UpdateTransform, handle, static_cast<uint32_t>(changes.matrices.size()) });
+		changes.matrices.push_back(modelMatrix);
+	}
+
+	RenderProxy& proxy = proxies[index];
+	Touch(proxy, proxy.renderable.castShadows);
+	proxy.renderable.modelMatrix = modelMatrix;
+	RefreshBounds(index);
+}
+
+void RenderWorld::Update(ProxyHandle handle, const Renderable& renderable)
+{
+	if (!IsValid(handle)) return;
+	uint32_t index = slots[handle.id].denseIndex;
+	if (recordChanges) {
+		changes.changes.push_back({ RenderWorldChanges::Type::Update, handle, static_cast<uint32_t>(changes.renderables.size()) });
+		changes.renderables.push_back(renderable);
+	}
+
+	RenderProxy& proxy = proxies[index];
+	Touch(proxy, proxy.renderable.castShadows || renderable.castShadows);
+	// the key only depends on a few fields, most property changes keep it
+	if (!proxy.renderable.HasSameSortKeyInputs(renderable)) {
+		proxy.sortKey = renderable.GetSortKey();
+	}
+	proxy.renderable = renderable;
+	RefreshBounds(index);
+}
+
+const RenderProxy* RenderWorld::Get(ProxyHandle handle) const
+{
+	if (!IsValid(handle)) return nullptr;
+	return &proxies[slots[handle.id].denseIndex];
+}
+
+bool RenderWorld::IsValid(ProxyHandle handle) const
+{
+	if (handle.id == 0 || handle.id >= slots.size()) return false;
+	const Slot& slot = slots[handle.id];
+	return slot.alive && slot.generation == handle.generation;
+}
+
+void RenderWorld::Clear()
+{
+	if (recordChanges) changes.changes.push_back({ RenderWorldChanges::Type::Clear, ProxyHandle{} });
+	for (uint32_t id : denseToId) {
+		slots[id].alive = false;
+		freeIds.push_back(id);
+	}
+	proxies.clear();
+	denseToId.clear();
+	cullingBounds.Clear();
+	staticCasterVersion++;
+}
+
+void RenderWorld::AdvanceFrame()
+{
+	if (recordChanges) changes.changes.push_back({ RenderWorldChanges::Type::AdvanceFrame, ProxyHandle{} });
+	frameIndex++;
+	for (RenderProxy& proxy : proxies) {
+		if (!proxy.dynamic || frameIndex - proxy.lastChangeFrame < RENDER_WORLD_STATIC_FRAMES) continue;
+		proxy.dynamic = false;
+		if (proxy.renderable.castShadows) staticCasterVersion++;
+	}
+}
+
+void RenderWorld::Apply(const RenderWorldChanges& log)
+{
+	for (const auto& change : log.changes) {
+		switch (change.type) {
+		case RenderWorldChanges::Type::Add: {
+			[[maybe_unused]] ProxyHandle handle = Add(log.renderables[change.payload]);
+			assert(handle.id == change.handle.id && handle.generation == change.handle.generation && "RenderWorld::Apply: worlds diverged");
+			break;
+		}
+		case RenderWorldChanges::Type::Remove:
+			Remove(change.handle);
+			break;
+		case RenderWorldChanges::Type::UpdateTransform:
+			UpdateTransform(change.handle, log.matrices[change.payload]);
+			break;
+		case RenderWorldChanges::Type::Update:
+			Update(change.handle, log.renderables[change.payload]);
+			break;
+		case RenderWorldChanges::Type::Clear:
+			Clear();
+			break;
+		case RenderWorldChanges::Type::AdvanceFrame:
+			AdvanceFrame();
+			break;
+		}
+	}
+}
+
+void RenderWorld::Touch(RenderProxy& proxy, bool castShadows)
+{
+	proxy.lastChangeFrame = frameIndex;
+	if (proxy.dynamic) return;
+	proxy.dynamic = true;
+	if (castShadows) staticCasterVersion++;
+}
+
+void RenderWorld::RefreshBounds(uint32_t denseIndex)
+{
+	RenderProxy& proxy = proxies[denseIndex];
+	if (proxy.renderable.hasBounds) {
+		proxy.worldBounds = ComputeCullingBounds(proxy.renderable);
+		cullingBounds.Set(denseIndex, proxy.worldBounds);
+	}
+	else {
+		cullingBounds.SetUnbounded(denseIndex);
+	}
+}
@@ -1,6 +1,9 @@
 #include "Engine/Renderer/Renderable.h"
 #include "Engine/Resources/ResourceManager.h"
 
+#include <iostream>
+#include <atomic>
+
 // ==================================================
 // Renderable
 // ==================================================
@@ -13,99 +16,144 @@ Renderable::~Renderable()
 		mp.Destroy(*mesh);
 		delete mesh;
 	}
-	if (instanceData)
-	{
-		delete instanceData;
-	}
 }
 
 Renderable::Renderable(const Renderable& other) noexcept :
 	meshHandle(other.meshHandle),
 	materialHandle(other.materialHandle),
 	mesh(other.mesh),
+	modelMatrix(other.modelMatrix),
 	primitive(other.primitive),
 	aabb(other.aabb),
 	hasBounds(other.hasBounds),
+	billboard(other.billboard),
+	cullBackfaces(other.cullBackfaces),
 	castShadows(other.castShadows),
 	receiveShadows(other.receiveShadows),
-	cullBackfaces(other.cullBackfaces),
-	instanceData(other.instanceData),
+	occluder(other.occluder),
 	layer(other.layer),
 	zOrder(other.zOrder),
 	textureHandle(other.textureHandle),
-	uvRect(other.uvRect),
-	modelMatrix(other.modelMatrix)
+	uvRect(other.uvRect)
 {
-	// Note: shallow copy of mesh and instanceData pointers
+	// Note: shallow copy of mesh pointer
 }
 
 Renderable::Renderable(Renderable&& other) noexcept :
 	meshHandle(other.meshHandle),
 	materialHandle(other.materialHandle),
 	mesh(other.mesh),
+	modelMatrix(other.modelMatrix),
 	primitive(other.primitive),
 	aabb(other.aabb),
 	hasBounds(other.hasBounds),
+	billboard(other.billboard),
+	cullBackfaces(other.cullBackfaces),
 	castShadows(other.castShadows),
 	receiveShadows(other.receiveShadows),
-	cullBackfaces(other.cullBackfaces),
-	instanceData(other.instanceData),
+	occluder(other.occluder),
 	layer(other.layer),
 	zOrder(other.zOrder),
 	textureHandle(other.textureHandle),
-	uvRect(other.uvRect),
-	modelMatrix(other.modelMatrix)
+	uvRect(other.uvRect)
 {
 	other.mesh = nullptr;
-	other.instanceData = nullptr;
 }
 
-uint64_t Renderable::GetSortKey() const
+enum class SortKeyField : uint8_t
 {
-	auto& _rm = ResourceManager::Get();
-	uint32_t materialId = materialHandle.id & 0xFFFF;
-	auto shader = _rm.materials.Get(materialHandle)->GetShader();
-	uint32_t shaderId = shader.id & 0xFFFF;
+	Shader,
+	Material,
+	Mesh,
+	Texture,
+	Count
+};
 
-	uint32_t meshId = 0;
-	if (mesh) {
-		meshId = reinterpret_cast<uintptr_t>(mesh) & 0xFFFFFF;
-	}
-	else {
-		meshId = meshHandle.id & 0xFFFFFF;
+static const char* const SORT_KEY_FIELD_NAMES[] = { "shader", "material", "mesh", "texture" };
+// one flag per field, so an overflow of one field does not hide the others. Keys are built on worker threads
+static std::atomic<bool> sortKeyFieldWarned[size_t(SortKeyField::Count)];
+
+// warns once per field if a dense id does not fit, which would make unrelated items share a key
+static uint64_t PackKeyField(uint32_t value, uint32_t bits, SortKeyField field)
+{
+	const uint32_t mask = (1u << bits) - 1;
+	if (value > mask && !sortKeyFieldWarned[size_t(field)].exchange(true, std::memory_order_relaxed)) {
+		std::cerr << "Renderable::GetSortKey: " << SORT_KEY_FIELD_NAMES[size_t(field)] << " id " << value << " does not fit in " << bits << " bits\n";
 	}
+	return uint64_t(value & mask);
+}
+
+uint64_t Renderable::GetSortKey() const
+{
+	// dense ids are plain array lookups, and stay small enough to pack without truncating
+	auto& _rm = ResourceManager::Get();
+	// materials that only differ in their material table constants share a group, and so a batch
+	uint32_t materialId = _rm.materials.GetBatchGroup(materialHandle);
+	uint32_t shaderId = _rm.shaders.GetDenseId(_rm.materials.GetMaterialShader(materialHandle));
 
 	uint32_t flags = 0;
 	flags |= cullBackfaces;
 
 	uint64_t key = 0;
 	if (layer != RenderLayer::GUI) {
-		key |= (uint64_t(shaderId) << 48);
-		key |= (uint64_t(materialId) << 32);
-		key |= (uint64_t(meshId) << 8);
-		key |= uint64_t(flags);
+		// meshes outside the manager use their own ids, the top bit keeps them apart from managed ones
+		const uint32_t dynamicMeshBit = 1u << (SORT_KEY_MESH_BITS - 1);
+		uint64_t meshField = mesh
+			? (dynamicMeshBit | PackKeyField(mesh->sortId, SORT_KEY_MESH_BITS - 1, SortKeyField::Mesh))
+			: PackKeyField(_rm.meshes.GetDenseId(meshHandle), SORT_KEY_MESH_BITS - 1, SortKeyField::Mesh);
+
+		key |= PackKeyField(shaderId, SORT_KEY_SHADER_BITS, SortKeyField::Shader) << 52;
+		key |= PackKeyField(materialId, SORT_KEY_MATERIAL_BITS, SortKeyField::Material) << 32;
+		key |= meshField << 4;
+		key |= uint64_t(flags & 0xF);
 	}
 	else {
 
 		uint64_t zNormalized = static_cast<uint16_t>(zOrder) ^ 0x8000u;
 
-		uint32_t textureId = textureHandle.id;
+		uint32_t textureId = _rm.textures.GetDenseId(textureHandle);
 
 		key |= (zNormalized << 48);
-		key |= (uint64_t(shaderId & 0xFFFF) << 32);
-		key |= (uint64_t(materialId & 0xFFFF) << 16);
-		key |= (uint64_t(textureId & 0x0FFF) << 4);
-		key |= (uint64_t(flags & 0xF));
+		key |= PackKeyField(shaderId, SORT_KEY_SHADER_BITS, SortKeyField::Shader) << 36;
+		key |= PackKeyField(materialId, SORT_KEY_GUI_MATERIAL_BITS, SortKeyField::Material) << 20;
+		key |= PackKeyField(textureId, SORT_KEY_TEXTURE_BITS, SortKeyField::Texture) << 4;
+		key |= uint64_t(flags & 0xF);
 		// all GUI share the same mesh (a quad)
 	}
 	return key;
 }
 
-// ==================================================
-// RenderSubmission
-// ==================================================
+uint64_t ReplaceSortKeyMesh(uint64_t sortKey, MeshManager::Handle mesh)
+{
+	// see GetSortKey, managed meshes leave the top bit of the field clear
+	const uint64_t meshMask = ((uint64_t(1) << SORT_KEY_MESH_BITS) - 1) << 4;
+	uint64_t meshField = PackKeyField(ResourceManager::Get().meshes.GetDenseId(mesh), SORT_KEY_MESH_BITS - 1, SortKeyField::Mesh);
+	return (sortKey & ~meshMask) | (meshField << 4);
+}
+
+bool Renderable::HasSameSortKeyInputs(const Renderable& other) const
+{
+	return meshHandle == other.meshHandle &&
+		materialHandle == other.materialHandle &&
+		mesh == other.mesh &&
+		layer == other.layer &&
+		cullBackfaces == other.cullBackfaces &&
+		zOrder == other.zOrder &&
+		textureHandle == other.textureHandle;
+}
 
-std::strong_ordering RenderSubmission::operator<=>(const RenderSubmission& other) const noexcept
+BoundingBox ComputeCullingBounds(const Renderable& renderable)
 {
-	return sortKey <=> other.sortKey;
+	glm::mat4 modelMatrix = renderable.modelMatrix;
+
+	if (renderable.billboard) {
+		float sx = glm::length(glm::vec3(modelMatrix[0]));
+		float sy = glm::length(glm::vec3(modelMatrix[1]));
+		float sz = glm::length(glm::vec3(modelMatrix[2]));
+		modelMatrix[0] = glm::vec4(sx, 0.0f, 0.0f, 0.0f);
+		modelMatrix[1] = glm::vec4(0.0f, sy, 0.0f, 0.0f);
+		modelMatrix[2] = glm::vec4(0.0f, 0.0f, sz, 0.0f);
+	}
+
+	return TransformAABB(renderable.aabb, modelMatrix);
 }
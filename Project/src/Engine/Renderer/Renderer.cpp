@@ -8,11 +8,10 @@
 #include "Engine/Resources/UboDefs.h"
 #include "Engine/Renderer/LightMath.h"
 
-#include "Engine/Renderer/RenderableProvider/MeshRenderableProvider.h"
-#include "Engine/Renderer/BatchBuilder.h"
 #include "Engine/Renderer/Culling/Frustum.h"
 
 #include "Engine/DataStructures/TransformFunctions.h"
+#include "Engine/Profiling/Profiler.h"
 
 // temporary camera controller until entity system is done to fetch cameraController from camera entity
 #include "Engine/Controllers/FlyingCameraController.h"
@@ -30,13 +29,28 @@ Renderer::Renderer(App& app) : app(app), _rm(ResourceManager::Get())
 
 	glClearColor(DEFAULT_CLEAR_COLOR_R, DEFAULT_CLEAR_COLOR_G, DEFAULT_CLEAR_COLOR_B, 1.0f);
 
+	// the snapshots replay the changes of the world instead of copying it
+	renderWorld.SetRecordChanges(true);
+
 	auto& _im = InputManager::Get();
 
 	_im.BindKey(GLFW_KEY_B, InputEventType::Pressed, [this]() {
-		this->showBoundingBoxes = !this->showBoundingBoxes;
+		this->debugDraw.SetEnabled(!this->debugDraw.IsEnabled());
+		});
+	_im.BindKey(GLFW_KEY_O, InputEventType::Pressed, [this]() {
+		this->occlusionCulling = !this->occlusionCulling;
+		std::cout << "Occlusion culling " << (this->occlusionCulling ? "on" : "off") << "\n";
+		});
+	_im.BindKey(GLFW_KEY_L, InputEventType::Pressed, [this]() {
+		this->PrintStats();
 		});
 
 	LightMath::GetCascadeSplits(nearPlane, farPlane, 6, 1, cascadeSplits);
+
+#if SHADOW_VERTEX_LAYER
+	vertexShadowLayers = ShadowFramebuffer::SupportsVertexLayer();
+#endif
+	std::cout << "Shadow casters are routed to their layer in the " << (vertexShadowLayers ? "vertex" : "geometry") << " shader\n";
 }
 
 Renderer::~Renderer()
@@ -47,22 +61,103 @@ void Renderer::UpdateLighting(LightingUBO* light)
 {
 	if(light)
 		renderLight = light;
-	auto& _rm = ResourceManager::Get();
-	auto* lightingWriter = _rm.ubos.GetUboWriter("Lighting");
-	lightingWriter->SetBlock(*renderLight);
-	lightingWriter->Upload();
+	// uploaded by the render thread with the next frame
+	lightingDirty = true;
+}
+
+void Renderer::PublishFrame()
+{
+	PROFILE_SCOPE("PublishFrame");
+	AllocationScope allocationScope(publishAllocations);
+
+	// bounding boxes of the world as it is published
+	if (debugDraw.IsEnabled())
+	{
+		for (const auto& proxy : renderWorld.GetProxies())
+		{
+			if (proxy.renderable.hasBounds)
+				debugDraw.AddBox(proxy.worldBounds);
+		}
+	}
+
+	RenderSnapshot* snapshot = snapshots.BeginWrite();
+	if (!snapshot) return;
+
+	// proxies that stopped moving join the cached static shadow casters
+	renderWorld.AdvanceFrame();
+
+	// every slot holds the world as it was published last into it, only the changes since then are replayed
+	const RenderWorldChanges& changes = renderWorld.GetChanges();
+	for (auto& pending : pendingWorldChanges) {
+		pending.Append(changes);
+	}
+	renderWorld.ClearChanges();
+
+	RenderWorldChanges& pending = pendingWorldChanges[snapshots.GetWriteIndex()];
+	snapshot->world.Apply(pending);
+	pending.Clear();
+
+	auto& win = AppAttorney::GetWindow(App::Get());
+	snapshot->camera.position = renderCamera->GetPosition();
+	snapshot->camera.view = renderCamera->GetViewMatrix();
+	snapshot->camera.projection = renderCamera->GetProjectionMatrix();
+	snapshot->camera.aspectRatio = win.GetAspectRatio();
+
+	snapshot->lighting = renderLight ? *renderLight : LightingUBO{};
+	snapshot->lightingChanged = lightingDirty;
+	lightingDirty = false;
+
+	snapshot->occlusionCulling = occlusionCulling;
+
+	snapshot->submissions.swap(pendingSubmissions);
+	pendingSubmissions.clear();
+	snapshot->pointLights.swap(pendingPointLights);
+	pendingPointLights.clear();
+	debugDraw.Publish(snapshot->debugLines);
+
+	snapshots.EndWrite();
 }
 
-void Renderer::Render()
+bool Renderer::Render()
 {
+	frame = snapshots.BeginRead();
+	if (!frame) return false;
+
+	// waiting for the snapshot is left out, the scope is counted in the frame after the one it closes
+	PROFILE_SCOPE("Render");
+	AllocationScope allocationScope(renderAllocations);
+#if ENGINE_PROFILING
+	gpuProfiler.BeginFrame();
+#endif
+	instanceStream.BeginFrame();
+	materialTable.Update(_rm.materials);
+	frameRecorder.ResetStats();
 
 	Clear();
 
+	if (frame->lightingChanged)
+		UploadLighting();
 	UpdateCameraUBOs();
+	BinLights();
+	ExtractRenderWorld();
 
 	RenderFrame();
-	ClearQueue();
+	frameRecorder.GetStats().heapAllocations = static_cast<uint32_t>(publishAllocations.Take() + renderAllocations.Take());
+	// publishes the stats, every list built from the snapshot is released with the frame arena
+	frameRecorder.EndFrame();
+
+	instanceStream.EndFrame();
 	//glFlush();
+	PROFILE_END_FRAME();
+
+	frame = nullptr;
+	snapshots.EndRead();
+	return true;
+}
+
+void Renderer::ClosePipeline()
+{
+	snapshots.Close();
 }
 
 void Renderer::Clear() const
@@ -71,30 +166,91 @@ void Renderer::Clear() const
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void Renderer::UploadLighting()
+{
+	auto* lightingWriter = _rm.ubos.GetUboWriter(GlobalUbo::Lighting);
+	lightingWriter->SetBlock(frame->lighting);
+	lightingWriter->Upload();
+}
+
 void Renderer::UpdateCameraUBOs() {
-	auto& win = AppAttorney::GetWindow(App::Get());
 	// update Camera ubo
 	glm::mat4 projection = GetPerspectiveMatrix();
 	glm::mat4 view = GetViewMatrix();
-	auto* cameraWriter = _rm.ubos.GetUboWriter("Camera");
+	auto* cameraWriter = _rm.ubos.GetUboWriter(GlobalUbo::Camera);
 	cameraWriter->SetBlock(CameraUBO{
-		renderCamera->GetPosition(),
+		frame->camera.position,
 		view,
 		projection
 		});
 	cameraWriter->Upload();
 	glm::mat4 guiView = GetGUIViewMatrix();
-	auto* guiCameraWriter = _rm.ubos.GetUboWriter("GUICamera");
+	auto* guiCameraWriter = _rm.ubos.GetUboWriter(GlobalUbo::GUICamera);
 	guiCameraWriter->SetBlock(GUICameraUBO{
 		guiView
 		});
 	guiCameraWriter->Upload();
 
-	Frustum frustrum(projection * view);
-	renderQueue.SetViewFrustum(frustrum);
+	projectionView = projection * view;
+	Frustum frustrum(projectionView);
+	RenderQueue& queue = frameRecorder.GetQueue();
+	queue.SetViewFrustum(frustrum);
+	queue.SetLodView(frame->camera.position, projection[1][1]);
+}
+
+void Renderer::ExtractRenderWorld()
+{
+	PROFILE_SCOPE("ExtractRenderWorld");
+	// needs the frustum of this frame, so it runs after UpdateCameraUBOs
+	RenderQueue& queue = frameRecorder.GetQueue();
+	if (frame->occlusionCulling) {
+		BuildOcclusionBuffer();
+		queue.Push(frame->world, &occlusionBuffer);
+	}
+	else {
+		queue.Push(frame->world);
+	}
+
+	queue.Push(frame->submissions);
+}
+
+void Renderer::BinLights()
+{
+	PROFILE_SCOPE("BinLights");
+	lightClusters.SetProjection(GetPerspectiveMatrix());
+	lightClusters.Bin(GetViewMatrix(), frame->pointLights);
+	lightBuffers.Upload(frame->pointLights, lightClusters);
+
+	RendererStats& stats = frameRecorder.GetStats();
+	stats.pointLights = static_cast<uint32_t>(frame->pointLights.size());
+	stats.clusteredLightIndices = static_cast<uint32_t>(lightClusters.GetLightIndices().size());
+}
+
+void Renderer::BuildOcclusionBuffer()
+{
+	PROFILE_SCOPE("BuildOcclusionBuffer");
+	occlusionBuffer.Begin(projectionView);
+
+	Frustum frustum(projectionView);
+	for (const auto& proxy : frame->world.GetProxies())
+	{
+		const Renderable& r = proxy.renderable;
+		// only opaque geometry hides what is behind it
+		if (!r.occluder || r.layer != RenderLayer::Opaque || !r.hasBounds) continue;
+		if (!AABBInFrustum(frustum, proxy.worldBounds)) continue;
+
+		const Mesh* mesh = r.mesh ? r.mesh : _rm.meshes.Get(r.meshHandle);
+		if (mesh)
+			occlusionBuffer.RasterizeMesh(*mesh, r.modelMatrix);
+	}
+
+	occlusionBuffer.Finish();
 }
 
 void Renderer::RenderFrame() {
+	UpdateShadowMatrices();
+	// dynamic casters go into every layer drawn this frame, static ones only into the layers whose cache is redrawn
+	frameRecorder.BuildBatches(frame->camera.position, shadowFrusta, SHADOW_LAYER_COUNT, shadowCacheLayers, shadowDrawLayers, instanceStream);
 	DrawShadowPass();
 	DrawMainPass();
 }
@@ -104,302 +260,180 @@ void Renderer::RenderFrame() {
 // =================================================
 void Renderer::Submit(const Renderable& r)
 {
-	renderQueue.Push(r);
+	pendingSubmissions.push_back(r);
 
-	if(showBoundingBoxes && r.hasBounds)
-	{
-		MeshRenderableProvider meshProvider;
-		meshProvider.meshHandle = _rm.meshes.GetHandle("primitive/bounding_box");
-		meshProvider.materialHandle = _rm.materials.GetHandle("boundingBox");
-		glm::mat4 modelMatrix = r.modelMatrix;
-		BoundingBox transformedAABB = TransformAABB(r.aabb, modelMatrix);
-
-		Transform t;
-		t.position = (transformedAABB.min + transformedAABB.max) * 0.5f;
-		t.scale = transformedAABB.max - transformedAABB.min;
-		meshProvider.modelMatrix = t.GetModelMatrix();
-
-		std::vector<Renderable> boxRenders;
-		meshProvider.GenerateRenderables(boxRenders);
-		renderQueue.Push(boxRenders);
-	}
+	if (debugDraw.IsEnabled() && r.hasBounds)
+		debugDraw.AddBox(ComputeCullingBounds(r));
 }
 
 void Renderer::Submit(const std::vector<Renderable>& rs)
 {
-	renderQueue.Push(rs);
+	pendingSubmissions.insert(pendingSubmissions.end(), rs.begin(), rs.end());
 
-	if(showBoundingBoxes)
+	if (debugDraw.IsEnabled())
 	{
-		std::vector<Renderable> boxRenders;
-		MeshRenderableProvider meshProvider;
-		meshProvider.meshHandle = _rm.meshes.GetHandle("primitive/bounding_box");
-		meshProvider.materialHandle = _rm.materials.GetHandle("boundingBox");
 		for (const auto& r : rs)
 		{
-			if(!r.hasBounds) continue;
-			glm::mat4 modelMatrix = r.modelMatrix;
-			BoundingBox transformedAABB = TransformAABB(r.aabb, modelMatrix);
-
-			Transform t;
-			t.position = (transformedAABB.min + transformedAABB.max) * 0.5f;
-			t.scale = transformedAABB.max - transformedAABB.min;
-			meshProvider.modelMatrix = t.GetModelMatrix();
-
-			meshProvider.GenerateRenderables(boxRenders);
+			if (r.hasBounds)
+				debugDraw.AddBox(ComputeCullingBounds(r));
 		}
-		renderQueue.Push(boxRenders);
 	}
 }
 
+void Renderer::Submit(const PointLightData& light)
+{
+	pendingPointLights.push_back(light);
+}
+
 // 
 // Draw passes
 // =================================================
 
-void Renderer::DrawShadowPass()
+void Renderer::UpdateShadowMatrices()
 {
-	auto batchedShadowCasters = BatchBuilder::Build(renderQueue.GetShadowCasters());
-	ShadowUBO shadowData;
-	shadowData.lightPos = renderLight->lightPos;
-	shadowData.cascadedSplits[0] = LightMath::ComputePointLightFarPlane(glm::vec3(renderLight->attenuationFactor));
-	std::string shaderName;
-	bool isPointLight = false;
-	if (shadowData.lightPos.w) // point light
+	shadowData = ShadowUBO{};
+	const LightingUBO& light = frame->lighting;
+	shadowData.lightPos = light.lightPos;
+	shadowData.cascadedSplits[0] = LightMath::ComputePointLightFarPlane(glm::vec3(light.attenuationFactor));
+	pointShadows = shadowData.lightPos.w != 0;
+	if (pointShadows)
 	{
-		isPointLight = true;
 		LightMath::ComputePointLightMatrices(
 			glm::vec3(shadowData.lightPos),
 			0.1f,
 			shadowData.cascadedSplits[0],
 			shadowData.lightSpaceMatrix
 		);
-		auto* shadowWriter = _rm.ubos.GetUboWriter("Shadow");
-		shadowWriter->SetBlock(shadowData);
-		shadowWriter->Upload();
-
-		pointShadowFBO.BindForWriting();
-		shaderName = "pointShadow";
 	}
 	else // directional light
 	{
-		glm::vec3 lightDir = LightMath::GetLightDirection(*renderLight);
-		auto& win = AppAttorney::GetWindow(App::Get());
+		glm::vec3 lightDir = LightMath::GetLightDirection(light);
 
 		LightMath::ComputeDirectionalLightCascades(
 			lightDir,
 			GetViewMatrix(),
 			90.0f,
-			win.GetAspectRatio(),
+			frame->camera.aspectRatio,
 			nearPlane,
 			farPlane,
-			6,
+			SHADOW_LAYER_COUNT,
 			cascadeSplits,
+			SHADOW_MAP_SIZE,
 			shadowData.lightSpaceMatrix
 		);
-		memcpy(shadowData.cascadedSplits, cascadeSplits, sizeof(fixed_float) * 6);
-		auto* shadowWriter = _rm.ubos.GetUboWriter("Shadow");
-		shadowWriter->SetBlock(shadowData);
-		shadowWriter->Upload();
-
-		dirShadowFBO.BindForWriting();
-		shaderName = "dirShadow";
-	}
-	_rm.shaders.UseShader(shaderName, &glState);
-
-	for (auto& submission : batchedShadowCasters)
-	{
-		DrawShadowSubmission(submission);
+		memcpy(shadowData.cascadedSplits, cascadeSplits, sizeof(fixed_float) * SHADOW_LAYER_COUNT);
 	}
 
+	ScheduleShadowLayers();
 
-	ShadowFramebuffer::Unbind(glState);
-	auto& win = AppAttorney::GetWindow(App::Get());
-	win.ResetViewport();
-}
+	auto* shadowWriter = _rm.ubos.GetUboWriter(GlobalUbo::Shadow);
+	shadowWriter->SetBlock(shadowData);
+	shadowWriter->Upload();
 
-void Renderer::DrawMainPass()
-{
-	auto transparentList = renderQueue.GetSortedLayer(RenderLayer::Transparent);
-	//update sortDistance for transparent items
-	for(auto& renderable : transparentList)
+	// cascades and cube faces are both plain view-projections, so their frusta come out of the same plane extraction
+	for (int layer = 0; layer < SHADOW_LAYER_COUNT; ++layer)
 	{
-		glm::vec3 camPos = renderCamera->GetPosition();
-		glm::vec3 objPos = TransformFunctions::DecomposePosition(renderable.item.modelMatrix);
-		renderable.item.sortDistance = glm::length(camPos - objPos);
+		shadowFrusta[layer] = Frustum(shadowData.lightSpaceMatrix[layer]);
 	}
-	//sort back to front using renderable::sortDistance
-	std::stable_sort(transparentList.begin(), transparentList.end(),
-		[](const RenderSubmission& a, const RenderSubmission& b) {
-			return a.item.sortDistance > b.item.sortDistance;
-		});
-
-
-	auto batchedOpaque = BatchBuilder::Build(renderQueue.GetSortedLayer(RenderLayer::Opaque));
-	auto batchedTransparent = BatchBuilder::Build(transparentList);
-	auto batchedGUI = BatchBuilder::Build(renderQueue.GetSortedLayer(RenderLayer::GUI));
-
-	DrawList(batchedOpaque);
-	DrawList(batchedTransparent);
-	DrawList(batchedGUI);
 }
 
-// =================================================
-// Draw functions
-// =================================================
-
-void Renderer::DrawList(const std::vector<RenderSubmission>& submissions)
+void Renderer::ScheduleShadowLayers()
 {
-	// all submissions should share the same layer
-	RenderLayer layer = submissions.empty() ? RenderLayer::Opaque : submissions[0].item.layer;
-
-	if (layer == RenderLayer::GUI) {
-		glDisable(GL_DEPTH_TEST);
-		glDepthMask(GL_FALSE);
-		glDisable(GL_CULL_FACE);
-
-		for (const auto& submission : submissions) {
-			DrawGUISubmission(submission);
-		}
-
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(GL_TRUE);
-		glEnable(GL_CULL_FACE);
-	}
-	else {
-
-		if (layer == RenderLayer::Transparent)
-		{
-			glDepthMask(GL_FALSE);
-		}
-
-		for (const auto& submission : submissions) {
-			DrawSubmission(submission);
-		}
-
-		if (layer == RenderLayer::Transparent)
+	// a new light invalidates every layer
+	const bool lightChanged = pointShadows != shadowLayersPointLight || shadowData.lightPos != shadowLayersLightPos;
+	shadowLayersPointLight = pointShadows;
+	shadowLayersLightPos = shadowData.lightPos;
+	shadowFrame++;
+
+	const uint64_t staticCasterVersion = frame->world.GetStaticCasterVersion();
+	shadowDrawLayers = 0;
+	shadowCacheLayers = 0;
+	for (int layer = 0; layer < SHADOW_LAYER_COUNT; ++layer)
+	{
+		ShadowLayerState& state = shadowLayers[layer];
+		// cube faces and near cascades follow every frame, the further cascades take turns
+		bool due = lightChanged || !state.drawn || pointShadows || layer < SHADOW_NEAR_CASCADES ||
+			(shadowFrame + layer) % SHADOW_FAR_CASCADE_INTERVAL == 0;
+		if (!due)
 		{
-			glDepthMask(GL_TRUE);
+			// sampled with the light space it was drawn with
+			shadowData.lightSpaceMatrix[layer] = state.lightSpace;
+			continue;
 		}
-	}
-}
-
-void Renderer::DrawSubmission(const RenderSubmission& submission)
-{
-	Mesh* mesh = nullptr;
-	if(submission.item.mesh)
-		mesh = submission.item.mesh;
-	else 
-		mesh = _rm.meshes.Get(submission.item.meshHandle);
-	if (!mesh) return;
-	auto* material = _rm.materials.Get(submission.item.materialHandle);
-	if (!material) return;
-
-	//check and set face culling
-	if(glState.cullBackfaces != submission.item.cullBackfaces)
-	{
-		glState.cullBackfaces = submission.item.cullBackfaces;
-		if(glState.cullBackfaces)
-			glEnable(GL_CULL_FACE);
-		else
-			glDisable(GL_CULL_FACE);
-	}
 
-	material->Apply(&glState);
+		shadowDrawLayers |= uint8_t(1u << layer);
+		if (lightChanged || !state.drawn || state.lightSpace != shadowData.lightSpaceMatrix[layer] || state.staticCasterVersion != staticCasterVersion)
+			shadowCacheLayers |= uint8_t(1u << layer);
 
-	if ((submission.item.meshHandle.IsValid() && glState.currentMesh != submission.item.meshHandle) ||
-		(glState.currentDynamicMesh != submission.item.mesh)) {
-			mesh->Bind();
-			glState.currentMesh = submission.item.meshHandle;
-			glState.currentDynamicMesh = submission.item.mesh;
+		state.lightSpace = shadowData.lightSpaceMatrix[layer];
+		state.staticCasterVersion = staticCasterVersion;
+		state.drawn = true;
 	}
 
-	GLenum primitive = submission.item.primitive != 0 ? submission.item.primitive : mesh->primitive;
-	if (submission.item.instanceData)
+	for (int layer = 0; layer < SHADOW_LAYER_COUNT; ++layer)
 	{
-		if(mesh->isInstancingEnabled() == false)
-		{
-			mesh->EnableInstancing(true);
-		}
-		mesh->UploadInstancedData(dynamic_cast<InstanceData*>(submission.item.instanceData)->modelMatrices.data(), submission.item.instanceData->count);
-		glDrawElementsInstanced(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0, submission.item.instanceData->count);
-	}
-	else {
-		glDrawElements(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0);
+		if (shadowDrawLayers & (1u << layer)) frameRecorder.GetStats().shadowLayersDrawn++;
+		if (shadowCacheLayers & (1u << layer)) frameRecorder.GetStats().shadowLayersCached++;
 	}
 }
 
-void Renderer::DrawShadowSubmission(const RenderSubmission& submission)
+void Renderer::DrawShadowPass()
 {
-	Mesh* mesh = nullptr;
-	if (submission.item.mesh)
-		mesh = submission.item.mesh;
-	else
-		mesh = _rm.meshes.Get(submission.item.meshHandle);
-	if (!mesh) return;
-
-	//face culling is always enabled for shadow pass
-	// no material application needed for shadow pass
-
-	if ((submission.item.meshHandle.IsValid() && glState.currentMesh != submission.item.meshHandle) ||
-		(glState.currentDynamicMesh != submission.item.mesh)) {
-		mesh->Bind();
-		glState.currentMesh = submission.item.meshHandle;
-		glState.currentDynamicMesh = submission.item.mesh;
+	PROFILE_GPU_SCOPE(gpuProfiler, "ShadowPass");
+
+	const ShadowFramebuffer& shadowFBO = pointShadows ? pointShadowFBO : dirShadowFBO;
+	const ShadowFramebuffer& cacheFBO = pointShadows ? pointShadowCacheFBO : dirShadowCacheFBO;
+	// the layered variants skip the geometry shader
+	const char* shaderName = pointShadows ?
+		(vertexShadowLayers ? "pointShadowLayered" : "pointShadow") :
+		(vertexShadowLayers ? "dirShadowLayered" : "dirShadow");
+	ShaderManager::Handle shader = _rm.shaders.GetHandle(shaderName);
+
+	auto drawCasters = [&](bool staticCasters) {
+		glBackend.Execute(frameRecorder.RecordShadowPass(staticCasters, shader));
+		};
+
+	// static casters are only redrawn into the layers whose cache went stale
+	if (shadowCacheLayers)
+	{
+		cacheFBO.BindForWriting(-1, false);
+		cacheFBO.ClearLayers(shadowCacheLayers);
+		drawCasters(true);
 	}
 
-	GLenum primitive = submission.item.primitive != 0 ? submission.item.primitive : mesh->primitive;
-	if (submission.item.instanceData)
+	// the other layers keep what they were last drawn with, their light space was kept along
+	if (shadowDrawLayers)
 	{
-		if (mesh->isInstancingEnabled() == false)
-		{
-			mesh->EnableInstancing(true);
-		}
-		mesh->UploadInstancedData(dynamic_cast<InstanceData*>(submission.item.instanceData)->modelMatrices.data(), submission.item.instanceData->count);
-		glDrawElementsInstanced(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0, submission.item.instanceData->count);
-	}
-	else {
-		glDrawElements(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0);
+		shadowFBO.CopyLayers(cacheFBO, shadowDrawLayers);
+		shadowFBO.BindForWriting(-1, false);
+		drawCasters(false);
 	}
+
+	ShadowFramebuffer::Unbind(glState);
+	auto& win = AppAttorney::GetWindow(App::Get());
+	win.ResetViewport();
 }
 
-void Renderer::DrawGUISubmission(const RenderSubmission& submission)
+void Renderer::DrawMainPass()
 {
-	Mesh* mesh = nullptr;
-	if (!submission.item.meshHandle.IsValid()) {
-		mesh = _rm.meshes.Get("primitive/quad");
-	}
-	else {
-		mesh = _rm.meshes.Get(submission.item.meshHandle);
-	}
-	if (!mesh) return;
-	auto* material = _rm.materials.Get(submission.item.materialHandle);
-	if (!material) return;
+	PROFILE_GPU_SCOPE(gpuProfiler, "MainPass");
 
-	//override texture if a textureHandle is provided
-	if (submission.item.textureHandle.IsValid()) {
-		material->SetTexture("tex", submission.item.textureHandle);
-	}
+	glBackend.Execute(frameRecorder.RecordMainPass());
 
-	material->Apply(&glState);
+	// all debug lines of the frame in one draw, under the GUI
+	debugDraw.Draw(frame->debugLines, glState);
 
-	if ((submission.item.meshHandle.IsValid() && glState.currentMesh != submission.item.meshHandle) ||
-		(glState.currentDynamicMesh != submission.item.mesh)) {
-		mesh->Bind();
-		glState.currentMesh = submission.item.meshHandle;
-		glState.currentDynamicMesh = submission.item.mesh;
-	}
+	glBackend.Execute(frameRecorder.RecordGUIPass());
+}
 
-	GLenum primitive = submission.item.primitive != 0 ? submission.item.primitive : mesh->primitive;
-	if (submission.item.instanceData)
-	{
-		if (mesh->isInstancingEnabled() == false)
-		{
-			mesh->EnableInstancing(true);
-		}
-		mesh->UploadInstanceDataGUI(dynamic_cast<InstanceDataGUI*>(submission.item.instanceData));
-		glDrawElementsInstanced(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0, submission.item.instanceData->count);
-	}
-	else {
-		glDrawElements(primitive, mesh->indexCount, GL_UNSIGNED_INT, 0);
-	}
-}
\ No newline at end of file
+RendererStats Renderer::GetStats() const
+{
+	return frameRecorder.GetLastFrameStats();
+}
+
+void Renderer::PrintStats() const
+{
+	// a copy taken under the recorder's lock, the render thread keeps counting the next frame meanwhile
+	const RendererStats stats = GetStats();
+	stats.Print();
+}
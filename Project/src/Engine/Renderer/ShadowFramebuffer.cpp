@@ -2,19 +2,22 @@
 
 #include "Engine/Renderer/GLStateCache.h"
 
+#include <cstring>
+
 // =========================================================
 // ShadowFramebuffer
 // =========================================================
 
-ShadowFramebuffer::ShadowFramebuffer(ShadowMapType type)
+ShadowFramebuffer::ShadowFramebuffer(ShadowMapType type, const char* textureName)
 	: isCube(type == ShadowMapType::Point)
 {
 	auto& _tm = ResourceManager::Get().textures;
-	texHandle = isCube ? _tm.GetHandle("shadow/point") :
-		_tm.GetHandle("shadow/dir");
+	texHandle = _tm.GetHandle(textureName);
 
 	auto* tex = _tm.Get(texHandle);
 	size = tex->GetHeight(); // assuming square textures all of the same size
+	if (isCube) layerCount = 6;
+	else glGetTextureLevelParameteriv(tex->id, 0, GL_TEXTURE_DEPTH, &layerCount);
 
 	// create fbo
 	glGenFramebuffers(1, &fbo);
@@ -46,7 +49,7 @@ ShadowFramebuffer::~ShadowFramebuffer()
 	}
 }
 
-void ShadowFramebuffer::BindForWriting(int faceIndex) const
+void ShadowFramebuffer::BindForWriting(int faceIndex, bool clear) const
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 	glEnable(GL_CULL_FACE);
@@ -57,7 +60,7 @@ void ShadowFramebuffer::BindForWriting(int faceIndex) const
 			GL_TEXTURE_CUBE_MAP_POSITIVE_X + faceIndex,
 			ResourceManager::Get().textures.Get(texHandle)->id, 0);
 	}
-	Clear();
+	if (clear) Clear();
 	glViewport(0, 0, size, size);
 }
 
@@ -71,7 +74,42 @@ void ShadowFramebuffer::Unbind(const GLStateCache& glState)
 		glDisable(GL_CULL_FACE);
 }
 
+bool ShadowFramebuffer::SupportsVertexLayer()
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (!name) continue;
+		if (strcmp(name, "GL_ARB_shader_viewport_layer_array") == 0 || strcmp(name, "GL_AMD_vertex_shader_layer") == 0)
+			return true;
+	}
+	return false;
+}
+
 void ShadowFramebuffer::Clear() const
 {
 	glClear(GL_DEPTH_BUFFER_BIT);
 }
+
+void ShadowFramebuffer::ClearLayers(uint8_t layerMask) const
+{
+	// cube faces count as layers too, so both types clear the same way
+	const GLuint id = ResourceManager::Get().textures.Get(texHandle)->id;
+	const float depth = 1.f;
+	for (int layer = 0; layer < layerCount; ++layer) {
+		if (!(layerMask & (1u << layer))) continue;
+		glClearTexSubImage(id, 0, 0, 0, layer, size, size, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth);
+	}
+}
+
+void ShadowFramebuffer::CopyLayers(const ShadowFramebuffer& source, uint8_t layerMask) const
+{
+	auto& _tm = ResourceManager::Get().textures;
+	const Texture* src = _tm.Get(source.texHandle);
+	const Texture* dst = _tm.Get(texHandle);
+	for (int layer = 0; layer < layerCount; ++layer) {
+		if (!(layerMask & (1u << layer))) continue;
+		glCopyImageSubData(src->id, src->target, 0, 0, 0, layer, dst->id, dst->target, 0, 0, 0, layer, size, size, 1);
+	}
+}
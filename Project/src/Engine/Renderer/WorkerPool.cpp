@@ -0,0 +1,132 @@
+#include "Engine/Renderer/WorkerPool.h"
+#include "Engine/Profiling/Profiler.h"
+#include "Engine/Profiling/AllocationCounter.h"
+
+#include <algorithm>
+
+// =========================================================
+// WorkerPool
+// =========================================================
+
+WorkerPool::WorkerPool(uint32_t workerCount)
+{
+	if (workerCount == 0) {
+		// the event, game and render threads are already busy
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 3 ? hardwareThreads - 3 : 1;
+		workerCount = std::min<uint32_t>(workerCount, WORKER_POOL_MAX_WORKERS);
+	}
+
+	workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		workers.emplace_back([this, i]() {
+			PROFILE_THREAD(Profiler::Get().Intern("Worker " + std::to_string(i)));
+			WorkerLoop();
+			});
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+size_t WorkerPool::GetChunkCount(size_t count, size_t minChunkSize) const
+{
+	if (count == 0) return 0;
+	minChunkSize = std::max<size_t>(minChunkSize, 1);
+
+	// a few chunks per thread, so a slow chunk does not stall the others
+	size_t maxChunks = static_cast<size_t>(GetThreadCount()) * 4;
+	size_t chunks = std::max<size_t>(std::min(maxChunks, (count + minChunkSize - 1) / minChunkSize), 1);
+
+	// drop the empty chunks left by rounding the chunk size up
+	size_t chunkSize = (count + chunks - 1) / chunks;
+	return (count + chunkSize - 1) / chunkSize;
+}
+
+void WorkerPool::ParallelForChunks(size_t count, size_t minChunkSize, const ChunkFunction& func)
+{
+	size_t chunkCount = GetChunkCount(count, minChunkSize);
+	if (chunkCount == 0) return;
+
+	size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	if (chunkCount == 1 || workers.empty()) {
+		for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+			size_t begin = chunk * chunkSize;
+			func(begin, std::min(begin + chunkSize, count), chunk);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> submitLock(submitMutex);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		// late workers of the previous job may still be reading it
+		doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+
+		jobFunction = &func;
+		jobAllocations = AllocationCounter::GetCurrent();
+		jobCount = count;
+		jobChunkSize = chunkSize;
+		jobChunkCount = chunkCount;
+		nextChunk.store(0, std::memory_order_relaxed);
+		doneChunks.store(0, std::memory_order_relaxed);
+		jobGeneration++;
+	}
+	wakeCondition.notify_all();
+
+	RunChunks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]() {
+		return doneChunks.load(std::memory_order_acquire) == jobChunkCount && busyWorkers == 0;
+		});
+	jobFunction = nullptr;
+	jobAllocations = nullptr;
+}
+
+void WorkerPool::WorkerLoop()
+{
+	uint64_t seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [&]() { return stopping || jobGeneration != seenGeneration; });
+			if (stopping) return;
+			seenGeneration = jobGeneration;
+			busyWorkers++;
+		}
+
+		AllocationCounter::SetCurrent(jobAllocations);
+		RunChunks();
+		AllocationCounter::SetCurrent(nullptr);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		doneCondition.notify_all();
+	}
+}
+
+void WorkerPool::RunChunks()
+{
+	while (true) {
+		size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+		if (chunk >= jobChunkCount) return;
+
+		size_t begin = chunk * jobChunkSize;
+		size_t end = std::min(begin + jobChunkSize, jobCount);
+		(*jobFunction)(begin, end, chunk);
+
+		doneChunks.fetch_add(1, std::memory_order_release);
+	}
+}
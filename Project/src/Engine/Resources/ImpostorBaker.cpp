@@ -0,0 +1,274 @@
+#include "Engine/Resources/ImpostorBaker.h"
+#include "Engine/Resources/ModelCooker.h"
+#include "Engine/Resources/ResourceManager.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	constexpr int ATLAS_SIZE = IMPOSTOR_FRAMES * IMPOSTOR_FRAME_SIZE;
+	constexpr size_t ATLAS_BYTES = size_t(ATLAS_SIZE) * ATLAS_SIZE * 4;
+
+	// start of the cache file, followed per atlas by its name length, name, albedo and normal pixels
+	struct ImpostorCacheHeader {
+		uint32_t magic = IMPOSTOR_CACHE_MAGIC;
+		uint32_t version = IMPOSTOR_CACHE_VERSION;
+		uint32_t frames = IMPOSTOR_FRAMES;
+		uint32_t frameSize = IMPOSTOR_FRAME_SIZE;
+		CookedSourceStamps stamps;
+		uint32_t atlasCount = 0;
+		uint32_t padding = 0;
+	};
+
+	// up vector the views are baked with, the impostor shader builds its quads the same way
+	glm::vec3 GetViewUp(const glm::vec3& direction)
+	{
+		return std::abs(direction.y) > 0.999f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+	}
+
+	// Grows the colors and normals of every view past its silhouette, one pixel per iteration,
+	// without reading from the views next to it. Alpha is left as it is, so the silhouette does not move
+	void Dilate(ImpostorAtlas& atlas)
+	{
+		std::vector<uint8_t> covered(size_t(ATLAS_SIZE) * ATLAS_SIZE);
+		for (size_t p = 0; p < covered.size(); p++) covered[p] = atlas.albedo.pixels[p * 4 + 3] != 0;
+		std::vector<uint8_t> grown = covered;
+
+		const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+		for (int iteration = 0; iteration < IMPOSTOR_DILATION; iteration++) {
+			for (int y = 0; y < ATLAS_SIZE; y++) {
+				for (int x = 0; x < ATLAS_SIZE; x++) {
+					size_t p = size_t(y) * ATLAS_SIZE + x;
+					if (covered[p]) continue;
+
+					uint32_t albedo[3] = {}, normal[3] = {}, count = 0;
+					for (const auto& offset : offsets) {
+						int nx = x + offset[0], ny = y + offset[1];
+						if (nx < 0 || ny < 0 || nx >= ATLAS_SIZE || ny >= ATLAS_SIZE) continue;
+						if (nx / IMPOSTOR_FRAME_SIZE != x / IMPOSTOR_FRAME_SIZE || ny / IMPOSTOR_FRAME_SIZE != y / IMPOSTOR_FRAME_SIZE) continue;
+						size_t n = size_t(ny) * ATLAS_SIZE + nx;
+						if (!covered[n]) continue;
+						for (int c = 0; c < 3; c++) {
+							albedo[c] += atlas.albedo.pixels[n * 4 + c];
+							normal[c] += atlas.normals.pixels[n * 4 + c];
+						}
+						count++;
+					}
+					if (count == 0) continue;
+
+					for (int c = 0; c < 3; c++) {
+						atlas.albedo.pixels[p * 4 + c] = uint8_t(albedo[c] / count);
+						atlas.normals.pixels[p * 4 + c] = uint8_t(normal[c] / count);
+					}
+					grown[p] = 1;
+				}
+			}
+			covered = grown;
+		}
+	}
+}
+
+// =========================================================
+// ImpostorBaker
+// =========================================================
+namespace ImpostorBaker
+{
+	std::string GetCachePath(const std::string& modelFilePath)
+	{
+		return std::filesystem::path(modelFilePath).replace_extension(IMPOSTOR_CACHE_EXTENSION).string();
+	}
+
+	bool Read(const std::string& modelFilePath, std::vector<ImpostorAtlas>& out)
+	{
+		std::ifstream file(GetCachePath(modelFilePath), std::ios::binary);
+		if (!file.is_open()) return false;
+
+		ImpostorCacheHeader header;
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+		if (header.magic != IMPOSTOR_CACHE_MAGIC || header.version != IMPOSTOR_CACHE_VERSION ||
+			header.frames != IMPOSTOR_FRAMES || header.frameSize != IMPOSTOR_FRAME_SIZE) return false;
+		if (!(header.stamps == ModelCooker::GetSourceStamps(modelFilePath))) return false;
+
+		std::vector<ImpostorAtlas> atlases(header.atlasCount);
+		for (ImpostorAtlas& atlas : atlases) {
+			uint32_t nameLength = 0;
+			if (!file.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength)) || nameLength > 4096) return false;
+			atlas.meshName.resize(nameLength);
+			if (!file.read(atlas.meshName.data(), nameLength)) return false;
+
+			for (TextureImage* image : { &atlas.albedo, &atlas.normals }) {
+				image->width = ATLAS_SIZE;
+				image->height = ATLAS_SIZE;
+				image->channels = 4;
+				image->pixels.resize(ATLAS_BYTES);
+				if (!file.read(reinterpret_cast<char*>(image->pixels.data()), ATLAS_BYTES)) {
+					std::cerr << "ImpostorBaker: " << GetCachePath(modelFilePath) << " is broken\n";
+					return false;
+				}
+			}
+		}
+
+		out = std::move(atlases);
+		return true;
+	}
+
+	bool Write(const std::string& modelFilePath, const std::vector<ImpostorAtlas>& atlases)
+	{
+		ImpostorCacheHeader header;
+		header.stamps = ModelCooker::GetSourceStamps(modelFilePath);
+		header.atlasCount = static_cast<uint32_t>(atlases.size());
+
+		// written next to it and renamed, so a reader never sees a half written file
+		std::string cachePath = GetCachePath(modelFilePath);
+		std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			bool written = file.is_open() && file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const ImpostorAtlas& atlas : atlases) {
+				uint32_t nameLength = static_cast<uint32_t>(atlas.meshName.size());
+				written = written && file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+				written = written && file.write(atlas.meshName.data(), nameLength);
+				written = written && atlas.albedo.pixels.size() == ATLAS_BYTES && atlas.normals.pixels.size() == ATLAS_BYTES;
+				written = written && file.write(reinterpret_cast<const char*>(atlas.albedo.pixels.data()), ATLAS_BYTES);
+				written = written && file.write(reinterpret_cast<const char*>(atlas.normals.pixels.data()), ATLAS_BYTES);
+			}
+			if (!written) {
+				std::cerr << "ImpostorBaker: could not write " << temporaryPath << "\n";
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error) {
+			std::cerr << "ImpostorBaker: could not write " << cachePath << ": " << error.message() << "\n";
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool Bake(const Mesh& mesh, const Material* material, ImpostorAtlas& out)
+	{
+		auto& _rm = ResourceManager::Get();
+		Shader* shader = _rm.shaders.Get(IMPOSTOR_BAKE_SHADER);
+		if (!shader) {
+			std::cerr << "ImpostorBaker: shader " << IMPOSTOR_BAKE_SHADER << " is not loaded\n";
+			return false;
+		}
+
+		// albedo and normals are drawn at once, then read back
+		GLuint framebuffer = 0, depth = 0, targets[2] = {};
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glGenTextures(2, targets);
+		for (GLuint t = 0; t < 2; t++) {
+			glBindTexture(GL_TEXTURE_2D, targets[t]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + t, GL_TEXTURE_2D, targets[t], 0);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glGenRenderbuffers(1, &depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, ATLAS_SIZE, ATLAS_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+		const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glDrawBuffers(2, drawBuffers);
+
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		if (complete) {
+			glViewport(0, 0, ATLAS_SIZE, ATLAS_SIZE);
+			glClearColor(0.f, 0.f, 0.f, 0.f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glEnable(GL_DEPTH_TEST);
+			glDepthMask(GL_TRUE);
+			glDisable(GL_BLEND);
+			if (mesh.cullBackfaces) glEnable(GL_CULL_FACE);
+			else glDisable(GL_CULL_FACE);
+
+			// packed albedo textures are sampled from their atlas
+			TextureManager::Region region;
+			if (material) region = _rm.textures.GetRegion(material->GetTexture(material->GetTextureHandle("albedo")));
+			Texture* albedo = region.texture.IsValid() ? _rm.textures.Get(region.texture) : nullptr;
+			if (albedo) albedo->Bind(0);
+
+			_rm.shaders.UseShader(*shader);
+			shader->Set("model", mesh.positionDecode);
+			shader->Set("albedo", 0);
+			shader->Set("albedoRect", region.uvRect);
+			shader->Set("textured", albedo ? 1 : 0);
+			_rm.meshes.UseMesh(mesh);
+
+			// orthographic views of the bounding sphere
+			glm::vec3 center = (mesh.boundingBox.min + mesh.boundingBox.max) * 0.5f;
+			float radius = std::max(glm::length(mesh.boundingBox.max - mesh.boundingBox.min) * 0.5f, 1e-4f);
+			glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.f * radius);
+
+			for (int y = 0; y < IMPOSTOR_FRAMES; y++) {
+				for (int x = 0; x < IMPOSTOR_FRAMES; x++) {
+					glm::vec3 direction = OctahedralDecode((glm::vec2(float(x), float(y)) + 0.5f) / float(IMPOSTOR_FRAMES));
+					glm::mat4 view = glm::lookAt(center + direction * 2.f * radius, center, GetViewUp(direction));
+					shader->Set("viewProjection", projection * view);
+
+					glViewport(x * IMPOSTOR_FRAME_SIZE, y * IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE);
+					if (mesh.indexCount > 0) glDrawElements(mesh.primitive, GLsizei(mesh.indexCount), mesh.indexType, nullptr);
+					else glDrawArrays(mesh.primitive, 0, GLsizei(mesh.vertexCount));
+				}
+			}
+
+			for (GLuint t = 0; t < 2; t++) {
+				TextureImage& image = t == 0 ? out.albedo : out.normals;
+				image.width = ATLAS_SIZE;
+				image.height = ATLAS_SIZE;
+				image.channels = 4;
+				image.pixels.resize(ATLAS_BYTES);
+				glReadBuffer(GL_COLOR_ATTACHMENT0 + t);
+				glReadPixels(0, 0, ATLAS_SIZE, ATLAS_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+			}
+
+			if (albedo) glBindTexture(GL_TEXTURE_2D, 0);
+			_rm.meshes.UnbindMesh();
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_CULL_FACE);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteRenderbuffers(1, &depth);
+		glDeleteTextures(2, targets);
+		glDeleteFramebuffers(1, &framebuffer);
+
+		if (!complete) {
+			std::cerr << "ImpostorBaker: bake framebuffer is incomplete\n";
+			return false;
+		}
+		Dilate(out);
+		return true;
+	}
+
+	glm::mat4 GetQuadFrame(const BoundingBox& bounds)
+	{
+		// the quad spans [-0.5, 0.5], the views span the diameter
+		glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		float diameter = std::max(glm::length(bounds.max - bounds.min), 2e-4f);
+		return glm::scale(glm::translate(glm::mat4(1.f), center), glm::vec3(diameter));
+	}
+
+	glm::vec3 OctahedralDecode(const glm::vec2& uv)
+	{
+		// y is the axis through the center of the grid, the lower hemisphere is folded onto the corners
+		glm::vec2 p = uv * 2.f - 1.f;
+		glm::vec3 direction(p.x, 1.f - std::abs(p.x) - std::abs(p.y), p.y);
+		if (direction.y < 0.f) {
+			float x = (1.f - std::abs(p.y)) * (p.x >= 0.f ? 1.f : -1.f);
+			float z = (1.f - std::abs(p.x)) * (p.y >= 0.f ? 1.f : -1.f);
+			direction.x = x;
+			direction.z = z;
+		}
+		return glm::normalize(direction);
+	}
+}
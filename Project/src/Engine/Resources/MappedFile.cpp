@@ -0,0 +1,95 @@
+#include "Engine/Resources/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// =========================================================
+// MappedFile
+// =========================================================
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+	file = fileHandle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		Close();
+		return false;
+	}
+
+	data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data) {
+		Close();
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	if (mapped == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	data = static_cast<const uint8_t*>(mapped);
+	size = static_cast<size_t>(fileStat.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) munmap(const_cast<uint8_t*>(data), size);
+	if (file >= 0) close(file);
+	data = nullptr;
+	size = 0;
+	file = -1;
+}
+#endif
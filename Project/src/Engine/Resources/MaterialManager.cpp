@@ -1,10 +1,13 @@
 #include "Engine/Resources/MaterialManager.h"
 
 #include "Engine/Resources/ResourceManager.h"
+#include "Engine/Resources/ResourceLoader.h"
 #include "Engine/Renderer/GLStateCache.h"
 
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
+#include <memory>
 
 // Macro to parse an array JSON into a given glm type.
 // Usage: PARSE_GLM_SINGLE(glm::vec2)
@@ -62,20 +65,41 @@ ShaderReflection* Material::GetShaderReflection() const {
 	return shaderPtr ? &shaderPtr->reflection : nullptr;
 }
 
-void Material::SetTexture(const std::string& uniformName, TextureManager::Handle tex) {
-	textures[uniformName] = tex;
-	dirtyTextures[uniformName] = true;
+UniformHandle Material::GetUniformHandle(const std::string& name) const {
+	auto it = uniformIndices.find(name);
+	if (it == uniformIndices.end()) return {};
+	return { it->second };
 }
 
-void Material::SetTexture(const std::string& uniformName, const std::string& texName) {
-	TextureManager& tm = ResourceManager::Get().textures;
-	TextureManager::Handle texHandle = tm.GetHandle(texName);
-	if(texHandle == textures[uniformName]) {
+UniformHandle Material::GetTextureHandle(const std::string& samplerName) const {
+	auto it = textureIndices.find(samplerName);
+	if (it == textureIndices.end()) return {};
+	return { it->second };
+}
+
+void Material::SetTexture(UniformHandle sampler, TextureManager::Handle tex) {
+	if (!sampler.IsValid()) return;
+	MaterialTexture& texture = textures[sampler.index];
+	if (texture.rect.IsValid()) {
+		TextureManager::Region region = ResourceManager::Get().textures.GetRegion(tex);
+		tex = region.texture;
+		SetUniform(texture.rect, region.uvRect);
+	}
+	if (texture.texture == tex) {
 		//same texture, do nothing
 		return;
 	}
-	textures[uniformName] = texHandle;
-	dirtyTextures[uniformName] = true;
+	texture.texture = tex;
+	texture.dirty = true;
+}
+
+void Material::SetTexture(const std::string& uniformName, TextureManager::Handle tex) {
+	SetTexture(GetTextureHandle(uniformName), tex);
+}
+
+void Material::SetTexture(const std::string& uniformName, const std::string& texName) {
+	TextureManager& tm = ResourceManager::Get().textures;
+	SetTexture(GetTextureHandle(uniformName), tm.GetHandle(texName));
 }
 
 UboWriter* Material::GetLocalUboWriter(const std::string& blockName) {
@@ -87,6 +111,32 @@ UboWriter* Material::GetLocalUboWriter(const std::string& blockName) {
 	return nullptr;
 }
 
+std::string Material::GetStateSignature() const {
+	std::string signature;
+	auto append = [&signature](const void* data, size_t size) {
+		signature.append(static_cast<const char*>(data), size);
+		};
+
+	append(&shader, sizeof(shader));
+	for (const auto& uniform : uniforms) {
+		append(&uniform.location, sizeof(uniform.location));
+		append(uniform.value.data.data(), uniform.value.data.size());
+	}
+	for (const auto& texture : textures) {
+		append(&texture.unit, sizeof(texture.unit));
+		append(&texture.texture, sizeof(texture.texture));
+	}
+	// local UBOs are few, but their map has no fixed order
+	std::vector<const std::pair<const std::string, UboWriter>*> sortedUbos;
+	for (const auto& entry : ubos) sortedUbos.push_back(&entry);
+	std::sort(sortedUbos.begin(), sortedUbos.end(), [](auto* a, auto* b) { return a->first < b->first; });
+	for (const auto* entry : sortedUbos) {
+		signature += entry->first;
+		append(entry->second.GetData().data(), entry->second.GetData().size());
+	}
+	return signature;
+}
+
 void Material::Apply(GLStateCache* glState) {
 	ShaderManager& sm = ResourceManager::Get().shaders;
 	TextureManager& tm = ResourceManager::Get().textures;
@@ -101,35 +151,32 @@ void Material::Apply(GLStateCache* glState) {
 	}
 
 	// Apply uniforms
-	for (const auto& [name, uniformValue] : uniforms) {
-		//uniform name is guaranteed to exist in the shader from ManagerPolicy, so no check needed
-		if (!uniformValue.dirty && (!glState || glState->currentMaterial == this)) continue; //skip non-dirty uniforms
-		shaderPtr->SetRaw(name, uniformValue.type, uniformValue.data.data(), uniformValue.elementCount);
-		uniforms[name].dirty = false;
+	bool sameMaterial = glState && glState->currentMaterial == this;
+	for (auto& uniform : uniforms) {
+		//uniform location and type come from the shader reflection, so no check needed
+		if (!uniform.value.dirty && (!glState || sameMaterial)) continue; //skip non-dirty uniforms
+		shaderPtr->SetRaw(uniform.location, uniform.value.type, uniform.value.data.data(), uniform.value.elementCount);
+		uniform.value.dirty = false;
 	}
 	// Apply UBOs
 	for (auto& [blockName, uboWriter] : ubos) {
-		if (!glState || glState->currentMaterial != this) uboWriter.MakeDirty();
+		if (!sameMaterial) uboWriter.MakeDirty();
 		uboWriter.Upload();
 	}
 	// Bind textures
-	for (const auto& [uniformName, texHandle] : textures) {
+	for (auto& texture : textures) {
 		//only bind if dirty
-		if (!dirtyTextures[uniformName] && glState->currentMaterial == this) continue;
+		if (!texture.dirty && sameMaterial) continue;
 
 		//we can just bind all the textures, if the material has more textures than there are units, that's currently a limitation of the engine
-		//tm.Bind(texHandle);
-		const ShaderReflection& refl = shaderPtr->reflection;
-		auto it = refl.samplers.find(uniformName);
-		if (it == refl.samplers.end()) continue;
-
-		int unit = it->second.textureUnit;
+		int unit = texture.unit;
+		TextureManager::Handle texHandle = texture.texture;
+		texture.dirty = false;
 
 		bool bindUnit = (!glState) || (glState->activeTextureUnit != unit);
 
 		if(glState && glState->boundTextures[unit] == texHandle) {
 			//texture already bound at this unit, skip
-			dirtyTextures[uniformName] = false;
 			continue;
 		}
 
@@ -137,7 +184,6 @@ void Material::Apply(GLStateCache* glState) {
 		if (!texHandle.IsValid()) {
 			tm.UnbindFromUnit(unit, bindUnit);
 			if(glState) glState->boundTextures[unit] = TextureManager::Handle{};
-			dirtyTextures[uniformName] = false;
 			continue;
 		}
 
@@ -146,8 +192,6 @@ void Material::Apply(GLStateCache* glState) {
 		if (glState) {
 			glState->boundTextures[unit] = texHandle;
 		}
-		dirtyTextures[uniformName] = false;
-
 	}
 
 	if (glState) glState->currentMaterial = this;
@@ -176,6 +220,7 @@ Material MaterialPolicy::Create(const std::string& name, const MaterialResourceI
 	mat.shader = sm.GetHandle(resourceInfo.shaderName);
 
 	const ShaderReflection& reflection = shaderPtr->reflection;
+	mat.usesMaterialTable = reflection.HasStorageBlock(MATERIAL_TABLE_BLOCK_NAME);
 
 	// Parse uniforms
 	for (const auto& [uniformName, uniformInfo] : reflection.uniforms) {
@@ -186,7 +231,8 @@ Material MaterialPolicy::Create(const std::string& name, const MaterialResourceI
 		uvalue.elementCount = static_cast<size_t>(uniformInfo.size);
 		uvalue.data.resize(GLTypeSize(uniformInfo.type) * uvalue.elementCount, 0);
 
-		mat.uniforms.try_emplace(uniformName, std::move(uvalue));
+		mat.uniformIndices.try_emplace(uniformName, static_cast<uint32_t>(mat.uniforms.size()));
+		mat.uniforms.push_back({ uniformInfo.location, std::move(uvalue) });
 	}
 
 	// Parse UBOs
@@ -201,28 +247,24 @@ Material MaterialPolicy::Create(const std::string& name, const MaterialResourceI
 
 	// Parse samplers
 	for (const auto& [samplerName, samplerInfo] : reflection.samplers) {
+		mat.textureIndices.try_emplace(samplerName, static_cast<uint32_t>(mat.textures.size()));
+		// Just set to invalid handle for now, user can set later
+		Material::MaterialTexture& texture = mat.textures.emplace_back();
+		texture.unit = samplerInfo.textureUnit;
+
 		// automatically set textures for shadow maps if they exist
 		if(samplerName == "pointShadow"){
-			TextureManager::Handle shadowCubemap = tm.GetHandle("shadow/point");
-			if(shadowCubemap.IsValid()){
-				mat.textures[samplerName] = shadowCubemap;
-				mat.dirtyTextures[samplerName] = true;
-				continue;
-			}
+			texture.texture = tm.GetHandle("shadow/point");
 		}
 		else if (samplerName == "dirShadow") {
-			TextureManager::Handle shadowMap = tm.GetHandle("shadow/dir");
-			if (shadowMap.IsValid()) {
-				mat.textures[samplerName] = shadowMap;
-				mat.dirtyTextures[samplerName] = true;
-				continue;
-			}
+			texture.texture = tm.GetHandle("shadow/dir");
 		}
-		
-		// Just set to invalid handle for now, user can set later
-		mat.textures[samplerName] = TextureManager::Handle{};
-		mat.dirtyTextures[samplerName] = false;
+		texture.dirty = texture.texture.IsValid();
+
+		texture.rect = mat.GetUniformHandle(samplerName + "Rect");
+		mat.SetUniform(texture.rect, glm::vec4(0.f, 0.f, 1.f, 1.f));
 	}
+	mat.mainTexture = mat.GetTextureHandle("tex");
 	return mat;
 }
 
@@ -551,7 +593,7 @@ void MaterialPolicy::ParseJSON(const nlohmann::json& j, Material& mat) {
 		for (auto& [name, val] : j["textures"].items())
 		{
 			// check that texture exists in material
-			if (!mat.textures.contains(name)) {
+			if (!mat.GetTextureHandle(name).IsValid()) {
 				std::cerr << "[Material JSON] Material has no texture uniform: " << name << "\n";
 				continue;
 			}
@@ -796,17 +838,50 @@ void MaterialPolicy::ParseJSON(const nlohmann::json& j, Material& mat) {
 		}
 	}
 
+	// load material table constants
+	if (j.contains("parameters") && j["parameters"].is_object()) {
+		if (!mat.usesMaterialTable) {
+			std::cerr << "[Material JSON] Shader has no " << MATERIAL_TABLE_BLOCK_NAME << ", parameters are ignored.\n";
+		}
+		for (auto& [name, val] : j["parameters"].items())
+		{
+			if (!val.is_number()) {
+				std::cerr << "[Material JSON] Parameter " << name << " is not a number.\n";
+				continue;
+			}
+
+			if (name == "shininess") mat.params.shininess = val.get<float>();
+			else if (name == "specularStrength") mat.params.specularStrength = val.get<float>();
+			else if (name == "metalicity") mat.params.metalicity = val.get<float>();
+			else if (name == "overrideMetalness") mat.params.overrideMetalness = val.get<uint32_t>();
+			else std::cerr << "[Material JSON] Unknown parameter: " << name << "\n";
+		}
+	}
+
 	// check if material casts shadows
 	if (j.contains("castShadows") && j["castShadows"].is_boolean()) {
 		mat.castShadows = j["castShadows"].get<bool>();
 	}
+
+	// check if material is a software occlusion occluder
+	if (j.contains("occluder") && j["occluder"].is_boolean()) {
+		mat.occluder = j["occluder"].get<bool>();
+	}
 }
 
 // =========================================================
 // MaterialManager
 // =========================================================
 MaterialManager::MaterialHandle MaterialManager::LoadFromJSON(const std::string& JSONFilePath) {
-	auto [mat, name, error] = policy.CreateFromJSON(JSONFilePath);
+	return AddCreated(policy.CreateFromJSON(JSONFilePath), JSONFilePath);
+}
+
+MaterialManager::MaterialHandle MaterialManager::LoadFromJSONObject(const nlohmann::json& j, const std::string& source) {
+	return AddCreated(policy.CreateFromJSONObject(j), source);
+}
+
+MaterialManager::MaterialHandle MaterialManager::AddCreated(std::tuple<Material, std::string, std::string> created, const std::string& source) {
+	auto& [mat, name, error] = created;
 	if (!error.empty()) {
 		if (error == "MaterialExists") {
 			// Material already exists, return existing handle
@@ -814,7 +889,7 @@ MaterialManager::MaterialHandle MaterialManager::LoadFromJSON(const std::string&
 			return this->GetHandle(name);
 		}
 
-		std::cerr << "MaterialManager::LoadFromJSON: Failed to create material from JSON " << JSONFilePath << ": " << error << std::endl;
+		std::cerr << "MaterialManager::LoadFromJSON: Failed to create material from JSON " << source << ": " << error << std::endl;
 		return Handle{};
 	}
 	
@@ -825,11 +900,61 @@ MaterialManager::MaterialHandle MaterialManager::LoadFromJSON(const std::string&
 	resources[id] = { mat, gen };
 	nameToHandle[name] = Handle{ id, gen };
 	handleToName[id] = name;
+	AssignDenseId(id);
+	OnResourceAdded(Handle{ id, gen }, resources[id].resource);
 
 	return Handle{ id, gen };
 }
 
-void MaterialManager::PreloadResources(const std::string& resourceDirectory) {
+void MaterialManager::OnResourceAdded(Handle handle, const Material& material) {
+	if (materialShaders.size() <= handle.id) materialShaders.resize(handle.id + 1);
+	materialShaders[handle.id] = material.GetShader();
+
+	// only material table users can share a group, everything else they set is part of the signature
+	uint32_t group = 0;
+	if (material.usesMaterialTable) {
+		auto [it, inserted] = sharedBatchGroups.try_emplace(material.GetStateSignature(), nextBatchGroup);
+		if (inserted) nextBatchGroup++;
+		group = it->second;
+	}
+	else {
+		group = nextBatchGroup++;
+	}
+	if (batchGroups.size() <= handle.id) batchGroups.resize(handle.id + 1, 0);
+	batchGroups[handle.id] = group;
+
+	std::lock_guard<std::mutex> lock(paramsMutex);
+	uint32_t denseId = GetDenseId(handle);
+	if (params.size() <= denseId) params.resize(denseId + 1);
+	params[denseId] = material.params;
+	paramsVersion++;
+}
+
+void MaterialManager::SetParams(MaterialHandle handle, const MaterialParams& materialParams) {
+	Material* material = Get(handle);
+	if (!material) return;
+	if (!material->usesMaterialTable) {
+		std::cerr << "MaterialManager::SetParams: material does not use the material table\n";
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(paramsMutex);
+	material->params = materialParams;
+	uint32_t denseId = GetDenseId(handle);
+	if (params[denseId] == materialParams) return;
+	params[denseId] = materialParams;
+	paramsVersion++;
+}
+
+bool MaterialManager::CopyParamsIfChanged(uint32_t& version, std::vector<MaterialParams>& out) const {
+	std::lock_guard<std::mutex> lock(paramsMutex);
+	if (version == paramsVersion) return false;
+	out = params;
+	version = paramsVersion;
+	return true;
+}
+
+void MaterialManager::QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory) {
 	std::string materialsDir = "materials/";
 	std::filesystem::path fullDir = std::filesystem::path(resourceDirectory) / materialsDir;
 
@@ -838,7 +963,24 @@ void MaterialManager::PreloadResources(const std::string& resourceDirectory) {
 			std::string fullPath = entry.path().string();
 			std::string relativePath = std::filesystem::relative(entry.path(), fullDir).string();
 			std::cout << "  Loading material: " << relativePath << "\n";
-			LoadFromJSON(fullPath);
+
+			// parsed on a loader thread, created once the shaders and textures it names are loaded
+			loader.Add(ResourceKind::Material, relativePath, [this, fullPath]() -> ResourceLoader::UploadFunction {
+				std::ifstream file(fullPath);
+				if (!file.is_open()) {
+					std::cerr << "Failed to open material JSON: " << fullPath << "\n";
+					return nullptr;
+				}
+				auto j = std::make_shared<nlohmann::json>();
+				try {
+					file >> *j;
+				}
+				catch (const std::exception&) {
+					std::cerr << "Failed to parse material JSON: " << fullPath << "\n";
+					return nullptr;
+				}
+				return [this, j, fullPath]() { LoadFromJSONObject(*j, fullPath); };
+				});
 		}
 	}
 }
@@ -1,4 +1,5 @@
 #include "Engine/Resources/MeshFactory.h"
+#include "Engine/Resources/MeshOptimizer.h"
 
 namespace MeshFactory {
 	MeshPolicy mp;
@@ -23,6 +24,14 @@ namespace MeshFactory {
 
 	const float PI = 3.14159265359f;
 
+	// creates a triangle list mesh, reordered for the GPU caches unless MESH_OPTIMIZE_ON_IMPORT is 0
+	Mesh CreateOptimized(const std::string& label, MeshResoruceInfo info) {
+#if MESH_OPTIMIZE_ON_IMPORT
+		MeshOptimizer::Optimize(info, label);
+#endif
+		return mp.Create("", info);
+	}
+
 	Mesh CreateCube(float size) {
 		float h = size / 2.0f;
 		std::vector<Vertex> vertices = {
@@ -74,15 +83,15 @@ namespace MeshFactory {
 
 		std::vector<uint8_t> vertexData(vertices.size() * sizeof(Vertex));
 		memcpy(vertexData.data(), vertices.data(), vertexData.size());
-		Mesh mesh = mp.Create(
-			"",
+		Mesh mesh = CreateOptimized(
+			"cube",
 			MeshResoruceInfo{
-				vertexData,
-				indices,
-				standardAttributes,
-				sizeof(Vertex),
-				BoundingBox{ glm::vec3(-h, -h, -h), glm::vec3(h, h, h) },
-				true
+				.vertexData = vertexData,
+				.indices = indices,
+				.attributes = standardAttributes,
+				.stride = sizeof(Vertex),
+				.boundingBox = BoundingBox{ glm::vec3(-h, -h, -h), glm::vec3(h, h, h) },
+				.cullBackfaces = true
 			});
 		return mesh;
 	}
@@ -149,15 +158,15 @@ namespace MeshFactory {
 		}
 		std::vector<uint8_t> vertexData(vertices.size() * sizeof(Vertex));
 		memcpy(vertexData.data(), vertices.data(), vertexData.size());
-		Mesh mesh = mp.Create(
-			"",
+		Mesh mesh = CreateOptimized(
+			"quad",
 			MeshResoruceInfo{
-				vertexData,
-				indices,
-				standardAttributes,
-				sizeof(Vertex),
-				BoundingBox{ glm::vec3(-size / 2.0f, -size / 2.0f, 0.0f), glm::vec3(size / 2.0f, size / 2.0f, 0.0f) },
-				type != NO_BACKFACE_CULLING
+				.vertexData = vertexData,
+				.indices = indices,
+				.attributes = standardAttributes,
+				.stride = sizeof(Vertex),
+				.boundingBox = BoundingBox{ glm::vec3(-size / 2.0f, -size / 2.0f, 0.0f), glm::vec3(size / 2.0f, size / 2.0f, 0.0f) },
+				.cullBackfaces = type != NO_BACKFACE_CULLING
 			});
 		return mesh;
 	}
@@ -219,18 +228,18 @@ namespace MeshFactory {
 		std::vector<uint8_t> vertexData(vertices.size() * sizeof(Vertex));
 		memcpy(vertexData.data(), vertices.data(), vertexData.size());
 
-		Mesh mesh = mp.Create(
-			"",
+		Mesh mesh = CreateOptimized(
+			"uv sphere",
 			MeshResoruceInfo{
-				vertexData,
-				indices,
-				standardAttributes,
-				sizeof(Vertex),
-				BoundingBox{
+				.vertexData = vertexData,
+				.indices = indices,
+				.attributes = standardAttributes,
+				.stride = sizeof(Vertex),
+				.boundingBox = BoundingBox{
 					glm::vec3(-radius, -radius, -radius),
 					glm::vec3(radius,  radius,  radius)
 				},
-				true
+				.cullBackfaces = true
 			}
 		);
 		return mesh;
@@ -267,12 +276,12 @@ namespace MeshFactory {
 		Mesh mesh = mp.Create(
 			"",
 			MeshResoruceInfo{
-				vertexData,
-				indices,
-				bbAttributes,
-				sizeof(VertexBB),
-				bbo,
-				false
+				.vertexData = vertexData,
+				.indices = indices,
+				.attributes = bbAttributes,
+				.stride = sizeof(VertexBB),
+				.boundingBox = bbo,
+				.cullBackfaces = false
 			});
 		mesh.primitive = GL_LINES;
 		return mesh;
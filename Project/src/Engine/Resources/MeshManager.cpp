@@ -16,30 +16,35 @@ void Mesh::Bind() const
 	}
 }
 
-void Mesh::EnableInstancing(bool vaoAlreadyBound)
+void Mesh::BindInstanceStream(const InstanceStreamBuffer& stream, InstanceLayout layout)
 {
-    if (instanceVBO != 0) return; // already enabled
-    if(!vaoAlreadyBound) glBindVertexArray(vao);
+    if (instanceStreamGeneration == stream.GetGeneration() && instanceLayout == layout) return;
 
-    glGenBuffers(1, &instanceVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    // Allocate buffer
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.GetBuffer());
 
 	GLuint attributeIndexStart = 12; // starting attribute index for instance matrix
-	const GLsizei stride = sizeof(glm::mat4) + (isGuiMesh ? sizeof(glm::vec4) : 0);
+	const GLsizei stride = GetInstanceStride(layout);
 	uintptr_t offset = 0;
 
-    if(isGuiMesh) {
-        // UV offset attribute
-        GLuint uvAttribIndex = attributeIndexStart-1;
+    // UV offset attribute for GUI instances, shadow map layer for shadow instances, material table index for model instances
+    GLuint uvAttribIndex = attributeIndexStart - 1;
+    if (layout == InstanceLayout::GUI) {
         glEnableVertexAttribArray(uvAttribIndex);
         glVertexAttribPointer(uvAttribIndex, 4, GL_FLOAT, GL_FALSE,
             stride,
             0);
         glVertexAttribDivisor(uvAttribIndex, 1); // advance per instance
-        offset += sizeof(glm::vec4);;
+        offset += sizeof(glm::vec4);
 	}
+    else {
+        static_assert(offsetof(ShadowInstanceData, modelMatrix) == offsetof(ModelInstanceData, modelMatrix));
+        glEnableVertexAttribArray(uvAttribIndex);
+        glVertexAttribIPointer(uvAttribIndex, 1, GL_UNSIGNED_INT,
+            stride,
+            0);
+        glVertexAttribDivisor(uvAttribIndex, 1);
+        offset += offsetof(ModelInstanceData, modelMatrix);
+    }
 
     for (GLuint i = 0; i < 4; i++) {
         GLuint attribIndex = attributeIndexStart + i;
@@ -51,58 +56,46 @@ void Mesh::EnableInstancing(bool vaoAlreadyBound)
         glVertexAttribDivisor(attribIndex, 1); // advance per instance
     }
 
-    if (!vaoAlreadyBound) glBindVertexArray(0);
+    instanceStreamGeneration = stream.GetGeneration();
+    instanceLayout = layout;
 }
 
-void Mesh::UploadInstancedData(const void* data, size_t count)
-{
-    if (instanceVBO == 0) return; // instancing not enabled
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    // upload only the matrix data, GUI meshes have uv offsets at the beginning
-    if (!isGuiMesh) {
-        glBufferData(GL_ARRAY_BUFFER,
-            sizeof(glm::mat4) * count,
-            data,
-            GL_DYNAMIC_DRAW);
-    }
-    else {
-		//alocate size for uv offsets + matrices
-        glBufferData(GL_ARRAY_BUFFER,
-            (sizeof(glm::vec4) + sizeof(glm::mat4)) * count,
-            nullptr,
-			GL_DYNAMIC_DRAW);
-
-        glBufferSubData(GL_ARRAY_BUFFER,
-            sizeof(glm::vec4) * count,
-            sizeof(glm::mat4) * count,
-			data);
-    }
-}
+// ==========================================
+// MeshPolicy
+// ==========================================
+DenseIdTable MeshPolicy::sortIds;
 
-void Mesh::UploadInstanceDataGUI(const InstanceDataGUI* data)
+namespace
 {
-    if (instanceVBO == 0 || !isGuiMesh) return;
-
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER,
-        data->guiData.size() * sizeof(GUIData),
-        data->guiData.data(),
-        GL_DYNAMIC_DRAW);
+	// vertex and index data of a mesh created from vectors
+	struct MeshStorage {
+		std::vector<uint8_t> vertexData;
+		std::vector<uint32_t> indices;
+	};
 }
 
-// ==========================================
-// MeshPolicy
-// ==========================================
 Mesh MeshPolicy::Create(const std::string& name, const MeshResoruceInfo& resourceInfo)
 {
 	Mesh mesh;
+	mesh.sortId = sortIds.Acquire();
 
-	mesh.vertexData = resourceInfo.vertexData;
-	mesh.indices = resourceInfo.indices;
+	if (resourceInfo.storage) {
+		mesh.storage = resourceInfo.storage;
+		mesh.vertexData = resourceInfo.storedVertexData;
+		mesh.indices = resourceInfo.storedIndices;
+	}
+	else {
+		auto owned = std::make_shared<MeshStorage>(MeshStorage{ resourceInfo.vertexData, resourceInfo.indices });
+		mesh.vertexData = owned->vertexData;
+		mesh.indices = owned->indices;
+		mesh.storage = std::move(owned);
+	}
 	mesh.attributes = resourceInfo.attributes;
 	mesh.vertexStride = resourceInfo.stride;
-	mesh.vertexCount = resourceInfo.vertexData.size() / resourceInfo.stride;
-	mesh.indexCount = resourceInfo.indices.size();
+	mesh.vertexCount = mesh.vertexData.size() / resourceInfo.stride;
+	mesh.indexCount = mesh.indices.size();
+	mesh.indexType = mesh.vertexCount < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.positionDecode = resourceInfo.positionDecode;
 	mesh.boundingBox = resourceInfo.boundingBox;
 	mesh.cullBackfaces = resourceInfo.cullBackfaces;
 
@@ -118,10 +111,8 @@ void MeshPolicy::Destroy(Mesh& res)
 	glDeleteBuffers(1, &res.vbo);
 	glDeleteBuffers(1, &res.ebo);
 	glDeleteVertexArrays(1, &res.vao);
-    if (res.instanceVBO != 0) {
-        glDeleteBuffers(1, &res.instanceVBO);
-        res.instanceVBO = 0;
-	}
+	sortIds.Release(res.sortId);
+	res.sortId = 0;
 	res.alive = false;
 }
 
@@ -140,12 +131,21 @@ void MeshPolicy::Upload(Mesh* mesh)
         mesh->vertexData.data(),
         GL_STATIC_DRAW);
 
-    // EBO
+    // EBO, the CPU copy keeps 32 bit indices
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-        mesh->indices.size() * sizeof(uint32_t),
-        mesh->indices.data(),
-        GL_STATIC_DRAW);
+    if (mesh->indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(mesh->indices.begin(), mesh->indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+            shortIndices.size() * sizeof(uint16_t),
+            shortIndices.data(),
+            GL_STATIC_DRAW);
+    }
+    else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+            mesh->indices.size() * sizeof(uint32_t),
+            mesh->indices.data(),
+            GL_STATIC_DRAW);
+    }
 
     // Attributes
     for (const auto& attr : mesh->attributes)
@@ -161,7 +161,9 @@ void MeshPolicy::Upload(Mesh* mesh)
         );
     }
 
-    glBindVertexArray(0);
+    // the bound VAO changed behind the cache of Mesh::Bind
+    if (Mesh::_mm) Mesh::_mm->UnbindMesh();
+    else glBindVertexArray(0);
 }
 
 // ==========================================
@@ -175,25 +177,45 @@ MeshManager::MeshManager()
 void MeshManager::UseMesh(const MeshHandle& h)
 {
     Mesh* mesh = Get(h);
-    if (mesh && mesh->vao != currentVAO) {
-		currentVAO = mesh->vao;
-		mesh->Bind();
-    }
+    if (mesh) mesh->Bind();
 }
 
 void MeshManager::UseMesh(const Mesh& mesh)
 {
-    if (mesh.vao != currentVAO) {
-        currentVAO = mesh.vao;
-        mesh.Bind();
-    }
+    mesh.Bind();
 }
 
 void MeshManager::UseMesh(const std::string& name)
 {
     Mesh* mesh = Get(name);
-    if (mesh && mesh->vao != currentVAO) {
-        currentVAO = mesh->vao;
-        mesh->Bind();
-    }
-}
\ No newline at end of file
+    if (mesh) mesh->Bind();
+}
+
+void MeshManager::UnbindMesh()
+{
+    glBindVertexArray(0);
+    currentVAO = 0;
+}
+
+void MeshManager::OnResourceAdded(Handle handle, const Mesh& mesh)
+{
+    if (positionDecodes.size() <= handle.id) positionDecodes.resize(handle.id + 1);
+    if (lodChains.size() <= handle.id) lodChains.resize(handle.id + 1);
+    if (impostors.size() <= handle.id) impostors.resize(handle.id + 1);
+    // ids are reused, so nothing may be left from a removed mesh
+    positionDecodes[handle.id] = mesh.positionDecode != glm::mat4(1.f) ? std::optional<glm::mat4>(mesh.positionDecode) : std::nullopt;
+    lodChains[handle.id] = MeshLodChain{};
+    impostors[handle.id] = MeshImpostor{};
+}
+
+void MeshManager::SetLodChain(MeshHandle handle, const MeshLodChain& chain)
+{
+    if (lodChains.size() <= handle.id) lodChains.resize(handle.id + 1);
+    lodChains[handle.id] = chain;
+}
+
+void MeshManager::SetImpostor(MeshHandle handle, const MeshImpostor& impostor)
+{
+    if (impostors.size() <= handle.id) impostors.resize(handle.id + 1);
+    impostors[handle.id] = impostor;
+}
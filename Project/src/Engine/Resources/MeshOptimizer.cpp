@@ -0,0 +1,275 @@
+#include "Engine/Resources/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	constexpr uint32_t CACHE_SIZE = MESH_OPTIMIZER_CACHE_SIZE;
+	constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+	// triangles using each vertex
+	struct Adjacency
+	{
+		std::vector<uint32_t> offsets;	// vertexCount + 1 entries
+		std::vector<uint32_t> triangles;
+	};
+
+	Adjacency BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		Adjacency adjacency;
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices) adjacency.offsets[index + 1]++;
+		for (uint32_t v = 0; v < vertexCount; v++) adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+		adjacency.triangles.resize(indices.size());
+		std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) {
+			adjacency.triangles[fill[indices[i]]++] = uint32_t(i / 3);
+		}
+		return adjacency;
+	}
+
+	// Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+	// Fans around one vertex at a time and moves on to a neighbour that is still in the cache.
+	// clusterStarts gets the first triangle after each jump to a vertex the cache has likely lost
+	std::vector<uint32_t> Tipsify(const std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& clusterStarts)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		Adjacency adjacency = BuildAdjacency(indices, vertexCount);
+
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+		}
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+
+		std::vector<uint32_t> deadEnd;
+		deadEnd.reserve(indices.size());
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		uint32_t time = CACHE_SIZE + 1;
+		uint32_t scan = 0;
+
+		auto nextLive = [&]() -> uint32_t {
+			while (scan < vertexCount && liveTriangles[scan] == 0) scan++;
+			return scan < vertexCount ? scan : NO_VERTEX;
+		};
+
+		uint32_t fanning = nextLive();
+		bool jumped = true;
+		while (fanning != NO_VERTEX) {
+			if (jumped) clusterStarts.push_back(uint32_t(result.size() / 3));
+			jumped = false;
+
+			candidates.clear();
+			for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++) {
+				uint32_t triangle = adjacency.triangles[a];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = true;
+
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t v = indices[triangle * 3 + k];
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - cacheTime[v] > CACHE_SIZE) {
+						cacheTime[v] = time++;
+					}
+				}
+			}
+
+			// the candidate that stays longest in the cache while its own fan is emitted
+			uint32_t next = NO_VERTEX;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates) {
+				if (liveTriangles[v] == 0) continue;
+				int64_t priority = 0;
+				if (time - cacheTime[v] + 2 * liveTriangles[v] <= CACHE_SIZE) priority = time - cacheTime[v];
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = v;
+				}
+			}
+
+			if (next == NO_VERTEX) {
+				jumped = true;
+				while (!deadEnd.empty() && next == NO_VERTEX) {
+					uint32_t v = deadEnd.back();
+					deadEnd.pop_back();
+					if (liveTriangles[v] > 0) next = v;
+				}
+				if (next == NO_VERTEX) next = nextLive();
+			}
+			fanning = next;
+		}
+		return result;
+	}
+
+	// Orders the clusters by how much they face away from the center of the mesh,
+	// those on the outside tend to hide the others from any view, so they draw first
+	std::vector<uint32_t> SortClusters(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusterStarts, const std::vector<glm::vec3>& positions)
+	{
+		const uint32_t triangleCount = uint32_t(indices.size() / 3);
+
+		glm::vec3 meshCentroid(0.f);
+		float meshArea = 0.f;
+		std::vector<glm::vec3> triangleNormals(triangleCount);	// length is twice the area
+		std::vector<glm::vec3> triangleCentroids(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			const glm::vec3& p0 = positions[indices[t * 3]];
+			const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+			const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+			triangleNormals[t] = glm::cross(p1 - p0, p2 - p0);
+			triangleCentroids[t] = (p0 + p1 + p2) / 3.f;
+
+			float area = glm::length(triangleNormals[t]);
+			meshCentroid += triangleCentroids[t] * area;
+			meshArea += area;
+		}
+		if (meshArea > 0.f) meshCentroid /= meshArea;
+
+		struct Cluster
+		{
+			uint32_t first, end;
+			float facing;
+		};
+		std::vector<Cluster> clusters(clusterStarts.size());
+		for (size_t c = 0; c < clusterStarts.size(); c++) {
+			Cluster& cluster = clusters[c];
+			cluster.first = clusterStarts[c];
+			cluster.end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+
+			glm::vec3 centroid(0.f);
+			glm::vec3 normal(0.f);
+			float area = 0.f;
+			for (uint32_t t = cluster.first; t < cluster.end; t++) {
+				float triangleArea = glm::length(triangleNormals[t]);
+				centroid += triangleCentroids[t] * triangleArea;
+				normal += triangleNormals[t];
+				area += triangleArea;
+			}
+			float normalLength = glm::length(normal);
+			cluster.facing = area > 0.f && normalLength > 0.f ? glm::dot(centroid / area - meshCentroid, normal / normalLength) : 0.f;
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.facing > b.facing; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (const Cluster& cluster : clusters) {
+			result.insert(result.end(), indices.begin() + size_t(cluster.first) * 3, indices.begin() + size_t(cluster.end) * 3);
+		}
+		return result;
+	}
+}
+
+// =========================================================
+// MeshOptimizer
+// =========================================================
+namespace MeshOptimizer
+{
+	Statistics Analyze(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		Statistics statistics;
+		if (indices.size() < 3) return statistics;
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t time = CACHE_SIZE + 1;
+		uint32_t misses = 0;
+		uint32_t referencedCount = 0;
+		for (uint32_t index : indices) {
+			if (index >= vertexCount) continue;
+			if (time - cacheTime[index] > CACHE_SIZE) {
+				cacheTime[index] = time++;
+				misses++;
+			}
+			if (!referenced[index]) {
+				referenced[index] = true;
+				referencedCount++;
+			}
+		}
+
+		statistics.acmr = float(misses) / float(indices.size() / 3);
+		statistics.atvr = referencedCount > 0 ? float(misses) / float(referencedCount) : 0.f;
+		return statistics;
+	}
+
+	void Optimize(MeshResoruceInfo& info, const std::string& name)
+	{
+		if (info.storage || info.stride == 0 || info.indices.size() < 3 || info.indices.size() % 3 != 0) return;
+
+		const uint32_t vertexCount = uint32_t(info.vertexData.size() / info.stride);
+		for (uint32_t index : info.indices) {
+			if (index >= vertexCount) {
+				std::cerr << "MeshOptimizer: " << name << " has indices out of range, left unoptimized\n";
+				return;
+			}
+		}
+
+		Statistics before = Analyze(info.indices, vertexCount);
+
+		std::vector<uint32_t> clusterStarts;
+		info.indices = Tipsify(info.indices, vertexCount, clusterStarts);
+
+		std::vector<glm::vec3> positions = ReadPositions(info);
+		if (!positions.empty()) info.indices = SortClusters(info.indices, clusterStarts, positions);
+
+		CompactVertices(info);
+
+		Statistics after = Analyze(info.indices, uint32_t(info.vertexData.size() / info.stride));
+		std::cout << "  Optimized mesh " << name << ": ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << "\n";
+	}
+
+	std::vector<glm::vec3> ReadPositions(const MeshResoruceInfo& info)
+	{
+		std::vector<glm::vec3> positions;
+		if (info.stride == 0) return positions;
+		const uint32_t vertexCount = uint32_t(info.vertexData.size() / info.stride);
+
+		auto attribute = std::find_if(info.attributes.begin(), info.attributes.end(), [](const VertexAttribute& a) { return a.index == 0; });
+		if (attribute == info.attributes.end() || attribute->size < 3) return positions;
+
+		bool quantized = attribute->type == GL_UNSIGNED_SHORT && attribute->normalized;
+		if (attribute->type != GL_FLOAT && !quantized) return positions;
+
+		positions.resize(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			const uint8_t* source = info.vertexData.data() + size_t(v) * info.stride + attribute->offset;
+			if (quantized) {
+				uint16_t q[3];
+				std::memcpy(q, source, sizeof(q));
+				positions[v] = glm::vec3(info.positionDecode * glm::vec4(glm::vec3(q[0], q[1], q[2]) * (1.f / 65535.f), 1.f));
+			}
+			else {
+				std::memcpy(&positions[v], source, sizeof(glm::vec3));
+			}
+		}
+		return positions;
+	}
+
+	void CompactVertices(MeshResoruceInfo& info)
+	{
+		const uint32_t vertexCount = uint32_t(info.vertexData.size() / info.stride);
+		std::vector<uint32_t> remap(vertexCount, NO_VERTEX);
+		uint32_t next = 0;
+		for (uint32_t& index : info.indices) {
+			if (remap[index] == NO_VERTEX) remap[index] = next++;
+			index = remap[index];
+		}
+
+		std::vector<uint8_t> vertexData(size_t(next) * info.stride);
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			if (remap[v] == NO_VERTEX) continue;
+			std::memcpy(vertexData.data() + size_t(remap[v]) * info.stride, info.vertexData.data() + size_t(v) * info.stride, info.stride);
+		}
+		info.vertexData = std::move(vertexData);
+	}
+}
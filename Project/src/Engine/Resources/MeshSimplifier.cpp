@@ -0,0 +1,280 @@
+#include "Engine/Resources/MeshSimplifier.h"
+#include "Engine/Resources/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+#include <unordered_map>
+#include <iostream>
+
+namespace
+{
+	// sum of squared distances to a set of planes, as a symmetric 4x4 matrix
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+
+		void AddPlane(const glm::dvec3& n, double d)
+		{
+			a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z;
+			a11 += n.y * n.y; a12 += n.y * n.z; a22 += n.z * n.z;
+			b0 += n.x * d; b1 += n.y * d; b2 += n.z * d;
+			c += d * d;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02;
+			a11 += other.a11; a12 += other.a12; a22 += other.a22;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			return *this;
+		}
+
+		double Evaluate(const glm::vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			return a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z)
+				+ c;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from, to;
+		double cost;
+	};
+
+	// triangles using each vertex
+	void BuildAdjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices) offsets[index + 1]++;
+		for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+		triangles.resize(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) {
+			triangles[fill[indices[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+	}
+}
+
+// =========================================================
+// MeshSimplifier
+// =========================================================
+namespace MeshSimplifier
+{
+	std::vector<uint32_t> Simplify(const MeshResoruceInfo& info, size_t targetIndexCount, float maxError)
+	{
+		std::vector<uint32_t> indices = info.indices;
+		std::vector<glm::vec3> positions = MeshOptimizer::ReadPositions(info);
+		const uint32_t vertexCount = uint32_t(positions.size());
+		if (vertexCount == 0 || info.storage || indices.size() % 3 != 0) return indices;
+		for (uint32_t index : indices) {
+			if (index >= vertexCount) return indices;
+		}
+
+		// vertices at the same position (uv seams, hard edges) share an id, and are linked in a ring
+		std::vector<uint32_t> sorted(vertexCount);
+		std::iota(sorted.begin(), sorted.end(), 0u);
+		auto lessPosition = [&](uint32_t a, uint32_t b) {
+			const glm::vec3& pa = positions[a];
+			const glm::vec3& pb = positions[b];
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+			};
+		std::sort(sorted.begin(), sorted.end(), lessPosition);
+
+		std::vector<uint32_t> positionId(vertexCount);
+		std::vector<uint32_t> nextTwin(vertexCount);
+		for (size_t begin = 0; begin < sorted.size();) {
+			size_t end = begin + 1;
+			while (end < sorted.size() && positions[sorted[end]] == positions[sorted[begin]]) end++;
+			for (size_t i = begin; i < end; i++) {
+				positionId[sorted[i]] = sorted[begin];
+				nextTwin[sorted[i]] = sorted[i + 1 < end ? i + 1 : begin];
+			}
+			begin = end;
+		}
+
+		// every vertex starts with the planes of the triangles around it
+		std::vector<Quadric> quadrics(vertexCount);
+		glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+		for (const glm::vec3& p : positions) {
+			boundsMin = glm::min(boundsMin, p);
+			boundsMax = glm::max(boundsMax, p);
+		}
+		for (size_t t = 0; t < indices.size(); t += 3) {
+			glm::dvec3 p0 = positions[indices[t]], p1 = positions[indices[t + 1]], p2 = positions[indices[t + 2]];
+			glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+			double length = glm::length(normal);
+			if (length <= 0.0) continue;
+			normal /= length;
+			Quadric plane;
+			plane.AddPlane(normal, -glm::dot(normal, p0));
+			for (uint32_t k = 0; k < 3; k++) quadrics[positionId[indices[t + k]]] += plane;
+		}
+
+		const double diagonal = glm::length(boundsMax - boundsMin);
+		const double errorLimit = double(maxError) * diagonal * double(maxError) * diagonal;
+		const size_t targetTriangles = targetIndexCount / 3;
+
+		std::vector<uint32_t> offsets, adjacentTriangles;
+		std::vector<Collapse> collapses;
+		std::vector<std::pair<uint32_t, uint32_t>> pairs;
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+
+		// every pass collapses edges far enough apart to not affect each other, cheapest first
+		while (indices.size() / 3 > targetTriangles) {
+			BuildAdjacency(indices, vertexCount, offsets, adjacentTriangles);
+
+			// open borders and non-manifold edges stay where they are
+			std::vector<bool> locked(vertexCount, false);
+			edgeUses.clear();
+			for (size_t t = 0; t < indices.size(); t += 3) {
+				for (uint32_t k = 0; k < 3; k++) {
+					edgeUses[EdgeKey(positionId[indices[t + k]], positionId[indices[t + (k + 1) % 3]])]++;
+				}
+			}
+			for (const auto& [edge, uses] : edgeUses) {
+				if (uses == 2) continue;
+				locked[uint32_t(edge >> 32)] = true;
+				locked[uint32_t(edge & 0xFFFFFFFFu)] = true;
+			}
+
+			collapses.clear();
+			for (size_t t = 0; t < indices.size(); t += 3) {
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t a = indices[t + k];
+					uint32_t b = indices[t + (k + 1) % 3];
+					uint32_t pa = positionId[a], pb = positionId[b];
+					Quadric merged = quadrics[pa];
+					merged += quadrics[pb];
+					if (!locked[pa]) collapses.push_back({ a, b, merged.Evaluate(positions[b]) });
+					if (!locked[pb]) collapses.push_back({ b, a, merged.Evaluate(positions[a]) });
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			std::vector<bool> touched(vertexCount, false);
+			std::vector<uint32_t> remap(vertexCount);
+			std::iota(remap.begin(), remap.end(), 0u);
+			size_t triangles = indices.size() / 3;
+			size_t applied = 0;
+
+			for (const Collapse& collapse : collapses) {
+				if (triangles <= targetTriangles || collapse.cost > errorLimit) break;
+				uint32_t pa = positionId[collapse.from], pb = positionId[collapse.to];
+				if (touched[pa] || touched[pb]) continue;
+
+				// each twin of the collapsed vertex moves onto the twin of the target it shares an edge with,
+				// a seam vertex can only collapse along the seam
+				pairs.clear();
+				bool valid = true;
+				uint32_t twin = collapse.from;
+				do {
+					uint32_t target = UINT32_MAX;
+					for (uint32_t a = offsets[twin]; a < offsets[twin + 1] && target == UINT32_MAX; a++) {
+						const uint32_t* triangle = &indices[adjacentTriangles[a] * 3];
+						for (uint32_t k = 0; k < 3; k++) {
+							if (positionId[triangle[k]] == pb) target = triangle[k];
+						}
+					}
+					if (target == UINT32_MAX) valid = false;
+					pairs.emplace_back(twin, target);
+					twin = nextTwin[twin];
+				} while (valid && twin != collapse.from);
+				if (!valid) continue;
+
+				// the triangles that remain must not flip over
+				size_t removed = 0;
+				for (const auto& [from, to] : pairs) {
+					for (uint32_t a = offsets[from]; a < offsets[from + 1] && valid; a++) {
+						const uint32_t* triangle = &indices[adjacentTriangles[a] * 3];
+						if (positionId[triangle[0]] == pb || positionId[triangle[1]] == pb || positionId[triangle[2]] == pb) {
+							removed++;
+							continue;
+						}
+						glm::vec3 p[3], q[3];
+						for (uint32_t k = 0; k < 3; k++) {
+							p[k] = positions[triangle[k]];
+							q[k] = triangle[k] == from ? positions[to] : p[k];
+						}
+						glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+						glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+						if (glm::dot(before, after) <= 0.f) valid = false;
+					}
+				}
+				if (!valid) continue;
+
+				for (const auto& [from, to] : pairs) {
+					remap[from] = to;
+					for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+						const uint32_t* triangle = &indices[adjacentTriangles[a] * 3];
+						for (uint32_t k = 0; k < 3; k++) touched[positionId[triangle[k]]] = true;
+					}
+				}
+				quadrics[pb] += quadrics[pa];
+				triangles -= removed;
+				applied++;
+			}
+			if (applied == 0) break;
+
+			// drop the triangles that collapsed to a line
+			size_t write = 0;
+			for (size_t t = 0; t < indices.size(); t += 3) {
+				uint32_t i0 = remap[indices[t]], i1 = remap[indices[t + 1]], i2 = remap[indices[t + 2]];
+				if (positionId[i0] == positionId[i1] || positionId[i1] == positionId[i2] || positionId[i0] == positionId[i2]) continue;
+				indices[write++] = i0;
+				indices[write++] = i1;
+				indices[write++] = i2;
+			}
+			indices.resize(write);
+		}
+		return indices;
+	}
+
+	std::vector<MeshResoruceInfo> BuildLodChain(const MeshResoruceInfo& info, const std::string& name)
+	{
+		std::vector<MeshResoruceInfo> levels;
+		if (info.storage) return levels;
+
+		const float ratios[] = MESH_LOD_RATIOS;
+		size_t previousCount = info.indices.size();
+		for (size_t level = 1; level <= std::size(ratios) && level < MESH_MAX_LODS; level++) {
+			// coarser levels may stray further from the surface, they are seen from further away
+			size_t target = size_t(float(info.indices.size()) * ratios[level - 1]) / 3 * 3;
+			std::vector<uint32_t> indices = Simplify(info, target, MESH_LOD_MAX_ERROR * float(level));
+			if (indices.empty() || indices.size() * 5 > previousCount * 4) break;
+
+			MeshResoruceInfo& lod = levels.emplace_back();
+			lod.vertexData = info.vertexData;
+			lod.indices = std::move(indices);
+			lod.attributes = info.attributes;
+			lod.stride = info.stride;
+			lod.boundingBox = info.boundingBox;
+			lod.cullBackfaces = info.cullBackfaces;
+			lod.positionDecode = info.positionDecode;
+			MeshOptimizer::CompactVertices(lod);
+
+			std::string lodName = name + " lod" + std::to_string(level);
+#if MESH_OPTIMIZE_ON_IMPORT
+			MeshOptimizer::Optimize(lod, lodName);
+#endif
+			std::cout << "  Simplified " << lodName << ": " << info.indices.size() / 3 << " -> " << lod.indices.size() / 3 << " triangles\n";
+			previousCount = lod.indices.size();
+		}
+		return levels;
+	}
+}
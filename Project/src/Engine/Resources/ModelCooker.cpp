@@ -0,0 +1,225 @@
+#include "Engine/Resources/ModelCooker.h"
+#include "Engine/Resources/MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <iostream>
+
+// the mesh table follows the header and is read in place
+static_assert(sizeof(CookedModelHeader) % alignof(CookedMesh) == 0);
+
+namespace
+{
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + COOKED_MODEL_ALIGNMENT - 1) / COOKED_MODEL_ALIGNMENT * COOKED_MODEL_ALIGNMENT;
+	}
+
+	bool InBounds(uint64_t offset, uint64_t length, size_t fileSize)
+	{
+		return offset <= fileSize && length <= fileSize - offset;
+	}
+}
+
+// =========================================================
+// ModelCooker
+// =========================================================
+namespace ModelCooker
+{
+	std::string GetCookedPath(const std::string& modelFilePath)
+	{
+		return std::filesystem::path(modelFilePath).replace_extension(COOKED_MODEL_EXTENSION).string();
+	}
+
+	CookedFileStamp GetStamp(const std::string& path)
+	{
+		std::error_code error;
+		CookedFileStamp stamp;
+		uint64_t size = std::filesystem::file_size(path, error);
+		if (error) return stamp;
+		auto writeTime = std::filesystem::last_write_time(path, error);
+		if (error) return stamp;
+
+		stamp.size = size;
+		stamp.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+		return stamp;
+	}
+
+	CookedSourceStamps GetSourceStamps(const std::string& modelFilePath)
+	{
+		CookedSourceStamps stamps;
+		stamps.source = GetStamp(modelFilePath);
+		stamps.materials = GetStamp((std::filesystem::path(modelFilePath).parent_path() / "mat.json").string());
+		return stamps;
+	}
+
+	bool Write(const std::string& modelFilePath, const ModelImport& modelImport)
+	{
+		std::string materials = modelImport.materials.is_null() ? std::string() : modelImport.materials.dump();
+
+		// a mesh is followed by its LOD levels in the table
+		struct Entry
+		{
+			const std::string* name;
+			const MeshResoruceInfo* mesh;
+			uint32_t lodLevel;
+		};
+		std::vector<Entry> entries;
+		for (const ModelImport::ImportedMesh& mesh : modelImport.meshes) {
+			entries.push_back({ &mesh.name, &mesh.mesh, 0 });
+			for (size_t l = 0; l < mesh.lods.size(); ++l) {
+				entries.push_back({ &mesh.name, &mesh.lods[l], uint32_t(l + 1) });
+			}
+		}
+
+		CookedModelHeader header;
+		header.stamps = GetSourceStamps(modelFilePath);
+		header.meshCount = static_cast<uint32_t>(entries.size());
+		header.materialsLength = static_cast<uint32_t>(materials.size());
+
+		// lay out the names and the materials after the mesh table, then the aligned blobs
+		uint64_t offset = sizeof(CookedModelHeader) + sizeof(CookedMesh) * entries.size();
+		std::vector<CookedMesh> table(entries.size());
+		for (size_t i = 0; i < entries.size(); ++i) {
+			table[i].nameOffset = offset;
+			table[i].nameLength = static_cast<uint32_t>(entries[i].name->size());
+			offset += table[i].nameLength;
+		}
+		header.materialsOffset = offset;
+		offset += materials.size();
+
+		for (size_t i = 0; i < entries.size(); ++i) {
+			const MeshResoruceInfo& mesh = *entries[i].mesh;
+			CookedMesh& cooked = table[i];
+			if (mesh.attributes.size() > COOKED_MODEL_MAX_ATTRIBUTES) {
+				std::cerr << "ModelCooker: " << modelFilePath << " has more than " << COOKED_MODEL_MAX_ATTRIBUTES << " vertex attributes\n";
+				return false;
+			}
+
+			cooked.stride = mesh.stride;
+			cooked.vertexOffset = Align(offset);
+			cooked.vertexSize = mesh.vertexData.size();
+			cooked.indexOffset = Align(cooked.vertexOffset + cooked.vertexSize);
+			cooked.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			offset = cooked.indexOffset + cooked.indexCount * sizeof(uint32_t);
+
+			cooked.attributeCount = static_cast<uint32_t>(mesh.attributes.size());
+			for (size_t a = 0; a < mesh.attributes.size(); ++a) {
+				const VertexAttribute& attribute = mesh.attributes[a];
+				cooked.attributes[a] = { attribute.index, attribute.size, attribute.type, attribute.offset, attribute.normalized ? 1u : 0u };
+			}
+			std::memcpy(cooked.boundsMin, &mesh.boundingBox.min, sizeof(cooked.boundsMin));
+			std::memcpy(cooked.boundsMax, &mesh.boundingBox.max, sizeof(cooked.boundsMax));
+			std::memcpy(cooked.positionDecode, &mesh.positionDecode[0][0], sizeof(cooked.positionDecode));
+			cooked.cullBackfaces = mesh.cullBackfaces ? 1u : 0u;
+			cooked.lodLevel = entries[i].lodLevel;
+		}
+
+		std::vector<uint8_t> bytes(offset, 0);
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		if (!table.empty()) std::memcpy(bytes.data() + sizeof(header), table.data(), sizeof(CookedMesh) * table.size());
+		for (size_t i = 0; i < entries.size(); ++i) {
+			const MeshResoruceInfo& mesh = *entries[i].mesh;
+			std::memcpy(bytes.data() + table[i].nameOffset, entries[i].name->data(), entries[i].name->size());
+			std::memcpy(bytes.data() + table[i].vertexOffset, mesh.vertexData.data(), mesh.vertexData.size());
+			std::memcpy(bytes.data() + table[i].indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+		}
+		std::memcpy(bytes.data() + header.materialsOffset, materials.data(), materials.size());
+
+		// written next to it and renamed, so a reader never maps a half written file
+		std::string cookedPath = GetCookedPath(modelFilePath);
+		std::string temporaryPath = cookedPath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open() || !file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size())) {
+				std::cerr << "ModelCooker: could not write " << temporaryPath << "\n";
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, cookedPath, error);
+		if (error) {
+			std::cerr << "ModelCooker: could not write " << cookedPath << ": " << error.message() << "\n";
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool Read(const std::string& modelFilePath, ModelImport& out)
+	{
+		auto file = std::make_shared<MappedFile>();
+		if (!file->Open(GetCookedPath(modelFilePath))) return false;
+
+		const uint8_t* data = file->GetData();
+		size_t size = file->GetSize();
+		if (size < sizeof(CookedModelHeader)) return false;
+
+		CookedModelHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		if (header.magic != COOKED_MODEL_MAGIC || header.version != COOKED_MODEL_VERSION || header.importSettings != COOKED_MODEL_IMPORT_SETTINGS) return false;
+		if (!(header.stamps == GetSourceStamps(modelFilePath))) return false;
+
+		if (!InBounds(sizeof(CookedModelHeader), uint64_t(header.meshCount) * sizeof(CookedMesh), size)) return false;
+		if (!InBounds(header.materialsOffset, header.materialsLength, size)) return false;
+
+		ModelImport modelImport;
+		modelImport.meshes.reserve(header.meshCount);
+		const CookedMesh* table = reinterpret_cast<const CookedMesh*>(data + sizeof(CookedModelHeader));
+		for (uint32_t i = 0; i < header.meshCount; ++i) {
+			const CookedMesh& cooked = table[i];
+			if (!InBounds(cooked.nameOffset, cooked.nameLength, size) ||
+				!InBounds(cooked.vertexOffset, cooked.vertexSize, size) ||
+				!InBounds(cooked.indexOffset, uint64_t(cooked.indexCount) * sizeof(uint32_t), size) ||
+				cooked.indexOffset % alignof(uint32_t) != 0 ||
+				cooked.attributeCount > COOKED_MODEL_MAX_ATTRIBUTES || cooked.stride == 0) {
+				std::cerr << "ModelCooker: " << GetCookedPath(modelFilePath) << " is broken\n";
+				return false;
+			}
+
+			MeshResoruceInfo* info = nullptr;
+			if (cooked.lodLevel == 0) {
+				ModelImport::ImportedMesh& mesh = modelImport.meshes.emplace_back();
+				mesh.name.assign(reinterpret_cast<const char*>(data + cooked.nameOffset), cooked.nameLength);
+				info = &mesh.mesh;
+			}
+			else if (!modelImport.meshes.empty() && modelImport.meshes.back().lods.size() + 1 == cooked.lodLevel) {
+				info = &modelImport.meshes.back().lods.emplace_back();
+			}
+			else {
+				std::cerr << "ModelCooker: " << GetCookedPath(modelFilePath) << " is broken\n";
+				return false;
+			}
+
+			for (uint32_t a = 0; a < cooked.attributeCount; ++a) {
+				const CookedAttribute& attribute = cooked.attributes[a];
+				info->attributes.push_back({ attribute.index, attribute.size, attribute.type, attribute.offset, attribute.normalized != 0 });
+			}
+			info->stride = cooked.stride;
+			std::memcpy(&info->boundingBox.min, cooked.boundsMin, sizeof(cooked.boundsMin));
+			std::memcpy(&info->boundingBox.max, cooked.boundsMax, sizeof(cooked.boundsMax));
+			std::memcpy(&info->positionDecode[0][0], cooked.positionDecode, sizeof(cooked.positionDecode));
+			info->cullBackfaces = cooked.cullBackfaces != 0;
+
+			// the mesh keeps the mapping alive and uploads from it
+			info->storage = file;
+			info->storedVertexData = std::span<const uint8_t>(data + cooked.vertexOffset, cooked.vertexSize);
+			info->storedIndices = std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(data + cooked.indexOffset), cooked.indexCount);
+		}
+
+		if (header.materialsLength > 0) {
+			try {
+				modelImport.materials = nlohmann::json::parse(data + header.materialsOffset, data + header.materialsOffset + header.materialsLength);
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+		}
+
+		modelImport.valid = true;
+		out = std::move(modelImport);
+		return true;
+	}
+}
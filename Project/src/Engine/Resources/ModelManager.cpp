@@ -1,18 +1,101 @@
 #include "Engine/Resources/ModelManager.h"
 #include "Engine/Resources/ResourceManager.h"
+#include "Engine/Resources/ResourceLoader.h"
+#include "Engine/Resources/ModelCooker.h"
+#include "Engine/Resources/MeshOptimizer.h"
+#include "Engine/Resources/MeshSimplifier.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+
+#if MODEL_PACKED_VERTICES
+namespace
+{
+	// 16 bytes instead of 36, decoded by the vertex fetch
+	struct PackedModelVertex
+	{
+		uint16_t position[4];	// unorm in the bounding box of the mesh, w unused
+		uint32_t normal;		// snorm 10:10:10:2
+		uint32_t uv;			// two halfs
+	};
+
+	const std::vector<VertexAttribute> packedModelAttributes = {
+		{ 0, 3, GL_UNSIGNED_SHORT, offsetof(PackedModelVertex, position), GL_TRUE },
+		{ 1, 2, GL_HALF_FLOAT, offsetof(PackedModelVertex, uv), GL_FALSE },
+		{ 2, 4, GL_INT_2_10_10_10_REV, offsetof(PackedModelVertex, normal), GL_TRUE },
+	};
+
+	// maps positions of a mesh to [0, 1] in its bounding box
+	class PositionQuantization
+	{
+	public:
+		PositionQuantization(const BoundingBox& bbox) : min(bbox.min)
+		{
+			// flat meshes keep a nonzero scale so the decode stays invertible
+			extent = glm::max(bbox.max - bbox.min, glm::vec3(1e-4f));
+		}
+
+		PackedModelVertex Pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv) const
+		{
+			PackedModelVertex vertex{};
+			glm::vec3 unit = glm::clamp((position - min) / extent, 0.f, 1.f);
+			for (int c = 0; c < 3; c++) {
+				vertex.position[c] = static_cast<uint16_t>(unit[c] * 65535.f + 0.5f);
+			}
+			vertex.position[3] = 0;
+
+			// the inverse transpose of the decode scales by 1 / extent, pre-scaling keeps the lit normal unchanged
+			glm::vec3 scaledNormal = normal * extent;
+			float length = glm::length(scaledNormal);
+			scaledNormal = length > 0.f ? scaledNormal / length : glm::vec3(0.f);
+			vertex.normal = glm::packSnorm3x10_1x2(glm::vec4(scaledNormal, 0.f));
+			vertex.uv = glm::packHalf2x16(uv);
+			return vertex;
+		}
+
+		glm::mat4 GetDecode() const
+		{
+			return glm::scale(glm::translate(glm::mat4(1.f), min), extent);
+		}
+	private:
+		glm::vec3 min;
+		glm::vec3 extent;
+	};
+}
+#endif
 
 // =========================================================
 // ModelPolicy
 // =========================================================
 Model ModelPolicy::Create(const std::string& name, const ModelResourceInfo& resourceInfo)
 {
-	Model model;
+	return CreateFromImport(name, Import(resourceInfo));
+}
 
-	auto& _rm = ResourceManager::Get();
+ModelImport ModelPolicy::Import(const ModelResourceInfo& resourceInfo)
+{
+	ModelImport modelImport;
+	if (!ModelCooker::Read(resourceInfo.modelFilePath, modelImport)) {
+		std::cout << "  Cooking model: " << resourceInfo.modelFilePath << "\n";
+		modelImport = ImportSource(resourceInfo);
+		if (modelImport.valid) ModelCooker::Write(resourceInfo.modelFilePath, modelImport);
+	}
+	modelImport.filePath = resourceInfo.modelFilePath;
+
+	// the atlases are read here so only a stale cache costs time on the GL thread
+	if (modelImport.materials.is_object() && modelImport.materials.contains("impostorDistance")) {
+		ImpostorBaker::Read(resourceInfo.modelFilePath, modelImport.impostors);
+	}
+	return modelImport;
+}
+
+ModelImport ModelPolicy::ImportSource(const ModelResourceInfo& resourceInfo)
+{
+	ModelImport modelImport;
 
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(resourceInfo.modelFilePath,
@@ -32,14 +115,34 @@ Model ModelPolicy::Create(const std::string& name, const ModelResourceInfo& reso
 
 	if (!scene || !scene->HasMeshes()) {
 		std::cerr << "Failed to load model: " << resourceInfo.modelFilePath << "\n";
-		return model;
+		return modelImport;
 	}
 
-	model.meshEntries.reserve(scene->mNumMeshes);
+	modelImport.meshes.reserve(scene->mNumMeshes);
 
 	for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
 		aiMesh* ai_mesh = scene->mMeshes[i];
 
+		// Get bounding box
+		BoundingBox bbox;
+		aiVector3D min = ai_mesh->mAABB.mMin;
+		aiVector3D max = ai_mesh->mAABB.mMax;
+
+		if (flipYandZ) {
+			bbox.min = glm::vec3(min.x, -max.z, min.y);
+			bbox.max = glm::vec3(max.x, -min.z, max.y);
+		}
+		else {
+			bbox.min = glm::vec3(min.x, min.y, min.z);
+			bbox.max = glm::vec3(max.x, max.y, max.z);
+		}
+
+#if MODEL_PACKED_VERTICES
+		// positions in the bounding box, the decode matrix is folded into the instance matrices
+		PositionQuantization quantization(bbox);
+		using Vertex = PackedModelVertex;
+		std::vector<VertexAttribute> attributes = packedModelAttributes;
+#else
 		struct Vertex {
 			glm::vec4 position;
 			glm::vec2 uv;
@@ -51,50 +154,43 @@ Model ModelPolicy::Create(const std::string& name, const ModelResourceInfo& reso
 			{ 1, 2, GL_FLOAT, offsetof(Vertex, uv), GL_FALSE },
 			{ 2, 3, GL_FLOAT, offsetof(Vertex, normal), GL_FALSE },
 		};
+#endif
 
-		std::vector<Vertex> vertices;
+		// written straight into the buffer the mesh uploads
+		std::vector<uint8_t> vertexData(ai_mesh->mNumVertices * sizeof(Vertex));
 		for (unsigned int v = 0; v < ai_mesh->mNumVertices; ++v) {
-			Vertex vert{};
+			glm::vec3 position;
+			glm::vec3 normal(0.f);
+			glm::vec2 uv(0.f);
 			if (flipYandZ)
-				vert.position = glm::vec4(ai_mesh->mVertices[v].x, -ai_mesh->mVertices[v].z, ai_mesh->mVertices[v].y, 1.0f);
+				position = glm::vec3(ai_mesh->mVertices[v].x, -ai_mesh->mVertices[v].z, ai_mesh->mVertices[v].y);
 			else
-				vert.position = glm::vec4(ai_mesh->mVertices[v].x, ai_mesh->mVertices[v].y, ai_mesh->mVertices[v].z, 1.0f);
+				position = glm::vec3(ai_mesh->mVertices[v].x, ai_mesh->mVertices[v].y, ai_mesh->mVertices[v].z);
 			if (ai_mesh->HasNormals()) {
 				if (flipYandZ)
-					vert.normal = glm::vec3(ai_mesh->mNormals[v].x, -ai_mesh->mNormals[v].z, ai_mesh->mNormals[v].y);
+					normal = glm::vec3(ai_mesh->mNormals[v].x, -ai_mesh->mNormals[v].z, ai_mesh->mNormals[v].y);
 				else
-					vert.normal = glm::vec3(ai_mesh->mNormals[v].x, ai_mesh->mNormals[v].y, ai_mesh->mNormals[v].z);
+					normal = glm::vec3(ai_mesh->mNormals[v].x, ai_mesh->mNormals[v].y, ai_mesh->mNormals[v].z);
 			}
 			if (ai_mesh->HasTextureCoords(0))
-				vert.uv = glm::vec2(ai_mesh->mTextureCoords[0][v].x, ai_mesh->mTextureCoords[0][v].y);
-			vertices.push_back(vert);
+				uv = glm::vec2(ai_mesh->mTextureCoords[0][v].x, ai_mesh->mTextureCoords[0][v].y);
+
+#if MODEL_PACKED_VERTICES
+			Vertex vert = quantization.Pack(position, normal, uv);
+#else
+			Vertex vert{ glm::vec4(position, 1.0f), uv, normal };
+#endif
+			memcpy(vertexData.data() + v * sizeof(Vertex), &vert, sizeof(Vertex));
 		}
 
 		// Convert indices
 		std::vector<uint32_t> indices;
+		indices.reserve(ai_mesh->mNumFaces * 3);
 		for (unsigned int f = 0; f < ai_mesh->mNumFaces; ++f) {
 			aiFace face = ai_mesh->mFaces[f];
 			indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
 		}
 
-		// Flatten vertex buffer
-		std::vector<uint8_t> vertexData(vertices.size() * sizeof(Vertex));
-		memcpy(vertexData.data(), vertices.data(), vertexData.size());
-
-		// Get bounding box
-		BoundingBox bbox;
-		aiVector3D min = ai_mesh->mAABB.mMin;
-		aiVector3D max = ai_mesh->mAABB.mMax;
-
-		if (flipYandZ) {
-			bbox.min = glm::vec3(min.x, -max.z, min.y);
-			bbox.max = glm::vec3(max.x, -min.z, max.y);
-		}
-		else {
-			bbox.min = glm::vec3(min.x, min.y, min.z);
-			bbox.max = glm::vec3(max.x, max.y, max.z);
-		}
-
 		std::string meshName;
 		if (ai_mesh->mName.length > 0) {
 			meshName = ai_mesh->mName.C_Str();
@@ -102,23 +198,25 @@ Model ModelPolicy::Create(const std::string& name, const ModelResourceInfo& reso
 		else {
 			meshName = "mesh_" + std::to_string(i);
 		}
-		std::string managerName = name + "_" + meshName;
-		MeshManager::Handle meshHandle = _rm.meshes.Load(
-			managerName,
-			MeshResoruceInfo{
-				vertexData,
-				indices,
-				attributes,
-				sizeof(Vertex),
-				bbox,
-				true
-			});
-
-		Model::MeshEntry meshEntry;
-		meshEntry.name = meshName;
-		meshEntry.mesh = meshHandle;
-		model.meshEntries.push_back(meshEntry);
-		model.meshNameToIndex[meshName] = static_cast<uint32_t>(i);
+		ModelImport::ImportedMesh& importedMesh = modelImport.meshes.emplace_back();
+		importedMesh.name = meshName;
+		importedMesh.mesh = MeshResoruceInfo{
+				.vertexData = std::move(vertexData),
+				.indices = std::move(indices),
+				.attributes = attributes,
+				.stride = sizeof(Vertex),
+				.boundingBox = bbox,
+				.cullBackfaces = true
+			};
+#if MODEL_PACKED_VERTICES
+		importedMesh.mesh.positionDecode = quantization.GetDecode();
+#endif
+#if MESH_OPTIMIZE_ON_IMPORT
+		MeshOptimizer::Optimize(importedMesh.mesh, meshName);
+#endif
+#if MESH_LOD_ON_IMPORT
+		importedMesh.lods = MeshSimplifier::BuildLodChain(importedMesh.mesh, meshName);
+#endif
 	}
 
 	// try to load materials from JSON file
@@ -127,7 +225,61 @@ Model ModelPolicy::Create(const std::string& name, const ModelResourceInfo& reso
 	std::string materialFilePath2 = (parentDir / ("mat.json")).string();
 
 	if (std::filesystem::exists(materialFilePath2)) {
-		LoadMaterialsFromJSON(materialFilePath2, model);
+		std::ifstream file(materialFilePath2);
+		try {
+			file >> modelImport.materials;
+		}
+		catch (const std::exception&) {
+			std::cerr << "Failed to parse material JSON: " << materialFilePath2 << "\n";
+			modelImport.materials = nullptr;
+		}
+	}
+
+	modelImport.valid = true;
+	return modelImport;
+}
+
+Model ModelPolicy::CreateFromImport(const std::string& name, const ModelImport& modelImport)
+{
+	Model model;
+	if (!modelImport.valid) return model;
+
+	auto& _rm = ResourceManager::Get();
+
+	model.meshEntries.reserve(modelImport.meshes.size());
+	for (uint32_t i = 0; i < modelImport.meshes.size(); ++i) {
+		const ModelImport::ImportedMesh& importedMesh = modelImport.meshes[i];
+		std::string managerName = name + "_" + importedMesh.name;
+		MeshManager::Handle meshHandle = _rm.meshes.Load(managerName, importedMesh.mesh);
+
+		Model::MeshEntry meshEntry;
+		meshEntry.name = importedMesh.name;
+		meshEntry.mesh = meshHandle;
+
+		if (!importedMesh.lods.empty()) {
+			MeshLodChain chain;
+			chain.levels[0] = meshHandle;
+			chain.count = 1;
+			for (const MeshResoruceInfo& lod : importedMesh.lods) {
+				if (chain.count == MESH_MAX_LODS) break;
+				MeshManager::Handle lodHandle = _rm.meshes.Load(managerName + "_lod" + std::to_string(chain.count), lod);
+				meshEntry.lods.push_back(lodHandle);
+				chain.levels[chain.count++] = lodHandle;
+			}
+			_rm.meshes.SetLodChain(meshHandle, chain);
+		}
+		model.meshEntries.push_back(meshEntry);
+		model.meshNameToIndex[importedMesh.name] = i;
+	}
+
+	if (!modelImport.materials.is_null()) {
+		LoadMaterials(modelImport.materials, model);
+
+		// models opt into impostors with the distance past which their meshes are drawn as one
+		const nlohmann::json& materials = modelImport.materials;
+		if (materials.is_object() && materials.contains("impostorDistance") && materials["impostorDistance"].is_number()) {
+			LoadImpostors(name, modelImport, materials["impostorDistance"].get<float>(), model);
+		}
 	}
 
 	model.alive = true;
@@ -139,31 +291,18 @@ void ModelPolicy::Destroy(Model& res)
 	auto& _rm = ResourceManager::Get();
 	for (auto& meshEntry : res.meshEntries) {
 		_rm.meshes.Remove(meshEntry.mesh);
+		for (auto& lod : meshEntry.lods) {
+			_rm.meshes.Remove(lod);
+		}
 	}
 	res.meshEntries.clear();
 	res.alive = false;
 }
 
-void ModelPolicy::LoadMaterialsFromJSON(const std::string& JSONFilePath, Model& model)
+void ModelPolicy::LoadMaterials(const nlohmann::json& j, Model& model)
 {
 	MaterialManager& mm = ResourceManager::Get().materials;
 	MaterialPolicy& mp = mm.policy;
-	using json = nlohmann::json;
-
-	std::ifstream file(JSONFilePath);
-	if (!file.is_open()) {
-		std::cerr << "Failed to open material JSON: " << JSONFilePath << "\n";
-		return;
-	}
-
-	json j;
-	try {
-		file >> j;
-	}
-	catch (const std::exception&) {
-		std::cerr << "Failed to parse material JSON: " << JSONFilePath << "\n";
-		return;
-	}
 
 	std::unordered_map<std::string, MaterialManager::Handle> loadedMaterials;
 
@@ -173,7 +312,7 @@ void ModelPolicy::LoadMaterialsFromJSON(const std::string& JSONFilePath, Model&
 
 			if (!err.empty()) {
 				if (err != "MaterialExists") {
-					std::cerr << "ModelPolicy::LoadMaterialsFromJSON: Failed to create material from JSON entry: " << err << "\n";
+					std::cerr << "ModelPolicy::LoadMaterials: Failed to create material from JSON entry: " << err << "\n";
 					continue;
 				}
 				else {
@@ -201,7 +340,83 @@ void ModelPolicy::LoadMaterialsFromJSON(const std::string& JSONFilePath, Model&
 	}
 }
 
-void ModelManager::PreloadResources(const std::string& resourceDirectory)
+void ModelPolicy::LoadImpostors(const std::string& name, const ModelImport& modelImport, float distance, Model& model)
+{
+	auto& _rm = ResourceManager::Get();
+	MeshManager::Handle quad = _rm.meshes.GetHandle(IMPOSTOR_QUAD_MESH);
+	if (!quad.IsValid()) {
+		std::cerr << "ModelPolicy::LoadImpostors: " << IMPOSTOR_QUAD_MESH << " is not loaded\n";
+		return;
+	}
+
+	// the cache holds the atlases of every mesh in order, anything else is baked again
+	bool cached = modelImport.impostors.size() == model.meshEntries.size();
+	for (size_t i = 0; cached && i < model.meshEntries.size(); ++i) {
+		cached = modelImport.impostors[i].meshName == model.meshEntries[i].name;
+	}
+
+	std::vector<ImpostorAtlas> baked;
+	if (!cached) {
+		std::cout << "  Baking impostors: " << name << "\n";
+		baked.resize(model.meshEntries.size());
+		for (size_t i = 0; i < model.meshEntries.size(); ++i) {
+			const Model::MeshEntry& meshEntry = model.meshEntries[i];
+			const Mesh* mesh = _rm.meshes.Get(meshEntry.mesh);
+			baked[i].meshName = meshEntry.name;
+			if (!mesh || !ImpostorBaker::Bake(*mesh, _rm.materials.Get(meshEntry.material), baked[i])) {
+				std::cerr << "ModelPolicy::LoadImpostors: could not bake " << name << "_" << meshEntry.name << "\n";
+				return;
+			}
+		}
+		ImpostorBaker::Write(modelImport.filePath, baked);
+	}
+	const std::vector<ImpostorAtlas>& atlases = cached ? modelImport.impostors : baked;
+
+	for (size_t i = 0; i < model.meshEntries.size(); ++i) {
+		Model::MeshEntry& meshEntry = model.meshEntries[i];
+		const Mesh* mesh = _rm.meshes.Get(meshEntry.mesh);
+		if (!mesh) continue;
+
+		std::string impostorName = "impostors/" + name + "_" + meshEntry.name;
+		_rm.textures.LoadFromImage(impostorName + "_albedo", atlases[i].albedo);
+		_rm.textures.LoadFromImage(impostorName + "_normals", atlases[i].normals);
+		nlohmann::json material = {
+			{ "name", impostorName },
+			{ "shader", IMPOSTOR_SHADER },
+			{ "textures", { { "albedo", impostorName + "_albedo" }, { "normals", impostorName + "_normals" } } },
+		};
+		meshEntry.impostor = _rm.materials.LoadFromJSONObject(material, impostorName);
+		if (!meshEntry.impostor.IsValid()) continue;
+
+		// every LOD level switches to the impostor at the same distance
+		MeshImpostor impostor{ quad, meshEntry.impostor, ImpostorBaker::GetQuadFrame(mesh->boundingBox), distance };
+		_rm.meshes.SetImpostor(meshEntry.mesh, impostor);
+		for (const auto& lod : meshEntry.lods) {
+			_rm.meshes.SetImpostor(lod, impostor);
+		}
+	}
+}
+
+ModelManager::ModelHandle ModelManager::LoadFromImport(const std::string& name, const ModelImport& modelImport)
+{
+	if (Exists(name)) return GetHandle(name);
+	Model model = policy.CreateFromImport(name, modelImport);
+	return Register(name, model);
+}
+
+void ModelManager::CookModels(const std::string& resourceDirectory)
+{
+	ModelPolicy cookingPolicy;
+	std::filesystem::path fullDir = std::filesystem::path(resourceDirectory) / "models/";
+	for (const auto& entry : std::filesystem::directory_iterator(fullDir)) {
+		if (entry.is_directory()) {
+			std::string modelName = entry.path().filename().string();
+			cookingPolicy.Import(ModelResourceInfo{ (entry.path() / (modelName + ".glb")).string() });
+		}
+	}
+}
+
+void ModelManager::QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory)
 {
 	std::string shaderDir = "models/";
 
@@ -217,7 +432,12 @@ void ModelManager::PreloadResources(const std::string& resourceDirectory)
 				<< modelPath << ")\n";
 			ModelResourceInfo modelInfo;
 			modelInfo.modelFilePath = modelPath;
-			Load(modelName, modelInfo);
+
+			// Assimp imports on a loader thread, the meshes are uploaded once the materials are loaded
+			loader.Add(ResourceKind::Model, modelName, [this, modelName, modelInfo]() -> ResourceLoader::UploadFunction {
+				auto modelImport = std::make_shared<ModelImport>(policy.Import(modelInfo));
+				return [this, modelName, modelImport]() { LoadFromImport(modelName, *modelImport); };
+				});
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,143 @@
+#include "Engine/Resources/ResourceLoader.h"
+#include "Engine/Profiling/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+	// kinds whose uploads have to finish before uploads of the indexed kind start
+	constexpr uint32_t KindBit(ResourceKind kind) { return 1u << uint32_t(kind); }
+
+	constexpr uint32_t kindDependencies[size_t(ResourceKind::Count)] = {
+		0,																					// Shader
+		0,																					// Texture
+		KindBit(ResourceKind::Texture),														// TextureAtlas
+		0,																					// Mesh
+		KindBit(ResourceKind::Shader) | KindBit(ResourceKind::Texture) | KindBit(ResourceKind::TextureAtlas),	// Material
+		KindBit(ResourceKind::Material) | KindBit(ResourceKind::Mesh),						// Model
+	};
+}
+
+// =========================================================
+// ResourceLoader
+// =========================================================
+
+ResourceLoader::ResourceLoader(uint32_t threadCount) : threadCount(threadCount)
+{
+	if (this->threadCount == 0) {
+		// the main thread uploads
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		this->threadCount = std::clamp<uint32_t>(hardwareThreads > 1 ? hardwareThreads - 1 : 1, 1, RESOURCE_LOADER_MAX_THREADS);
+	}
+}
+
+ResourceLoader::~ResourceLoader()
+{
+	// jobs that are not prepared yet are skipped
+	nextPrepare.store(jobs.size());
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+void ResourceLoader::Add(ResourceKind kind, const std::string& name, PrepareFunction prepare)
+{
+	if (!threads.empty()) {
+		std::cerr << "ResourceLoader: " << name << " added after the loader started, skipped" << std::endl;
+		return;
+	}
+	jobs.push_back({ kind, name, std::move(prepare), nullptr });
+	pendingUploads[size_t(kind)]++;
+}
+
+void ResourceLoader::Start()
+{
+	uint32_t count = std::min<uint32_t>(threadCount, static_cast<uint32_t>(std::max<size_t>(jobs.size(), 1)));
+	threads.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		threads.emplace_back([this, i]() {
+			PROFILE_THREAD(Profiler::Get().Intern("Loader " + std::to_string(i)));
+			ThreadLoop();
+			});
+	}
+}
+
+void ResourceLoader::ThreadLoop()
+{
+	while (true) {
+		size_t index = nextPrepare.fetch_add(1);
+		if (index >= jobs.size()) return;
+
+		Job& job = jobs[index];
+		{
+			PROFILE_SCOPE_DYNAMIC("Prepare " + job.name);
+			try {
+				job.upload = job.prepare();
+			}
+			catch (const std::exception& e) {
+				std::cerr << "ResourceLoader: failed to prepare " << job.name << ": " << e.what() << std::endl;
+				job.upload = nullptr;
+			}
+			job.prepare = nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			prepared.push_back(index);
+		}
+		preparedCondition.notify_one();
+	}
+}
+
+bool ResourceLoader::DependenciesUploaded(ResourceKind kind) const
+{
+	uint32_t dependencies = kindDependencies[size_t(kind)];
+	for (size_t other = 0; other < size_t(ResourceKind::Count); ++other) {
+		if ((dependencies & (1u << other)) && pendingUploads[other] != 0) return false;
+	}
+	return true;
+}
+
+bool ResourceLoader::Pump(double budgetMs)
+{
+	using Clock = std::chrono::steady_clock;
+	bool budgeted = budgetMs >= 0.0;
+	auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budgeted ? budgetMs : 0.0));
+
+	while (!IsDone()) {
+		size_t index = SIZE_MAX;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (index == SIZE_MAX) {
+				auto it = std::find_if(prepared.begin(), prepared.end(), [this](size_t i) { return DependenciesUploaded(jobs[i].kind); });
+				if (it != prepared.end()) {
+					index = *it;
+					prepared.erase(it);
+				}
+				// every job left is either preparing or waiting on one that is
+				else if (!budgeted) {
+					preparedCondition.wait(lock);
+				}
+				else if (preparedCondition.wait_until(lock, deadline) == std::cv_status::timeout) {
+					return false;
+				}
+			}
+		}
+
+		Job& job = jobs[index];
+		if (job.upload) {
+			PROFILE_SCOPE_DYNAMIC("Upload " + job.name);
+			job.upload();
+		}
+		// frees the decoded data the upload held
+		job.upload = nullptr;
+
+		pendingUploads[size_t(job.kind)]--;
+		uploadedJobs++;
+
+		if (budgeted && Clock::now() >= deadline) break;
+	}
+	return IsDone();
+}
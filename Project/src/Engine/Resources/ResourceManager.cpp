@@ -1,33 +1,54 @@
 #include "Engine/Resources/ResourceManager.h"
 
 #include "Engine/Resources/MeshFactory.h"
+#include "Engine/Profiling/Profiler.h"
 
 ResourceManager& ResourceManager::Get() {
 	static ResourceManager instance;
 	return instance;
 }
 
-void ResourceManager::PreloadResources(const std::string& resourceDirectory) {
+void ResourceManager::BeginPreload(const std::string& resourceDirectory) {
+	PROFILE_SCOPE("BeginPreload");
+	loader = std::make_unique<ResourceLoader>();
+
 	std::cout << "Loading shaders:" << std::endl;
-	shaders.PreloadResources(resourceDirectory);
+	shaders.QueuePreload(*loader, resourceDirectory);
 	std::cout << "Loading textures:" << std::endl;
-	textures.PreloadResources(resourceDirectory);
+	textures.QueuePreload(*loader, resourceDirectory);
 
 	std::cout << "Loading primitive meshes:" << std::endl;
-	auto primitiveMeshes = MeshFactory::ObtainPrimitiveMeshes();
-	for (const auto& [name, mesh] : primitiveMeshes) {
-		std::cout << "  Loading primitive mesh: " << name << "\n";
-		if (name == "primitive/quad") {
-			Mesh& quadMesh = const_cast<Mesh&>(mesh);
-			quadMesh.isGuiMesh = true;
-		}
-		meshes.Register(name, const_cast<Mesh&>(mesh));
-	}
+	loader->Add(ResourceKind::Mesh, "primitive meshes", [this]() -> ResourceLoader::UploadFunction {
+		return [this]() {
+			auto primitiveMeshes = MeshFactory::ObtainPrimitiveMeshes();
+			for (const auto& [name, mesh] : primitiveMeshes) {
+				std::cout << "  Loading primitive mesh: " << name << "\n";
+				meshes.Register(name, const_cast<Mesh&>(mesh));
+			}
+			};
+		});
 
 	std::cout << "Loading materials:" << std::endl;
-	materials.PreloadResources(resourceDirectory);
+	materials.QueuePreload(*loader, resourceDirectory);
 	std::cout << "Loading models:" << std::endl;
-	models.PreloadResources(resourceDirectory);
+	models.QueuePreload(*loader, resourceDirectory);
+
+	loader->Start();
+}
+
+bool ResourceManager::PumpPreload(double budgetMs) {
+	if (!loader) return preloaded;
 
+	PROFILE_SCOPE("PumpPreload");
+	if (!loader->Pump(budgetMs)) return false;
+
+	loader.reset();
 	preloaded = true;
-}
\ No newline at end of file
+	return true;
+}
+
+void ResourceManager::PreloadResources(const std::string& resourceDirectory) {
+	PROFILE_SCOPE("PreloadResources");
+	BeginPreload(resourceDirectory);
+	PumpPreload(RESOURCE_LOADER_NO_BUDGET);
+}
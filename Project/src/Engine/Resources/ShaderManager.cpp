@@ -3,7 +3,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
 #include "Engine/Resources/ResourceManager.h"
+#include "Engine/Resources/ResourceLoader.h"
 
 #include "Engine/Renderer/GLStateCache.h"
 
@@ -37,8 +39,11 @@ void Shader::SetRaw(const std::string& name, GLenum GLtype, const void* data, si
         return;
 	}
 
-	auto loc = info.location;
+    SetRaw(info.location, GLtype, data, elementCount);
+}
 
+void Shader::SetRaw(GLint loc, GLenum GLtype, const void* data, size_t elementCount) const
+{
     Bind();
     // Dispatch based on type
     switch (GLtype){
@@ -398,24 +403,58 @@ void ShaderPolicy::ReflectUniformBlocks(GLuint program, ShaderReflection& out)
     }
 }
 
+void ShaderPolicy::ReflectStorageBlocks(GLuint program, ShaderReflection& out)
+{
+    // storage buffers are bound by the engine systems that own them (see MaterialTable), only their bindings are recorded
+    GLint blockCount = 0;
+    glGetProgramInterfaceiv(program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+
+    char nameBuffer[256];
+    const GLenum bindingProperty = GL_BUFFER_BINDING;
+
+    for (GLint blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+        GLsizei length = 0;
+        glGetProgramResourceName(program, GL_SHADER_STORAGE_BLOCK, blockIndex, sizeof(nameBuffer), &length, nameBuffer);
+
+        GLint binding = 0;
+        glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, blockIndex, 1, &bindingProperty, 1, nullptr, &binding);
+
+        out.storageBlocks[std::string(nameBuffer, length)] = static_cast<GLuint>(binding);
+    }
+}
+
 void ShaderPolicy::Reflect(GLuint program, ShaderReflection& out)
 {
     ReflectUniforms(program, out);
 	ReflectUniformBlocks(program, out);
+	ReflectStorageBlocks(program, out);
 }
 
 // --- Policy interface ---
 Shader ShaderPolicy::Create(const std::string& name, const ShaderResourceInfo& shaderInfo)
 {
-    std::string vsSrc = LoadFile(shaderInfo.vertexPath);
-    std::string fsSrc = LoadFile(shaderInfo.fragmentPath);
-    GLuint vs = Compile(GL_VERTEX_SHADER, vsSrc);
-    GLuint fs = Compile(GL_FRAGMENT_SHADER, fsSrc);
-	GLuint gs = 0;
+    return CreateFromSources(name, LoadSources(shaderInfo));
+}
 
+ShaderSources ShaderPolicy::LoadSources(const ShaderResourceInfo& shaderInfo)
+{
+    ShaderSources sources;
+    sources.vertex = LoadFile(shaderInfo.vertexPath);
+    sources.fragment = LoadFile(shaderInfo.fragmentPath);
     if (!shaderInfo.geometryPath.empty()) {
-		std::string gsSrc = LoadFile(shaderInfo.geometryPath);
-		gs = Compile(GL_GEOMETRY_SHADER, gsSrc);
+        sources.geometry = LoadFile(shaderInfo.geometryPath);
+    }
+    return sources;
+}
+
+Shader ShaderPolicy::CreateFromSources(const std::string& name, const ShaderSources& sources)
+{
+    GLuint vs = Compile(GL_VERTEX_SHADER, sources.vertex);
+    GLuint fs = Compile(GL_FRAGMENT_SHADER, sources.fragment);
+	GLuint gs = 0;
+
+    if (!sources.geometry.empty()) {
+		gs = Compile(GL_GEOMETRY_SHADER, sources.geometry);
     }
 
     GLuint program = LinkProgram(vs, fs, gs);
@@ -513,7 +552,14 @@ void ShaderManager::UseShader(const std::string& name, GLStateCache* glState) {
     }
 }
 
-void ShaderManager::PreloadResources(const std::string& resourceDirectory)
+ShaderManager::ShaderHandle ShaderManager::LoadFromSources(const std::string& name, const ShaderSources& sources)
+{
+    Shader shader = policy.CreateFromSources(name, sources);
+    return Register(name, shader);
+}
+
+// defs.glsl is read right away, the sources of every shader include it
+void ShaderManager::QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory)
 {
 	std::string shaderDir = "shaders/";
 
@@ -554,7 +600,10 @@ void ShaderManager::PreloadResources(const std::string& resourceDirectory)
             info.vertexPath = vertexPath;
             info.fragmentPath = fragmentPath;
 			info.geometryPath = geometryPath;
-            Load(shaderName, info);
+            loader.Add(ResourceKind::Shader, shaderName, [this, shaderName, info]() -> ResourceLoader::UploadFunction {
+                auto sources = std::make_shared<ShaderSources>(policy.LoadSources(info));
+                return [this, shaderName, sources]() { LoadFromSources(shaderName, *sources); };
+                });
         }
 	}
 }
\ No newline at end of file
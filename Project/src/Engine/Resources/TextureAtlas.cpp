@@ -0,0 +1,84 @@
+#include "Engine/Resources/TextureAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+// =========================================================
+// TextureAtlasPacker
+// =========================================================
+TextureAtlasPacker::TextureAtlasPacker(int size, int padding) : size(size), padding(padding)
+{
+}
+
+void TextureAtlasPacker::Add(const std::string& name, int width, int height, const uint8_t* rgba)
+{
+	Image image;
+	image.name = name;
+	image.width = width;
+	image.height = height;
+	image.rgba.assign(rgba, rgba + size_t(width) * height * 4);
+	images.push_back(std::move(image));
+}
+
+bool TextureAtlasPacker::Pack()
+{
+	std::sort(images.begin(), images.end(), [](const Image& a, const Image& b)
+		{
+			return a.height > b.height;
+		});
+
+	pixels.assign(size_t(size) * size * 4, 0);
+	regions.clear();
+
+	int cursorX = 0;
+	int cursorY = 0;
+	int shelfHeight = 0;
+	for (const Image& image : images)
+	{
+		int cellWidth = image.width + 2 * padding;
+		int cellHeight = image.height + 2 * padding;
+
+		// start a new shelf above the current one
+		if (cursorX + cellWidth > size)
+		{
+			cursorX = 0;
+			cursorY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (cursorX + cellWidth > size || cursorY + cellHeight > size)
+			return false;
+
+		Blit(image, cursorX + padding, cursorY + padding);
+		regions.push_back({ image.name, cursorX + padding, cursorY + padding, image.width, image.height });
+
+		cursorX += cellWidth;
+		shelfHeight = std::max(shelfHeight, cellHeight);
+	}
+
+	// the sources are no longer needed
+	images.clear();
+	images.shrink_to_fit();
+	return true;
+}
+
+glm::vec4 TextureAtlasPacker::GetUvRect(const Region& region) const
+{
+	float texel = 1.f / size;
+	return glm::vec4(region.x * texel, region.y * texel, region.width * texel, region.height * texel);
+}
+
+void TextureAtlasPacker::Blit(const Image& image, int x, int y)
+{
+	// the gutter repeats the nearest edge texel of the image
+	for (int row = -padding; row < image.height + padding; row++)
+	{
+		int sourceRow = std::clamp(row, 0, image.height - 1);
+		for (int column = -padding; column < image.width + padding; column++)
+		{
+			int sourceColumn = std::clamp(column, 0, image.width - 1);
+			const uint8_t* source = &image.rgba[(size_t(sourceRow) * image.width + sourceColumn) * 4];
+			uint8_t* target = &pixels[(size_t(y + row) * size + (x + column)) * 4];
+			std::memcpy(target, source, 4);
+		}
+	}
+}
@@ -1,23 +1,49 @@
 ﻿#include "Engine/Resources/TextureManager.h"
+#include "Engine/Resources/TextureAtlas.h"
+#include "Engine/Resources/ResourceLoader.h"
+
+#include <json.hpp>
+#include <fstream>
+#include <memory>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 // =========================================================
-// Texture
+// TextureImage
 // =========================================================
-bool Texture::LoadFromFile(const std::string& path, bool generateMipmaps)
+bool TextureImage::Decode(const std::string& path, int desiredChannels)
 {
-    stbi_set_flip_vertically_on_load(1);
+    // per thread, images are decoded on loader threads too
+    stbi_set_flip_vertically_on_load_thread(1);
 
-    int w = 0, h = 0, c = 0;
-    unsigned char* data = stbi_load(path.c_str(), &w, &h, &c, 0);
+    int c = 0;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &c, desiredChannels);
     if (!data)
         return false;
 
-    width = static_cast<uint16_t>(w);
-    height = static_cast<uint16_t>(h);
-    channels = static_cast<uint8_t>(c);
+    channels = desiredChannels != 0 ? desiredChannels : c;
+    pixels.assign(data, data + size_t(width) * height * channels);
+    stbi_image_free(data);
+    return true;
+}
+
+// =========================================================
+// Texture
+// =========================================================
+bool Texture::LoadFromFile(const std::string& path, bool generateMipmaps)
+{
+    TextureImage image;
+    if (!image.Decode(path))
+        return false;
+    return LoadFromImage(image, generateMipmaps);
+}
+
+bool Texture::LoadFromImage(const TextureImage& image, bool generateMipmaps)
+{
+    width = static_cast<uint16_t>(image.width);
+    height = static_cast<uint16_t>(image.height);
+    channels = static_cast<uint8_t>(image.channels);
 
     GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
 
@@ -36,7 +62,7 @@ bool Texture::LoadFromFile(const std::string& path, bool generateMipmaps)
     glBindTexture(GL_TEXTURE_2D, id);
 
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0,
-        format, GL_UNSIGNED_BYTE, data);
+        format, GL_UNSIGNED_BYTE, image.pixels.data());
 
     if (generateMipmaps)
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -51,7 +77,6 @@ bool Texture::LoadFromFile(const std::string& path, bool generateMipmaps)
     glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(prevBinding));
     glActiveTexture(static_cast<GLenum>(prevActive));
 
-    stbi_image_free(data);
     return true;
 }
 
@@ -205,7 +230,9 @@ void TexturePolicy::Destroy(Texture& texture)
 // =========================================================
 TextureManager::TextureManager()
 {
-    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+    // without a GL context (headless tools) there are no units to track
+    if (glGetIntegerv)
+        glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
     unitToHandle.resize(maxUnits);
 }
 
@@ -236,6 +263,19 @@ TextureManager::TextureHandle TextureManager::CreateEmptyTexture2D(const std::st
     return Register(name, tex);
 }
 
+TextureManager::TextureHandle TextureManager::LoadFromImage(const std::string& name, const TextureImage& image, bool generateMipmaps)
+{
+    Texture tex;
+    if (!tex.LoadFromImage(image, generateMipmaps))
+    {
+        std::cerr << "Failed to upload texture: " << name << "\n";
+        return {};
+    }
+
+    tex.alive = true;
+    return Register(name, tex);
+}
+
 TextureManager::TextureHandle TextureManager::CreateDepthTexture2D(const std::string& name,
     int width, int height,
     GLenum depthInternalFormat)
@@ -405,7 +445,7 @@ void TextureManager::UnbindFromUnit(int unit, bool bindToUnit)
 }
 
 // --- Preloading ---
-void TextureManager::PreloadResources(const std::string& resourceDirectory)
+void TextureManager::QueuePreload(ResourceLoader& loader, const std::string& resourceDirectory)
 {
 	std::string texturesDir = "textures/";
     std::filesystem::path fullDir = std::filesystem::path(resourceDirectory) / texturesDir;
@@ -413,27 +453,108 @@ void TextureManager::PreloadResources(const std::string& resourceDirectory)
 	// Iterate recursively over files in the textures directory
 	// name will be relative path from texturesDir
     for (const auto& entry : std::filesystem::recursive_directory_iterator(fullDir)) {
-        if (entry.is_regular_file()) {
+        if (entry.is_regular_file() && entry.path().filename() != TEXTURE_ATLAS_MANIFEST) {
             std::string fullPath = entry.path().string();
             std::string relativePath = std::filesystem::relative(entry.path(), fullDir).string();
-            TextureResourceInfo tri;
             std::cout << "Loading texture: " << relativePath << "\n";
-            tri.path = fullPath;
-            tri.generateMipmaps = true;
-            if (relativePath == "font.png") {
-				tri.generateMipmaps = false;
-				Load(relativePath, tri);
-				tri.generateMipmaps = true;
-                continue;
-            }
-			Load(relativePath, tri);
+            bool generateMipmaps = relativePath != "font.png";
+
+            loader.Add(ResourceKind::Texture, relativePath, [this, fullPath, relativePath, generateMipmaps]() -> ResourceLoader::UploadFunction {
+                auto image = std::make_shared<TextureImage>();
+                if (!image->Decode(fullPath)) {
+                    std::cerr << "Failed to load texture: " << fullPath << " for resource " << relativePath << std::endl;
+                    return nullptr;
+                }
+                return [this, image, relativePath, generateMipmaps]() { LoadFromImage(relativePath, *image, generateMipmaps); };
+                });
         }
 	}
 
+    QueueAtlases(loader, fullDir);
+
 	// create the textures for shadow maps
 # define SHADOW_MAP_SIZE 2048
 # define SHADOW_CASCADE_COUNT 6
-	CreateDepthCubemap("shadow/point", SHADOW_MAP_SIZE, GL_DEPTH_COMPONENT32F);
-	std::string shadowDirPrefix = "shadow/dir";
-	CreateDepthTexture2DArray(shadowDirPrefix, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT, GL_DEPTH_COMPONENT32F);
-}
\ No newline at end of file
+    loader.Add(ResourceKind::Texture, "shadow maps", [this]() -> ResourceLoader::UploadFunction {
+        return [this]() {
+            CreateDepthCubemap("shadow/point", SHADOW_MAP_SIZE, GL_DEPTH_COMPONENT32F);
+            std::string shadowDirPrefix = "shadow/dir";
+            CreateDepthTexture2DArray(shadowDirPrefix, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT, GL_DEPTH_COMPONENT32F);
+            // static casters only, copied into the maps above every frame
+            CreateDepthCubemap("shadow/pointStatic", SHADOW_MAP_SIZE, GL_DEPTH_COMPONENT32F);
+            CreateDepthTexture2DArray("shadow/dirStatic", SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT, GL_DEPTH_COMPONENT32F);
+            };
+        });
+}
+
+// --- Atlases ---
+void TextureManager::QueueAtlases(ResourceLoader& loader, const std::filesystem::path& texturesDirectory)
+{
+    std::ifstream file(texturesDirectory / TEXTURE_ATLAS_MANIFEST);
+    if (!file.is_open())
+        return;
+
+    nlohmann::json manifest;
+    try {
+        file >> manifest;
+    }
+    catch (const std::exception&) {
+        std::cerr << "Failed to parse texture atlas manifest\n";
+        return;
+    }
+
+    for (const auto& atlasJson : manifest.value("atlases", nlohmann::json::array())) {
+        std::string atlasName = "atlas/" + atlasJson.value("name", std::string("default"));
+        int size = atlasJson.value("size", 1024);
+        int padding = atlasJson.value("padding", 2);
+        std::vector<std::string> textureNames = atlasJson.value("textures", std::vector<std::string>{});
+
+        loader.Add(ResourceKind::TextureAtlas, atlasName, [this, texturesDirectory, atlasName, size, padding, textureNames]() -> ResourceLoader::UploadFunction {
+            auto packer = std::make_shared<TextureAtlasPacker>(size, padding);
+            for (const std::string& textureName : textureNames) {
+                // decoded again as RGBA, the loaded texture keeps the file's channels
+                TextureImage image;
+                std::string path = (texturesDirectory / textureName).string();
+                if (!image.Decode(path, 4)) {
+                    std::cerr << "Texture atlas " << atlasName << ": failed to load " << path << "\n";
+                    continue;
+                }
+                packer->Add(textureName, image.width, image.height, image.pixels.data());
+            }
+
+            if (!packer->Pack()) {
+                std::cerr << "Texture atlas " << atlasName << ": textures do not fit into " << size << "x" << size << "\n";
+                return nullptr;
+            }
+            return [this, packer, atlasName]() { UploadAtlas(atlasName, *packer); };
+            });
+    }
+}
+
+void TextureManager::UploadAtlas(const std::string& atlasName, const TextureAtlasPacker& packer)
+{
+    // no mipmaps, the gutters only protect neighbours at full resolution
+    Texture atlas;
+    atlas.CreateEmpty2D(packer.GetSize(), packer.GetSize(), GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+        GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    atlas.channels = 4;
+    glBindTexture(GL_TEXTURE_2D, atlas.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, packer.GetSize(), packer.GetSize(), GL_RGBA, GL_UNSIGNED_BYTE, packer.GetPixels().data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    atlas.alive = true;
+
+    std::cout << "Packed " << packer.GetRegions().size() << " textures into " << atlasName << "\n";
+    TextureHandle atlasHandle = Register(atlasName, atlas);
+
+    for (const TextureAtlasPacker::Region& packed : packer.GetRegions()) {
+        TextureHandle source = GetHandle(packed.name);
+        if (!source.IsValid()) {
+            std::cerr << "Texture atlas " << atlasName << ": unknown texture " << packed.name << "\n";
+            continue;
+        }
+        if (source.id >= regions.size()) regions.resize(source.id + 1);
+        regions[source.id] = Region{ atlasHandle, packer.GetUvRect(packed) };
+    }
+}
@@ -48,11 +48,11 @@ void UboPolicy::Destroy(Ubo& res)
 // UboManager
 // ==========================================================
 const std::vector<std::string> UboManager::globalUboNames = {
-	"Shadow",
-	"Lighting",
-	"Camera",
-	"GUICamera",
-	"Time"
+	GlobalUbo::Shadow.name,
+	GlobalUbo::Lighting.name,
+	GlobalUbo::Camera.name,
+	GlobalUbo::GUICamera.name,
+	GlobalUbo::Time.name
 };
 
 UboManager::UboManager()
@@ -78,7 +78,14 @@ UboManager::UboHandle UboManager::CreateOrGet(const UniformBlockInfo& blockInfo)
 	UboManager::UboHandle uboHandle = Load(blockInfo.name, resourceInfo);
 
 	// Create corresponding UboWriter
-	uboWriters.emplace(blockInfo.name, UboWriter(Get(uboHandle)));
+	auto [writerIt, inserted] = uboWriters.emplace(blockInfo.name, UboWriter(Get(uboHandle)));
+
+	uint32_t hash = HashName(blockInfo.name);
+	for (const auto& [otherHash, writer] : writersByHash) {
+		if (otherHash == hash)
+			std::cerr << "UboManager: name hash of UBO " << blockInfo.name << " collides with " << writer->GetUboInfo()->name << std::endl;
+	}
+	writersByHash.emplace_back(hash, &writerIt->second);
 
 	return uboHandle;
 }
@@ -91,6 +98,15 @@ UboWriter* UboManager::GetUboWriter(const std::string& uboName)
 	return &it->second;
 }
 
+UboWriter* UboManager::GetUboWriter(const UboName& uboName)
+{
+	for (const auto& [hash, writer] : writersByHash) {
+		if (hash == uboName.hash)
+			return writer;
+	}
+	return nullptr;
+}
+
 GLuint UboManager::GetAndUseNextBindingPoint()
 {
 	return nextBindingPoint++;
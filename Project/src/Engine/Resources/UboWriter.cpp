@@ -4,6 +4,30 @@ UboWriter::UboWriter(const UniformBlockInfo* uboInfo)
 	: ubo(uboInfo)
 {
 	data.assign(ubo->dataSize, 0);
+
+	fieldHashes.reserve(ubo->fields.size());
+	for (const auto& field : ubo->fields)
+		fieldHashes.push_back(HashName(field.name));
+}
+
+UniformHandle UboWriter::GetFieldHandle(const std::string& memberName) const
+{
+	for (size_t i = 0; i < ubo->fields.size(); i++)
+	{
+		if (ubo->fields[i].name == memberName)
+			return { static_cast<uint32_t>(i) };
+	}
+	return {};
+}
+
+UniformHandle UboWriter::GetFieldHandle(uint32_t nameHash) const
+{
+	for (size_t i = 0; i < fieldHashes.size(); i++)
+	{
+		if (fieldHashes[i] == nameHash)
+			return { static_cast<uint32_t>(i) };
+	}
+	return {};
 }
 
 void UboWriter::Upload()
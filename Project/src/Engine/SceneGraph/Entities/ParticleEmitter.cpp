@@ -4,12 +4,14 @@
 
 glm::vec3 RandomDirectionInCone(
     const glm::vec3& dir,
-    float angleDegrees)
+    float angleDegrees,
+    std::minstd_rand& rng)
 {
     float angleRad = glm::radians(angleDegrees);
 
-    float u = (float)rand() / RAND_MAX;
-    float v = (float)rand() / RAND_MAX;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float u = unit(rng);
+    float v = unit(rng);
 
     float theta = u * glm::two_pi<float>();
     float phi = acos(1.0f - v * (1.0f - cos(angleRad)));
@@ -37,7 +39,7 @@ glm::vec3 RandomDirectionInCone(
 // ================================================================
 
 ParticleEmitter::ParticleEmitter(const std::string& name)
-	: Entity(name), RenderEntity(name), TransformEntity(name)
+	: Entity(name), RenderEntity(name), TransformEntity(name), rng(static_cast<unsigned int>(rand()))
 {
 	renderableProvider = new MeshRenderableProvider();
 }
@@ -49,7 +51,7 @@ void ParticleEmitter::EmitParticle()
 
     ParticleInstanceData p;
     p.position = glm::vec3(0.0f);
-    p.velocity = RandomDirectionInCone(direction, spreadAngle) * particleSpeed;
+    p.velocity = RandomDirectionInCone(direction, spreadAngle, rng) * particleSpeed;
     p.lifetime = p.maxLifetime = particleLifetime;
 
     particles.push_back(p);
@@ -71,12 +73,15 @@ void ParticleEmitter::ProvideRenderables(std::vector<Renderable>& outRenderables
         particleTemplate = outRenderables.back();
         templateInitialized = true;
 		particleTemplate.layer = RenderLayer::Transparent;
+		particleTemplate.billboard = true;
 	}
     outRenderables.clear();
 }
 
-void ParticleEmitter::UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables)
+bool ParticleEmitter::UpdateRenderables(double deltaTime, std::vector<Renderable>& renderables)
 {
+    bool hadParticles = !renderables.empty();
+
     if (isEmitting) {
         emissionAccumulator += emissionRate * (float)deltaTime;
 
@@ -121,6 +126,7 @@ void ParticleEmitter::UpdateRenderables(double deltaTime, std::vector<Renderable
         }
 
     } 
+    return hadParticles || !renderables.empty();
 }
 
 void ParticleEmitter::UpdateTransform(const glm::mat4& newTransform)
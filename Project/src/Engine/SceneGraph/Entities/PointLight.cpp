@@ -0,0 +1,11 @@
+#include "Engine/SceneGraph/Entities/PointLight.h"
+
+// ======================================================
+// PointLight
+// ======================================================
+
+PointLight::PointLight(const std::string& name)
+	: Entity(name), TransformEntity(name)
+{
+	pointLightComponent = &AddComponent<PointLightComponent>();
+}
@@ -16,7 +16,7 @@ RenderEntity::RenderEntity(const std::string& name)
 		};
 	renderableComponent->RenderableUpdater = 
 		[this](double deltaTime, std::vector<Renderable>& renderables) {
-			this->UpdateRenderables(deltaTime, renderables);
+			return this->UpdateRenderables(deltaTime, renderables);
 		};
 
 	renderableComponent->OnTransformUpdated = 
@@ -4,6 +4,7 @@
 #include "Engine/SceneGraph/Systems/Includes.h"
 
 #include "Engine/DataStructures/TransformFunctions.h"
+#include "Engine/Profiling/Profiler.h"
 
 #include <stack>
 #include <iostream>
@@ -53,8 +54,13 @@ void Scene::Init(EngineServices services)
 
 void Scene::Update(double deltaTime)
 {
-    OnUpdate(deltaTime);
+    PROFILE_SCOPE("Scene::Update");
+    {
+        PROFILE_SCOPE("Scene::OnUpdate");
+        OnUpdate(deltaTime);
+    }
     for (auto& systemPair : systemOrder) {
+        PROFILE_SCOPE_DYNAMIC(systemPair->GetName());
         systemPair->OnUpdate(deltaTime);
     }
 }
@@ -433,7 +439,7 @@ void Scene::SetupInternalEntities()
 void Scene::SetupDefaultSystems(EngineServices services)
 {
 	AddSystem<PhysicsSystem>(10, &registry);
-	AddSystem<CollisionSystem>(20, &registry);
+	AddSystem<CollisionSystem>(20, &registry, services.renderer);
 	AddSystem<TransformSystem>(50, &registry);
     AddSystem<UITransformSystem>(51, &registry);
     AddSystem<RenderSystem>(100, services.renderer, &registry);
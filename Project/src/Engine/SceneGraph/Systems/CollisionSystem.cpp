@@ -5,12 +5,14 @@
 
 #include "Engine/SceneGraph/Entities/TransformEntity.h"
 
+#include "Engine/Renderer/Renderer.h"
+
 // ======================================================
 // CollisionSystem
 // ======================================================
 
-CollisionSystem::CollisionSystem(Scene* scene, int16_t order, entt::registry* registry)
-	: ISystem(scene, order), registry(registry)
+CollisionSystem::CollisionSystem(Scene* scene, int16_t order, entt::registry* registry, Renderer* renderer)
+	: ISystem(scene, order), registry(registry), renderer(renderer)
 {
 	runOnStartup = true;
 }
@@ -19,6 +21,7 @@ void CollisionSystem::OnUpdate(double deltaTime)
 {
 	BroadPhase();
 	NarrowPhase();
+	DrawContacts();
 	ResolveContacts(deltaTime);
 }
 
@@ -194,6 +197,16 @@ void CollisionSystem::NarrowPhase() {
 	}
 }
 
+void CollisionSystem::DrawContacts() {
+	if (!renderer) return;
+	DebugDraw& debugDraw = renderer->GetDebugDraw();
+	if (!debugDraw.IsEnabled()) return;
+
+	for (auto& c : contacts) {
+		debugDraw.AddNormal(c.point, c.normal, 1.0f + c.penetration, glm::vec3(1.0f, 0.2f, 0.2f));
+	}
+}
+
 void CollisionSystem::ResolveContacts(double deltaTime) {
 	auto* trans = GetSystem<TransformSystem>();
 
@@ -22,6 +22,20 @@ RenderSystem::RenderSystem(Scene* scene, int16_t order, Renderer* renderer, entt
 	else {
 		throw std::runtime_error("RenderSystem: No Light entity found in the scene.");
 	}
+
+	// proxies outlive their component otherwise
+	registry->on_destroy<RenderableComponent>().connect<&RenderSystem::OnRenderableDestroyed>(this);
+}
+
+RenderSystem::~RenderSystem()
+{
+	registry->on_destroy<RenderableComponent>().disconnect(this);
+
+	auto view = registry->view<RenderableComponent>();
+	for (auto entity : view)
+	{
+		RemoveProxies(view.get<RenderableComponent>(entity));
+	}
 }
 
 void RenderSystem::OnUpdate(double deltaTime)
@@ -38,16 +52,94 @@ void RenderSystem::OnUpdate(double deltaTime)
 		lightComponent->dirty = false;
 	}
 
+	// point lights are handed over every frame, they are binned by the render thread
+	auto lights = registry->view<PointLightComponent, TransformComponent>();
+	for (auto entity : lights)
+	{
+		const auto& light = lights.get<PointLightComponent>(entity);
+		const auto& transform = lights.get<TransformComponent>(entity);
+
+		PointLightData data;
+		data.positionRadius = glm::vec4(glm::vec3(transform.worldMatrix[3]), light.radius);
+		data.colorIntensity = glm::vec4(light.color, light.intensity);
+		renderer->Submit(data);
+	}
+
 	// Get RenderableComponents
 	auto view = registry->view<RenderableComponent>();
 
-	// Update each renderableComponent and submit to renderer
+	extractList.clear();
 	for (auto entity : view)
 	{
-		auto& renderableC = view.get<RenderableComponent>(entity);
-		renderableC.UpdateRenderables(deltaTime);
-		renderer->Submit(renderableC.GetRenderables());
+		extractList.push_back(&view.get<RenderableComponent>(entity));
+	}
+
+	// updaters only touch their own entity's renderables, so they run on the workers
+	renderer->GetWorkerPool().ParallelFor(extractList.size(), RENDER_SYSTEM_EXTRACT_CHUNK, [this, deltaTime](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			extractList[i]->UpdateRenderables(deltaTime);
+		}
+		});
+
+	// generating renderables may create resources and the render world is shared, so syncing stays serial and in view order
+	for (auto* renderableC : extractList)
+	{
+		SyncProxies(*renderableC);
+	}
+}
+
+void RenderSystem::SyncProxies(RenderableComponent& renderableC)
+{
+	const auto& renderables = renderableC.GetRenderables();
+	auto& proxies = renderableC.proxies;
+
+	// nothing changed, the proxies are still up to date
+	if (!renderableC.propertiesDirty && !renderableC.transformDirty && proxies.size() == renderables.size()) {
+		return;
+	}
+
+	RenderWorld& world = renderer->GetRenderWorld();
+
+	size_t common = std::min(proxies.size(), renderables.size());
+	for (size_t i = 0; i < common; ++i)
+	{
+		if (renderableC.propertiesDirty) {
+			world.Update(proxies[i], renderables[i]);
+		}
+		else {
+			world.UpdateTransform(proxies[i], renderables[i].modelMatrix);
+		}
+	}
+
+	// renderables are only ever compared by index, so the count change is applied at the end
+	for (size_t i = common; i < renderables.size(); ++i)
+	{
+		proxies.push_back(world.Add(renderables[i]));
+	}
+	while (proxies.size() > renderables.size())
+	{
+		world.Remove(proxies.back());
+		proxies.pop_back();
+	}
+
+	renderableC.propertiesDirty = false;
+	renderableC.transformDirty = false;
+}
+
+void RenderSystem::RemoveProxies(RenderableComponent& renderableC)
+{
+	RenderWorld& world = renderer->GetRenderWorld();
+	for (auto handle : renderableC.proxies)
+	{
+		world.Remove(handle);
 	}
+	renderableC.proxies.clear();
+}
+
+void RenderSystem::OnRenderableDestroyed(entt::registry& registry, entt::entity entity)
+{
+	RemoveProxies(registry.get<RenderableComponent>(entity));
 }
 
 void RenderSystem::UpdateTargetCamera(glm::vec3 targetPosition)